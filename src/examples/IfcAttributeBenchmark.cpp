@@ -0,0 +1,150 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Compares the throughput of looking up attributes by name for every           *
+ * attribute of every entity in the IFC4 schema: copying the attributes of the  *
+ * entity and its supertypes and comparing names, as previously done by         *
+ * IfcBaseEntity::get(), versus the name index of IfcParse::entity and an       *
+ * IfcParse::attribute_handle.                                                  *
+ *                                                                              *
+ * Usage: IfcAttributeBenchmark [repetitions]                                   *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "../ifcparse/IfcBaseClass.h"
+#include "../ifcparse/IfcSchema.h"
+#include "stopwatch.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+	std::vector<const IfcParse::attribute*> copy_attributes(const IfcParse::entity* entity) {
+		std::vector<const IfcParse::attribute*> attrs;
+		if (entity->supertype() != nullptr) {
+			attrs = copy_attributes(entity->supertype());
+		}
+		attrs.insert(attrs.end(), entity->attributes().begin(), entity->attributes().end());
+		return attrs;
+	}
+
+	ptrdiff_t linear_attribute_index(const IfcParse::entity* entity, const std::string& name) {
+		const auto attrs = copy_attributes(entity);
+		for (size_t i = 0; i < attrs.size(); ++i) {
+			if (attrs[i]->name() == name) {
+				return i;
+			}
+		}
+		return -1;
+	}
+}
+
+int main(int argc, char** argv) {
+	const int repetitions = argc > 1 ? std::stoi(argv[1]) : 100;
+
+	const IfcParse::schema_definition* schema = IfcParse::schema_by_name("IFC4");
+
+	// Every attribute name of every entity, and a blank instance of every
+	// non-abstract entity to read the attributes from
+	std::vector<std::pair<const IfcParse::entity*, std::string>> lookups;
+	std::vector<std::unique_ptr<IfcUtil::IfcBaseClass>> instances;
+	std::vector<std::pair<IfcUtil::IfcBaseEntity*, std::string>> gets;
+
+	for (const auto* entity : schema->entities()) {
+		IfcUtil::IfcBaseEntity* instance = nullptr;
+		if (!entity->is_abstract()) {
+			instances.emplace_back(schema->instantiate(entity, IfcEntityInstanceData(storage_t(entity->attribute_count()))));
+			instance = instances.back()->as<IfcUtil::IfcBaseEntity>();
+		}
+		for (const auto* attr : entity->all_attributes()) {
+			lookups.push_back({ entity, attr->name() });
+			if (instance != nullptr) {
+				gets.push_back({ instance, attr->name() });
+			}
+		}
+	}
+
+	std::vector<IfcParse::attribute_handle> handles;
+	handles.reserve(gets.size());
+	for (const auto& g : gets) {
+		handles.push_back(g.first->declaration().attribute_handle_by_name(g.second));
+	}
+
+	std::cout << schema->entities().size() << " entities, " << lookups.size() << " attributes" << std::endl;
+
+	size_t linear_sum = 0, index_sum = 0;
+
+	stopwatch timer;
+	for (int i = 0; i < repetitions; ++i) {
+		for (const auto& l : lookups) {
+			linear_sum += linear_attribute_index(l.first, l.second);
+		}
+	}
+	const double linear_time = timer.seconds();
+
+	timer.restart();
+	for (int i = 0; i < repetitions; ++i) {
+		for (const auto& l : lookups) {
+			index_sum += l.first->attribute_index(l.second);
+		}
+	}
+	const double index_time = timer.seconds();
+
+	if (linear_sum != index_sum) {
+		std::cerr << "Mismatch in attribute indices found" << std::endl;
+		return 1;
+	}
+
+	size_t num_blank = 0;
+
+	timer.restart();
+	for (int i = 0; i < repetitions; ++i) {
+		for (const auto& g : gets) {
+			num_blank += g.first->get(g.second).isNull();
+		}
+	}
+	const double get_by_name_time = timer.seconds();
+
+	timer.restart();
+	for (int i = 0; i < repetitions; ++i) {
+		for (size_t j = 0; j < gets.size(); ++j) {
+			num_blank -= gets[j].first->get(handles[j]).isNull();
+		}
+	}
+	const double get_by_handle_time = timer.seconds();
+
+	if (num_blank != 0) {
+		std::cerr << "Mismatch in attribute values found" << std::endl;
+		return 1;
+	}
+
+	const double num_lookups = (double)lookups.size() * repetitions;
+	const double num_gets = (double)gets.size() * repetitions;
+	std::cout << "copy and compare:    " << num_lookups / linear_time << " lookups/s" << std::endl;
+	std::cout << "attribute_index():   " << num_lookups / index_time << " lookups/s" << std::endl;
+	std::cout << "get(name):           " << num_gets / get_by_name_time << " gets/s" << std::endl;
+	std::cout << "get(handle):         " << num_gets / get_by_handle_time << " gets/s" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,196 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Removes all property sets and their properties from a generated IFC4 file,   *
+ * in a batch and one by one, and verifies that the references to them are      *
+ * unset. Also verifies that rolling back a batch leaves the file unaltered.    *
+ *                                                                              *
+ * Usage: IfcDeletionBenchmark [instances] [instances removed one by one]       *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "../ifcparse/IfcException.h"
+#include "../ifcparse/IfcFile.h"
+#include "../ifcparse/IfcLogger.h"
+#include "stopwatch.h"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	const int properties_per_set = 9;
+
+	std::string global_id(size_t n) {
+		static const char chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_$";
+		std::string s(22, '0');
+		for (size_t i = 21; n != 0; --i, n /= 64) {
+			s[i] = chars[n % 64];
+		}
+		return s;
+	}
+
+	// Generates a proxy element with groups of a property set, its
+	// properties and the relationship assigning it to the proxy
+	IfcParse::IfcFile* generate(size_t groups) {
+		std::ostringstream ss;
+		ss << "ISO-10303-21;\nHEADER;\nFILE_DESCRIPTION((''),'2;1');\nFILE_NAME('','',(''),(''),'','','');\nFILE_SCHEMA(('IFC4'));\nENDSEC;\nDATA;\n";
+		ss << "#1=IFCBUILDINGELEMENTPROXY('" << global_id(0) << "',$,$,$,$,$,$,$,$);\n";
+		size_t id = 2;
+		for (size_t g = 0; g < groups; ++g) {
+			const size_t first_property = id;
+			for (int p = 0; p < properties_per_set; ++p) {
+				ss << "#" << id++ << "=IFCPROPERTYSINGLEVALUE('P" << p << "',$,IFCLABEL('" << g << "'),$);\n";
+			}
+			const size_t pset = id++;
+			ss << "#" << pset << "=IFCPROPERTYSET('" << global_id(2 * g + 1) << "',$,'Pset',$,(";
+			for (size_t p = first_property; p < pset; ++p) {
+				ss << (p == first_property ? "#" : ",#") << p;
+			}
+			ss << "));\n";
+			ss << "#" << id++ << "=IFCRELDEFINESBYPROPERTIES('" << global_id(2 * g + 2) << "',$,$,$,(#1),#" << pset << ");\n";
+		}
+		ss << "ENDSEC;\nEND-ISO-10303-21;\n";
+
+		const std::string data = ss.str();
+		char* buffer = new char[data.size()];
+		std::memcpy(buffer, data.data(), data.size());
+		return new IfcParse::IfcFile(buffer, data.size());
+	}
+
+	std::vector<IfcUtil::IfcBaseClass*> instances_to_remove(IfcParse::IfcFile& file, size_t limit) {
+		std::vector<IfcUtil::IfcBaseClass*> instances;
+		for (const char* type : {"IfcPropertySingleValue", "IfcPropertySet"}) {
+			auto of_type = file.instances_by_type(type);
+			for (auto* inst : *of_type) {
+				if (instances.size() < limit) {
+					instances.push_back(inst);
+				}
+			}
+		}
+		return instances;
+	}
+
+	size_t count(IfcParse::IfcFile& file) {
+		size_t n = 0;
+		for (auto it = file.begin(); it != file.end(); ++it) {
+			++n;
+		}
+		return n;
+	}
+
+	// Checks that no instance refers to a removed instance
+	bool verify(IfcParse::IfcFile& file, size_t expected) {
+		if (count(file) != expected) {
+			std::cerr << "Expected " << expected << " instances, found " << count(file) << std::endl;
+			return false;
+		}
+		auto rels = file.instances_by_type("IfcRelDefinesByProperties");
+		for (auto* rel : *rels) {
+			// The property set precedes the relationship
+			IfcUtil::IfcBaseClass* pset = nullptr;
+			try {
+				pset = file.instance_by_id(rel->id() - 1);
+			} catch (const IfcParse::IfcException&) {
+			}
+			auto attr = rel->data().get_attribute_value(5);
+			if (attr.isNull() ? pset != nullptr : (IfcUtil::IfcBaseClass*) attr != pset) {
+				std::cerr << "Invalid reference on #" << rel->id() << std::endl;
+				return false;
+			}
+		}
+		// Every remaining property is contained in a single property set
+		size_t properties = 0;
+		auto psets = file.instances_by_type("IfcPropertySet");
+		for (auto* pset : *psets) {
+			aggregate_of_instance::ptr list = pset->data().get_attribute_value(4);
+			properties += list->size();
+		}
+		if (properties != file.instances_by_type("IfcPropertySingleValue")->size()) {
+			std::cerr << "Property sets refer to removed properties" << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t instances = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	const size_t unbatched = argc > 2 ? std::stoul(argv[2]) : 10000;
+	const size_t groups = instances / (properties_per_set + 1);
+
+	Logger::SetOutput(nullptr, &std::cerr);
+
+	stopwatch timer;
+	IfcParse::IfcFile* file = generate(groups);
+	if (!file->good()) {
+		std::cerr << "Unable to parse generated file" << std::endl;
+		return 1;
+	}
+	const size_t total = count(*file);
+	std::cout << "Generated and parsed " << total << " instances in " << timer.seconds() << "s" << std::endl;
+
+	auto to_remove = instances_to_remove(*file, instances);
+
+	timer.restart();
+	file->batch();
+	for (auto* inst : to_remove) {
+		file->removeEntity(inst);
+	}
+	file->rollback_batch();
+	std::cout << "Rolled back removal of " << to_remove.size() << " instances in " << timer.seconds() << "s" << std::endl;
+	if (!verify(*file, total) || file->instances_by_type("IfcPropertySet")->size() != groups) {
+		std::cerr << "File altered by rollback" << std::endl;
+		return 1;
+	}
+
+	timer.restart();
+	file->batch();
+	for (auto* inst : to_remove) {
+		file->removeEntity(inst);
+	}
+	file->unbatch();
+	const double batched = timer.seconds();
+	std::cout << "Removed " << to_remove.size() << " instances in a batch in " << batched << "s" << std::endl;
+	if (!verify(*file, total - to_remove.size())) {
+		return 1;
+	}
+	delete file;
+
+	if (unbatched > 0) {
+		file = generate(groups);
+		to_remove = instances_to_remove(*file, unbatched);
+		timer.restart();
+		for (auto* inst : to_remove) {
+			file->removeEntity(inst);
+		}
+		const double one_by_one = timer.seconds();
+		std::cout << "Removed " << to_remove.size() << " instances one by one in " << one_by_one << "s" << std::endl;
+		if (!verify(*file, total - to_remove.size())) {
+			return 1;
+		}
+		delete file;
+	}
+
+	return 0;
+}
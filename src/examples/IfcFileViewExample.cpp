@@ -0,0 +1,256 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Modifies an IFC file on one thread and commits versions of it, while other   *
+ * threads read the first committed version and verify that it is unaffected.   *
+ * Every version is verified to be equal to the file at the time of the commit. *
+ *                                                                              *
+ * Usage: IfcFileViewExample <file.ifc> [commits] [reader threads]              *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "../ifcparse/IfcException.h"
+#include "../ifcparse/IfcFile.h"
+#include "../ifcparse/IfcFileView.h"
+#include "../ifcparse/IfcLogger.h"
+#include "stopwatch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	// FNV-1a over the names, types, strings and references of the instances
+	class fingerprint {
+		uint64_t h_ = 14695981039346656037ULL;
+
+		void add_(const void* p, size_t n) {
+			for (size_t i = 0; i < n; ++i) {
+				h_ = (h_ ^ static_cast<const unsigned char*>(p)[i]) * 1099511628211ULL;
+			}
+		}
+
+	public:
+		void add(unsigned v) { add_(&v, sizeof(v)); }
+		void add(const std::string& s) { add_(s.data(), s.size()); }
+		uint64_t value() const { return h_; }
+	};
+
+	// Adds an instance, with name_of() mapping referenced instances to their names
+	template <typename Fn>
+	void add_instance(fingerprint& fp, unsigned id, const IfcParse::declaration& decl, const IfcEntityInstanceData& data, Fn name_of) {
+		fp.add(id);
+		fp.add(decl.name());
+		for (size_t i = 0; i < data.size(); ++i) {
+			auto attr = data.get_attribute_value(i);
+			fp.add((unsigned) attr.type());
+			switch (attr.type()) {
+			case IfcUtil::Argument_STRING:
+				fp.add((std::string) attr);
+				break;
+			case IfcUtil::Argument_ENTITY_INSTANCE:
+				fp.add(name_of((IfcUtil::IfcBaseClass*) attr));
+				break;
+			case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE: {
+				aggregate_of_instance::ptr list = attr;
+				for (auto* inst : *list) {
+					fp.add(name_of(inst));
+				}
+			} break;
+			case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE: {
+				aggregate_of_aggregate_of_instance::ptr list = attr;
+				for (const auto& inner : *list) {
+					fp.add((unsigned) inner.size());
+					for (auto* inst : inner) {
+						fp.add(name_of(inst));
+					}
+				}
+			} break;
+			default:
+				break;
+			}
+		}
+	}
+
+	uint64_t fingerprint_of(const IfcParse::IfcFileView& view) {
+		fingerprint fp;
+		view.visit([&](const IfcParse::IfcFileView::instance& inst) {
+			add_instance(fp, inst.id(), inst.declaration(), inst.data(), [&view](const IfcUtil::IfcBaseClass* ref) {
+				// Instances in the file are only used as keys, as they may have
+				// been modified or removed since
+				const auto* resolved = view.resolve(ref);
+				return resolved != nullptr ? resolved->id() : 0U;
+			});
+		});
+		return fp.value();
+	}
+
+	uint64_t fingerprint_of(IfcParse::IfcFile& file) {
+		std::vector<IfcUtil::IfcBaseClass*> instances;
+		for (auto it = file.begin(); it != file.end(); ++it) {
+			instances.push_back(it->second);
+		}
+		std::sort(instances.begin(), instances.end(), [](IfcUtil::IfcBaseClass* a, IfcUtil::IfcBaseClass* b) {
+			return a->id() < b->id();
+		});
+		fingerprint fp;
+		for (auto* inst : instances) {
+			add_instance(fp, inst->id(), inst->declaration(), inst->data(), [](IfcUtil::IfcBaseClass* ref) {
+				return ref->declaration().as_entity() != nullptr ? ref->id() : 0U;
+			});
+		}
+		return fp.value();
+	}
+
+	bool verify(IfcParse::IfcFile& file, const IfcParse::IfcFileView& view) {
+		if (fingerprint_of(file) != fingerprint_of(view)) {
+			std::cerr << "Version " << view.version() << " differs from the file" << std::endl;
+			return false;
+		}
+		for (auto it = file.begin(); it != file.end(); ++it) {
+			if (file.getTotalInverses(it->first) != view.getTotalInverses(it->first)) {
+				std::cerr << "Inverses of #" << it->first << " differ in version " << view.version() << std::endl;
+				return false;
+			}
+		}
+		auto roots = file.instances_by_type("IfcRoot");
+		if (roots->size() != view.instances_by_type("IfcRoot").size()) {
+			std::cerr << "Instances by type differ in version " << view.version() << std::endl;
+			return false;
+		}
+		for (auto* root : *roots) {
+			const std::string guid = root->data().get_attribute_value(0);
+			// GlobalIds are not necessarily unique, so this is not necessarily root
+			const std::string found = view.instance_by_guid(guid)->get_attribute_value(0);
+			if (found != guid) {
+				std::cerr << "Instance by GlobalId differs in version " << view.version() << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <file.ifc> [commits] [reader threads]" << std::endl;
+		return 1;
+	}
+	const int commits = argc > 2 ? std::stoi(argv[2]) : 20;
+	const int readers = argc > 3 ? std::stoi(argv[3]) : 2;
+
+	Logger::SetOutput(nullptr, &std::cerr);
+
+	IfcParse::IfcFile file(argv[1]);
+	IfcParse::IfcFile source(argv[1]);
+	if (!file.good() || !source.good()) {
+		std::cerr << "Unable to parse " << argv[1] << std::endl;
+		return 1;
+	}
+
+	stopwatch timer;
+	const IfcParse::IfcFileView::ptr first = file.commit();
+	std::cout << "Committed version 1 with " << first->size() << " instances in " << timer.seconds() << "s" << std::endl;
+	if (!verify(file, *first)) {
+		return 1;
+	}
+	const uint64_t expected = fingerprint_of(*first);
+
+	std::atomic<bool> done(false), failed(false);
+	std::atomic<size_t> reads(0);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < readers; ++i) {
+		threads.emplace_back([&]() {
+			while (!done) {
+				if (fingerprint_of(*first) != expected) {
+					failed = true;
+				}
+				// Also read whatever version is the latest
+				fingerprint_of(*file.view());
+				++reads;
+			}
+		});
+	}
+
+	std::mt19937 rng(1);
+	std::vector<unsigned> names;
+	for (auto it = source.begin(); it != source.end(); ++it) {
+		names.push_back(it->first);
+	}
+
+	double commit_time = 0.;
+	bool valid = true;
+	for (int c = 0; c < commits && valid; ++c) {
+		std::vector<IfcUtil::IfcBaseClass*> instances;
+		for (auto it = file.begin(); it != file.end(); ++it) {
+			instances.push_back(it->second);
+		}
+		std::shuffle(instances.begin(), instances.end(), rng);
+		const size_t n = instances.size() / 100 + 1;
+
+		// Rename some rooted instances
+		size_t renamed = 0;
+		for (auto* inst : instances) {
+			if (renamed < n && inst->declaration().is("IfcRoot")) {
+				inst->set_attribute_value(2, std::string("Version ") + std::to_string(c + 2));
+				++renamed;
+			}
+		}
+
+		// Remove some instances, some in a batch and some one by one
+		file.batch();
+		for (size_t i = 0; i < n && i < instances.size(); ++i) {
+			file.removeEntity(instances[i]);
+		}
+		file.unbatch();
+		for (size_t i = n; i < 2 * n && i < instances.size(); ++i) {
+			file.removeEntity(instances[i]);
+		}
+
+		// Add copies of some instances from the original file
+		for (size_t i = 0; i < n; ++i) {
+			file.addEntity(source.instance_by_id(names[rng() % names.size()]));
+		}
+
+		timer.restart();
+		auto view = file.commit();
+		commit_time += timer.seconds();
+		valid = verify(file, *view);
+	}
+
+	done = true;
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	if (!valid || failed) {
+		std::cerr << (failed ? "Version 1 was modified while it was read" : "Committed versions differ from the file") << std::endl;
+		return 1;
+	}
+
+	std::cout << "Committed " << commits << " versions in " << commit_time << "s, with " << reads << " reads of versions in the meantime" << std::endl;
+	return 0;
+}
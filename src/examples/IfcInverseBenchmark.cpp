@@ -0,0 +1,166 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Compares the throughput of inverse lookups on the references of an IFC file  *
+ * between a std::map keyed on (instance, type, attribute), as previously used *
+ * by IfcFile, and IfcParse::inverse_index.                                     *
+ *                                                                              *
+ * Usage: IfcInverseBenchmark <file.ifc> [repetitions]                          *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "../ifcparse/IfcFile.h"
+#include "../ifcparse/IfcLogger.h"
+#include "../ifcparse/inverse_index.h"
+#include "stopwatch.h"
+
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+typedef IfcParse::inverse_index::key_type key_type;
+typedef std::map<key_type, std::vector<int>> map_index;
+
+namespace {
+	void add_reference(std::vector<std::pair<key_type, int>>& references, IfcUtil::IfcBaseClass* instance, IfcUtil::IfcBaseClass* referenced, size_t attribute_index) {
+		if (referenced != nullptr && referenced->declaration().as_entity() != nullptr) {
+			references.push_back({ key_type{(int)referenced->id(), (short)instance->declaration().index_in_schema(), (short)attribute_index}, (int)instance->id() });
+		}
+	}
+
+	std::vector<std::pair<key_type, int>> collect_references(IfcParse::IfcFile& file) {
+		std::vector<std::pair<key_type, int>> references;
+		for (auto it = file.begin(); it != file.end(); ++it) {
+			IfcUtil::IfcBaseClass* instance = it->second;
+			for (size_t i = 0; i < instance->data().size(); ++i) {
+				auto attr = instance->data().get_attribute_value(i);
+				if (attr.isNull()) {
+					continue;
+				}
+				switch (attr.type()) {
+				case IfcUtil::Argument_ENTITY_INSTANCE:
+					add_reference(references, instance, attr, i);
+					break;
+				case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE: {
+					aggregate_of_instance::ptr list = attr;
+					for (auto* referenced : *list) {
+						add_reference(references, instance, referenced, i);
+					}
+				} break;
+				case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE: {
+					aggregate_of_aggregate_of_instance::ptr list = attr;
+					for (const auto& inner : *list) {
+						for (auto* referenced : inner) {
+							add_reference(references, instance, referenced, i);
+						}
+					}
+				} break;
+				default:
+					break;
+				}
+			}
+		}
+		return references;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <file.ifc> [repetitions]" << std::endl;
+		return 1;
+	}
+	const int repetitions = argc > 2 ? std::stoi(argv[2]) : 10;
+
+	Logger::SetOutput(nullptr, &std::cerr);
+
+	IfcParse::IfcFile file(argv[1]);
+	if (!file.good()) {
+		std::cerr << "Unable to parse " << argv[1] << std::endl;
+		return 1;
+	}
+
+	const auto references = collect_references(file);
+	std::set<int> referenced;
+	for (const auto& r : references) {
+		referenced.insert(std::get<0>(r.first));
+	}
+	const std::vector<int> names(referenced.begin(), referenced.end());
+
+	std::cout << references.size() << " references to " << names.size() << " instances" << std::endl;
+
+	stopwatch timer;
+	map_index map;
+	for (const auto& r : references) {
+		map[r.first].push_back(r.second);
+	}
+	const double map_build = timer.seconds();
+
+	timer.restart();
+	IfcParse::inverse_index index;
+	for (const auto& r : references) {
+		index.append(r.first, r.second);
+	}
+	index.build();
+	const double index_build = timer.seconds();
+
+	size_t map_count = 0, index_count = 0;
+
+	timer.restart();
+	for (int i = 0; i < repetitions; ++i) {
+		for (int name : names) {
+			auto lower = map.lower_bound({ name, -1, -1 });
+			auto upper = map.upper_bound({ name, std::numeric_limits<short>::max(), std::numeric_limits<short>::max() });
+			for (auto it = lower; it != upper; ++it) {
+				map_count += it->second.size();
+			}
+		}
+	}
+	const double map_lookup = timer.seconds();
+
+	timer.restart();
+	for (int i = 0; i < repetitions; ++i) {
+		for (int name : names) {
+			index.visit(name, [&index_count](const key_type&, const int* begin, const int* end) {
+				index_count += end - begin;
+			});
+		}
+	}
+	const double index_lookup = timer.seconds();
+
+	if (map_count != index_count) {
+		std::cerr << "Mismatch in number of references found" << std::endl;
+		return 1;
+	}
+
+	// Roughly: a red-black tree node and a separately allocated vector per
+	// key versus a key, offset and name in contiguous arrays.
+	const size_t map_bytes = map.size() * (sizeof(map_index::value_type) + 4 * sizeof(void*)) + references.size() * sizeof(int);
+	const size_t index_bytes = map.size() * (sizeof(key_type) + sizeof(size_t)) + references.size() * sizeof(int);
+
+	const double lookups = (double)names.size() * repetitions;
+	std::cout << "std::map:      build " << map_build << "s, " << lookups / map_lookup << " lookups/s, ~" << map_bytes / 1024 << " KiB" << std::endl;
+	std::cout << "inverse_index: build " << index_build << "s, " << lookups / index_lookup << " lookups/s, ~" << index_bytes / 1024 << " KiB" << std::endl;
+
+	return 0;
+}
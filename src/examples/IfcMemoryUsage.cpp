@@ -0,0 +1,99 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Prints the estimated memory held by an IFC file after reading it, by         *
+ * category, as reported by IfcFile::memory_statistics(). When a budget in     *
+ * bytes is given, exits with a non-zero status when the total exceeds it, so   *
+ * that memory regressions on reference models can be caught in CI.            *
+ *                                                                              *
+ * Usage: IfcMemoryUsage <file.ifc> [budget]                                    *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "../ifcparse/IfcFile.h"
+#include "../ifcparse/IfcLogger.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+	void print(const std::string& category, size_t bytes) {
+		std::cout << std::left << std::setw(48) << category << std::right << std::setw(14) << bytes << std::endl;
+	}
+
+	// Prints the entries in descending order of size
+	void print_sorted(const std::string& prefix, std::vector<std::pair<std::string, size_t>> entries) {
+		std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+			return a.second > b.second;
+		});
+		for (const auto& p : entries) {
+			print(prefix + p.first, p.second);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <file.ifc> [budget]" << std::endl;
+		return 1;
+	}
+
+	Logger::SetOutput(nullptr, &std::cerr);
+
+	IfcParse::IfcFile file(argv[1]);
+	if (!file.good()) {
+		std::cerr << "Unable to parse " << argv[1] << std::endl;
+		return 1;
+	}
+
+	const auto stats = file.memory_statistics();
+
+	std::vector<std::pair<std::string, size_t>> instances, attributes;
+	for (const auto& p : stats.instances) {
+		instances.push_back({p.first->name(), p.second});
+	}
+	for (const auto& p : stats.attributes) {
+		attributes.push_back({IfcUtil::ArgumentTypeToString(p.first), p.second});
+	}
+
+	print_sorted("instances.", instances);
+	print_sorted("attributes.", attributes);
+	print("inverse_index", stats.inverse_index);
+	print("guid_map", stats.guid_map);
+	print("instance_maps", stats.instance_maps);
+	print("header", stats.header);
+	print("stream", stats.stream);
+	print("strings", stats.strings);
+	print("arena_unused", stats.arena_unused);
+	print("journal", stats.journal);
+	print("total", stats.total());
+
+	if (argc > 2 && stats.total() > std::stoull(argv[2])) {
+		std::cerr << "Total of " << stats.total() << " bytes exceeds the budget of " << argv[2] << " bytes" << std::endl;
+		return 2;
+	}
+
+	return 0;
+}
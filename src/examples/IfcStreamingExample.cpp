@@ -0,0 +1,118 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Writes the single value properties of the objects in an IFC file as CSV,    *
+ * reading the file instance by instance with IfcParse::IfcSpfReader, so that  *
+ * files much larger than the available memory can be processed.               *
+ *                                                                              *
+ * Usage: IfcStreamingExample <file.ifc> [cache size]                           *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "../ifcparse/IfcLogger.h"
+#include "../ifcparse/IfcSpfReader.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <file.ifc> [cache size]" << std::endl;
+		return 1;
+	}
+
+	Logger::SetOutput(nullptr, &std::cerr);
+
+	IfcParse::IfcSpfReader reader(argv[1]);
+	if (!reader.good()) {
+		std::cerr << "Unable to read " << argv[1] << std::endl;
+		return 1;
+	}
+
+	// Property sets and their properties are usually written shortly before
+	// the relationship that assigns them, so retaining the most recently read
+	// instances suffices to navigate from the relationship to the values.
+	reader.cache_size(argc > 2 ? std::stoul(argv[2]) : 100000);
+
+	const IfcParse::declaration* rel_type = reader.schema()->declaration_by_name("IfcRelDefinesByProperties");
+	const size_t related_objects = rel_type->as_entity()->attribute_index("RelatedObjects");
+
+	size_t num_values = 0, num_unresolved = 0;
+
+	std::cout << "instance;property_set;property;value" << std::endl;
+
+	reader.read([&](IfcParse::IfcSpfReader::instance& inst) {
+		// The attributes of other instances are never decoded
+		if (&inst.declaration() != rel_type) {
+			return;
+		}
+
+		// References to instances that are not in the cache are unset
+		auto definition = inst.get_attribute_value(rel_type->as_entity()->attribute_index("RelatingPropertyDefinition"));
+		if (definition.isNull()) {
+			++num_unresolved;
+			return;
+		}
+		auto* pset = ((IfcUtil::IfcBaseClass*)definition)->as<IfcUtil::IfcBaseEntity>();
+		if (!pset->declaration().is("IfcPropertySet")) {
+			return;
+		}
+		auto has_properties = pset->get("HasProperties");
+		if (has_properties.isNull()) {
+			++num_unresolved;
+			return;
+		}
+
+		auto name = pset->get("Name");
+		const std::string pset_name = name.isNull() ? std::string() : (std::string)name;
+		aggregate_of_instance::ptr properties = has_properties;
+
+		// The related objects mostly follow the relationship in the file, so
+		// these are referred to by name
+		for (const auto& reference : inst.references()) {
+			if (reference.first != related_objects) {
+				continue;
+			}
+			for (auto* property : *properties) {
+				if (!property->declaration().is("IfcPropertySingleValue")) {
+					continue;
+				}
+				auto* p = property->as<IfcUtil::IfcBaseEntity>();
+				std::ostringstream value;
+				auto nominal_value = p->get("NominalValue");
+				if (!nominal_value.isNull()) {
+					((IfcUtil::IfcBaseClass*)nominal_value)->toString(value);
+				}
+				std::cout << "#" << reference.second << ";" << pset_name << ";" << (std::string)p->get("Name") << ";" << value.str() << "\n";
+				++num_values;
+			}
+		}
+	});
+
+	std::cerr << num_values << " property values written";
+	if (num_unresolved != 0) {
+		std::cerr << ", " << num_unresolved << " property assignments skipped as the property set was not in the cache";
+	}
+	std::cerr << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Verifies that subtype tests based on the pre- and post-order ranks of the    *
+ * entities in every available schema agree with walking the supertypes, and    *
+ * that IfcBaseClass::as<T>() agrees with dynamic_cast for IFC4 instances.      *
+ * Compares the throughput of as<T>() and dynamic_cast.                         *
+ *                                                                              *
+ * Usage: IfcTypeCheckBenchmark [repetitions]                                   *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "../ifcparse/IfcBaseClass.h"
+#include "../ifcparse/IfcSchema.h"
+#include "stopwatch.h"
+
+#ifdef HAS_SCHEMA_4
+#include "../ifcparse/Ifc4.h"
+#endif
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+	bool is_subtype_of(const IfcParse::entity* entity, const IfcParse::entity* other) {
+		for (; entity != nullptr; entity = entity->supertype()) {
+			if (entity == other) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+#ifdef HAS_SCHEMA_4
+	struct timings {
+		size_t found = 0;
+		double as = 0.;
+		double dynamic = 0.;
+	};
+
+	template <typename T>
+	bool compare_casts(const std::vector<IfcUtil::IfcBaseClass*>& instances, int repetitions, timings& t) {
+		for (auto* instance : instances) {
+			if (instance->as<T>() != dynamic_cast<T*>(instance)) {
+				std::cerr << "as<" << T::Class().name() << ">() differs from dynamic_cast for " << instance->declaration().name() << std::endl;
+				return false;
+			}
+		}
+
+		size_t as_found = 0, dynamic_found = 0;
+
+		stopwatch timer;
+		for (int i = 0; i < repetitions; ++i) {
+			for (auto* instance : instances) {
+				as_found += instance->as<T>() != nullptr;
+			}
+		}
+		t.as += timer.seconds();
+
+		timer.restart();
+		for (int i = 0; i < repetitions; ++i) {
+			for (auto* instance : instances) {
+				dynamic_found += dynamic_cast<T*>(instance) != nullptr;
+			}
+		}
+		t.dynamic += timer.seconds();
+
+		t.found += as_found;
+		return as_found == dynamic_found;
+	}
+#endif
+}
+
+int main(int argc, char** argv) {
+	const int repetitions = argc > 1 ? std::stoi(argv[1]) : 100;
+
+	for (const auto& name : IfcParse::schema_names()) {
+		const auto& entities = IfcParse::schema_by_name(name)->entities();
+		size_t num_subtypes = 0;
+		for (const auto* a : entities) {
+			for (const auto* b : entities) {
+				const bool expected = is_subtype_of(a, b);
+				if (a->is(*b) != expected) {
+					std::cerr << name << ": " << a->name() << (expected ? " is " : " is not ") << "a subtype of " << b->name() << std::endl;
+					return 1;
+				}
+				num_subtypes += expected;
+			}
+		}
+		std::cout << name << ": " << entities.size() << " entities, " << num_subtypes << " subtype relations verified" << std::endl;
+	}
+
+#ifdef HAS_SCHEMA_4
+	const IfcParse::schema_definition* schema = IfcParse::schema_by_name("IFC4");
+
+	std::vector<std::unique_ptr<IfcUtil::IfcBaseClass>> owned;
+	std::vector<IfcUtil::IfcBaseClass*> instances;
+	for (const auto* entity : schema->entities()) {
+		if (!entity->is_abstract()) {
+			owned.emplace_back(schema->instantiate(entity, IfcEntityInstanceData(storage_t(entity->attribute_count()))));
+			instances.push_back(owned.back().get());
+		}
+	}
+
+	timings entities, selects;
+	const bool equal =
+		compare_casts<Ifc4::IfcRoot>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcProduct>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcElement>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcWall>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcRepresentationItem>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcCurve>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcBSplineCurve>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcExtrudedAreaSolid>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcProfileDef>(instances, repetitions, entities) &&
+		compare_casts<Ifc4::IfcPropertySingleValue>(instances, repetitions, entities) &&
+		// Select types are not entities and are cast with dynamic_cast
+		compare_casts<Ifc4::IfcAxis2Placement>(instances, repetitions, selects) &&
+		compare_casts<Ifc4::IfcCurveOnSurface>(instances, repetitions, selects);
+
+	if (!equal) {
+		return 1;
+	}
+
+	const double num_entity_casts = (double)instances.size() * repetitions * 10;
+	const double num_select_casts = (double)instances.size() * repetitions * 2;
+	std::cout << "IFC4: " << instances.size() << " instances, " << (entities.found + selects.found) / repetitions << " successful casts" << std::endl;
+	std::cout << "entity types, as<T>():        " << num_entity_casts / entities.as << " casts/s" << std::endl;
+	std::cout << "entity types, dynamic_cast:   " << num_entity_casts / entities.dynamic << " casts/s" << std::endl;
+	std::cout << "select types, as<T>():        " << num_select_casts / selects.as << " casts/s" << std::endl;
+	std::cout << "select types, dynamic_cast:   " << num_select_casts / selects.dynamic << " casts/s" << std::endl;
+#endif
+
+	return 0;
+}
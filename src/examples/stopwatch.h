@@ -0,0 +1,45 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Wall clock timing for the benchmarks in this directory                       *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef STOPWATCH_H
+#define STOPWATCH_H
+
+#include <chrono>
+
+class stopwatch {
+	std::chrono::steady_clock::time_point start_;
+
+public:
+	stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+	void restart() { start_ = std::chrono::steady_clock::now(); }
+
+	// Seconds elapsed since construction or the last restart()
+	double seconds() const {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+	}
+};
+
+#endif
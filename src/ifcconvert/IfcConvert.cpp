@@ -998,6 +998,13 @@ int main(int argc, char** argv) {
 		geometry_settings.get<ifcopenshell::geometry::settings::OutputDimensionality>().value = ifcopenshell::geometry::settings::CURVES;
 	}
 
+	// Elements are serialized as soon as they are fetched, so there is no need
+	// for the iterator to retain them until the end of the conversion, unless
+	// requested explicitly with --result-queue-size 0.
+	if (vmap[ifcopenshell::geometry::settings::ResultQueueSize::name].defaulted()) {
+		geometry_settings.get<ifcopenshell::geometry::settings::ResultQueueSize>().value = 4 * std::max(num_threads, 1);
+	}
+
 	std::unique_ptr<IfcGeom::Iterator> context_iterator;
 	if (!elems_from_adaptor) {
 		context_iterator.reset(new IfcGeom::Iterator(geometry_kernel, geometry_settings, ifc_file, filter_funcs, num_threads));
@@ -1197,6 +1204,18 @@ int main(int argc, char** argv) {
 			" objects)                                ");
 	}
 
+	if (context_iterator) {
+		auto timed_out = context_iterator->timed_out_elements();
+		if (!timed_out.empty()) {
+			std::stringstream ss;
+			ss << timed_out.size() << " element(s) exceeded the element timeout and were simplified:";
+			for (auto& e : timed_out) {
+				ss << "\n  " << e.product_guid << " " << e.product_type << " #" << e.product_id << ": " << e.fallback << " after " << e.seconds << "s";
+			}
+			Logger::Warning(ss.str());
+		}
+	}
+
     serializer->finalize();
     // Make sure the dtor is explicitly run here (e.g. output files are closed before renaming them).
     serializer.reset();
@@ -22,9 +22,16 @@
 using namespace ifcopenshell::geometry;
 
 bool ifcopenshell::geometry::kernels::AbstractKernel::convert(const taxonomy::ptr item, IfcGeom::ConversionResults& results) {
+	if (cancellation_) {
+		cancellation_->check();
+	}
+
 	auto with_exception_handling = [&](auto fn) {
 		try {
 			return fn();
+		} catch (const IfcGeom::timeout_error&) {
+			// Not a failure of this item, the conversion as a whole is abandoned
+			throw;
 		} catch (std::exception& e) {
 			Logger::Error(e, item->instance);
 			return false;
@@ -100,6 +107,8 @@ public:
 			bool success = false;
 			try {
 				success = k->convert(item, rs);
+			} catch (const IfcGeom::timeout_error&) {
+				throw;
 			} catch(...) {}
 			if (success) {
 				return true;
@@ -107,11 +116,19 @@ public:
 		}
 		return false;
 	}
+	virtual void set_cancellation_token(const IfcGeom::cancellation_token* token) {
+		AbstractKernel::set_cancellation_token(token);
+		for (auto& k : kernels_) {
+			k->set_cancellation_token(token);
+		}
+	}
 	virtual bool apply_layerset(IfcGeom::ConversionResults& items, const ifcopenshell::geometry::layerset_information& layers) {
 		for (auto& k : kernels_) {
 			bool success = false;
 			try {
 				success = k->apply_layerset(items, layers);
+			} catch (const IfcGeom::timeout_error&) {
+				throw;
 			} catch (...) {}
 			if (success) {
 				return true;
@@ -124,6 +141,8 @@ public:
 			bool success = false;
 			try {
 				success = k->apply_folded_layerset(items, layers, folds);
+			} catch (const IfcGeom::timeout_error&) {
+				throw;
 			} catch (...) {}
 			if (success) {
 				return true;
@@ -148,6 +167,8 @@ public:
 			bool success = false;
 			try {
 				success = k->convert_openings(entity, openings, entity_shapes, entity_trsf, cut_shapes);
+			} catch (const IfcGeom::timeout_error&) {
+				throw;
 			} catch (...) {}
 			if (success) {
 				return true;
@@ -221,10 +242,39 @@ ifcopenshell::geometry::kernels::AbstractKernel* ifcopenshell::geometry::kernels
 	throw IfcParse::IfcException("No geometry kernel registered for " + geometry_library);
 }
 
+namespace {
+	bool is_mapped_representation(const taxonomy::ptr& item) {
+		if (item->kind() != taxonomy::COLLECTION || !item->instance) {
+			return false;
+		}
+		auto inst = item->instance->as<IfcUtil::IfcBaseEntity>();
+		return inst && inst->declaration().is("IfcRepresentation");
+	}
+}
+
+bool ifcopenshell::geometry::kernels::AbstractKernel::convert_cached_(const taxonomy::ptr item, IfcGeom::ConversionResults& r) {
+	IfcGeom::ConversionResults results;
+	if (!result_cache_->find(item->identity(), results)) {
+		convert(item, results);
+		for (auto& result : results) {
+			result.Shape()->prepare_for_sharing(settings_);
+		}
+		results = result_cache_->insert(item->identity(), results);
+	}
+	r.insert(r.end(), results.begin(), results.end());
+	return !results.empty();
+}
+
 bool ifcopenshell::geometry::kernels::AbstractKernel::convert_impl(const taxonomy::collection::ptr collection, IfcGeom::ConversionResults& r) {
 	auto s = r.size();
 	for (auto& c : collection->children) {
-		convert(c, r);
+		// Children that are representations stem from mapped items, which
+		// typically refer to the same representation many times.
+		if (result_cache_ && is_mapped_representation(c)) {
+			convert_cached_(c, r);
+		} else {
+			convert(c, r);
+		}
 	}
 	for (auto i = s; i < r.size(); ++i) {
 		if (collection->matrix) {
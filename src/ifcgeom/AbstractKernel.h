@@ -7,6 +7,10 @@
 #include "../ifcgeom/IfcGeomRepresentation.h"
 #include "../ifcgeom/taxonomy.h"
 #include "../ifcgeom/ConversionSettings.h"
+#include "../ifcgeom/sharded_cache.h"
+#include "../ifcgeom/cancellation_token.h"
+
+#include <memory>
 
 static const double ALMOST_ZERO = 1.e-9;
 
@@ -34,9 +38,17 @@ namespace ifcopenshell {
 	namespace geometry { namespace kernels {
 
 	class IFC_GEOM_API AbstractKernel {
+	public:
+		// Conversion results of mapped representations by identity of the taxonomy item
+		typedef IfcGeom::sharded_cache<uint32_t, IfcGeom::ConversionResults> result_cache_t;
+
 	protected:
 		std::string geometry_library_;
 		Settings settings_;
+		std::shared_ptr<result_cache_t> result_cache_;
+		const IfcGeom::cancellation_token* cancellation_ = nullptr;
+
+		bool convert_cached_(const taxonomy::ptr, IfcGeom::ConversionResults&);
 	public:
 		bool propagate_exceptions = false;
 			
@@ -50,6 +62,20 @@ namespace ifcopenshell {
 			return geometry_library_;
 		}
 
+		// When set, mapped representations are converted once and their results
+		// reused by every mapped item that refers to them.
+		void set_result_cache(const std::shared_ptr<result_cache_t>& cache) { result_cache_ = cache; }
+		const std::shared_ptr<result_cache_t>& result_cache() const { return result_cache_; }
+
+		// Whether the shapes created by this kernel can be used concurrently from
+		// threads other than the one that created them, after prepare_for_sharing().
+		virtual bool results_are_thread_safe() const { return false; }
+
+		// While set, conversions throw IfcGeom::timeout_error once the token has
+		// expired. The token is owned by the caller and must outlive its use here.
+		virtual void set_cancellation_token(const IfcGeom::cancellation_token* token) { cancellation_ = token; }
+		const IfcGeom::cancellation_token* cancellation_token() const { return cancellation_; }
+
 		virtual bool convert_impl(const taxonomy::matrix4::ptr, IfcGeom::ConversionResults&) { throw not_implemented_error(); }
 		virtual bool convert_impl(const taxonomy::point3::ptr, IfcGeom::ConversionResults&) { throw not_implemented_error(); }
 		virtual bool convert_impl(const taxonomy::direction3::ptr, IfcGeom::ConversionResults&) { throw not_implemented_error(); }
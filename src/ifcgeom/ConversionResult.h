@@ -256,6 +256,10 @@ namespace IfcGeom {
 		virtual void Triangulate(ifcopenshell::geometry::Settings settings, const ifcopenshell::geometry::taxonomy::matrix4& place, Representation::Triangulation* t, int item_id, int surface_style_id) const = 0;
 		IfcGeom::Representation::Triangulation* Triangulate(const ifcopenshell::geometry::Settings& settings) const;
 		virtual void Serialize(const ifcopenshell::geometry::taxonomy::matrix4& place, std::string&) const = 0;
+
+		// Called before the shape is cached for reuse. Lazily computed data that would
+		// otherwise be written to the shape when it is used, is computed here.
+		virtual void prepare_for_sharing(const ifcopenshell::geometry::Settings&) const {}
 				
 		virtual int surface_genus() const = 0;
 		virtual bool is_manifold() const = 0;
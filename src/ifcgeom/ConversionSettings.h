@@ -339,6 +339,23 @@ namespace ifcopenshell {
 				static constexpr bool defaultvalue = false;
 			};
 
+			struct ResultQueueSize : public SettingBase<ResultQueueSize, int> {
+				static constexpr const char* const name = "result-queue-size";
+				static constexpr const char* const description = "Stream converted elements through a queue of at most this many elements. Elements are deleted once the "
+					"iterator has moved past them and worker threads wait while the queue is full, so that memory use does not grow with model size. "
+					"The element returned by get() is therefore only valid until the next call to next(). "
+					"The default of 0 keeps all elements until the iterator is destroyed.";
+				static constexpr int defaultvalue = 0;
+			};
+
+			struct ElementTimeout : public SettingBase<ElementTimeout, double> {
+				static constexpr const char* const name = "element-timeout";
+				static constexpr const char* const description = "Wall-clock time budget in seconds for converting a single element. When it is exceeded "
+					"during opening subtraction the element is emitted without openings, otherwise its 'Box' representation is emitted if there is one. "
+					"Kernels check the budget between operations, so it can be exceeded by the duration of one operation. The default of 0 disables the budget.";
+				static constexpr double defaultvalue = 0.;
+			};
+
 			struct ForceSpaceTransparency : public SettingBase<ForceSpaceTransparency, double> {
 				static constexpr const char* const name = "force-space-transparency";
 				static constexpr const char* const description = "Overrides transparency of spaces in geometry output.";
@@ -500,7 +517,7 @@ namespace ifcopenshell {
 		};
 
 		class IFC_GEOM_API Settings : public SettingsContainer<
-                                          std::tuple<MesherLinearDeflection, MesherAngularDeflection, ReorientShells, LengthUnit, PlaneUnit, Precision, OutputDimensionality, LayersetFirst, DisableBooleanResult, NoWireIntersectionCheck, NoWireIntersectionTolerance, PrecisionFactor, DebugBooleanOperations, BooleanAttempt2d, SurfaceColour, WeldVertices, UseWorldCoords, UnifyShapes, UseMaterialNames, ConvertBackUnits, ContextIds, ContextTypes, ContextIdentifiers, IteratorOutput, DisableOpeningSubtractions, ApplyDefaultMaterials, DontEmitNormals, GenerateUvs, ApplyLayerSets, UseElementHierarchy, ValidateQuantities, EdgeArrows, BuildingLocalPlacement, SiteLocalPlacement, ForceSpaceTransparency, CircleSegments, KeepBoundingBoxes, PiecewiseStepType, PiecewiseStepParam, NoParallelMapping, ModelOffset, ModelRotation, TriangulationType>
+                                          std::tuple<MesherLinearDeflection, MesherAngularDeflection, ReorientShells, LengthUnit, PlaneUnit, Precision, OutputDimensionality, LayersetFirst, DisableBooleanResult, NoWireIntersectionCheck, NoWireIntersectionTolerance, PrecisionFactor, DebugBooleanOperations, BooleanAttempt2d, SurfaceColour, WeldVertices, UseWorldCoords, UnifyShapes, UseMaterialNames, ConvertBackUnits, ContextIds, ContextTypes, ContextIdentifiers, IteratorOutput, DisableOpeningSubtractions, ApplyDefaultMaterials, DontEmitNormals, GenerateUvs, ApplyLayerSets, UseElementHierarchy, ValidateQuantities, EdgeArrows, BuildingLocalPlacement, SiteLocalPlacement, ForceSpaceTransparency, CircleSegments, KeepBoundingBoxes, PiecewiseStepType, PiecewiseStepParam, NoParallelMapping, ResultQueueSize, ElementTimeout, ModelOffset, ModelRotation, TriangulationType>
 		>
 		{};
 }
@@ -1,6 +1,9 @@
 #include "Converter.h"
 
 #include "../ifcgeom/IfcGeomElement.h"
+#include "../ifcgeom/cancellation_token.h"
+
+#include <memory>
 
 using namespace ifcopenshell::geometry;
 
@@ -10,9 +13,41 @@ ifcopenshell::geometry::Converter::Converter(const std::string& geometry_library
 {
 	mapping_ = impl::mapping_implementations().construct(file, settings_);
 	kernel_ = kernels::construct(file, geometry_library, mapping_->settings());
+	brep_cache_ = std::make_shared<brep_cache_t>();
+	kernel_->set_result_cache(brep_cache_);
+}
+
+void ifcopenshell::geometry::Converter::share_caches(const Converter& other) {
+	mapping_->share_cache(*other.mapping_);
+	if (kernel_->results_are_thread_safe() && other.kernel_->results_are_thread_safe()) {
+		brep_cache_ = other.brep_cache_;
+		kernel_->set_result_cache(brep_cache_);
+	}
 }
 
 namespace {
+	// Installs a cancellation token on the kernel for the lifetime of the scope
+	class cancellation_scope {
+	public:
+		cancellation_scope(kernels::AbstractKernel* kernel, const IfcGeom::cancellation_token* token)
+			: kernel_(kernel)
+		{
+			kernel_->set_cancellation_token(token);
+		}
+
+		~cancellation_scope() {
+			release();
+		}
+
+		// Operations after this, such as fallbacks, are no longer cancelled
+		void release() {
+			kernel_->set_cancellation_token(nullptr);
+		}
+
+	private:
+		kernels::AbstractKernel* kernel_;
+	};
+
 	void substitute_with_box_based_on_density(IfcGeom::ConversionResults& items, double& density) {
 		int nv = 0;
 		void* box = nullptr;
@@ -40,11 +75,30 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 	IfcGeom::Representation::BRep* shape;
 	IfcGeom::ConversionResults shapes;
 
-	if (!kernel_->convert(representation_node, shapes)) {
+	std::unique_ptr<IfcGeom::cancellation_token> cancellation;
+	const double timeout = settings_.get<ifcopenshell::geometry::settings::ElementTimeout>().get();
+	if (timeout > 0.) {
+		cancellation.reset(new IfcGeom::cancellation_token(timeout));
+	}
+	cancellation_scope scope(kernel_, cancellation.get());
+	// Set when the time budget was exceeded and a simplified element is emitted
+	bool timed_out = false;
+
+	bool converted;
+	try {
+		converted = kernel_->convert(representation_node, shapes);
+	} catch (const IfcGeom::timeout_error&) {
+		scope.release();
+		timed_out = true;
+		shapes.clear();
+		converted = convert_bounding_box_(product, shapes);
+		record_timeout_(product, converted ? "bounding box" : "nothing", cancellation->elapsed_seconds());
+	}
+	if (!converted) {
 		return 0;
 	}
 
-	if (settings_.get<ifcopenshell::geometry::settings::ApplyLayerSets>().get()) {
+	if (!timed_out && settings_.get<ifcopenshell::geometry::settings::ApplyLayerSets>().get()) {
 		ifcopenshell::geometry::layerset_information layerinfo;
 		std::vector<ifcopenshell::geometry::endpoint_connection> neighbours;
 		std::map<IfcUtil::IfcBaseEntity*, ifcopenshell::geometry::layerset_information> neigbour_layers;
@@ -143,8 +197,10 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 	if (settings_.get<ifcopenshell::geometry::settings::ForceSpaceTransparency>().has() && product->declaration().is("IfcSpace")) {
 		for (auto& s : shapes) {
 			if (s.hasStyle()) {
-				// @todo the uglyness
-				const_cast<taxonomy::style*>(&*s.StylePtr())->transparency = settings_.get<ifcopenshell::geometry::settings::ForceSpaceTransparency>().get();
+				// The style is shared through the mapping cache, so a copy is modified
+				auto transparent = taxonomy::style::ptr(s.StylePtr()->clone_());
+				transparent->transparency = settings_.get<ifcopenshell::geometry::settings::ForceSpaceTransparency>().get();
+				s.setStyle(transparent);
 			}
 		}
 	}
@@ -168,7 +224,7 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 	// Note that openings for IfcOpeningElements are not processed
 	auto openings = mapping_->find_openings(product);
 
-	if (!settings_.get<ifcopenshell::geometry::settings::DisableOpeningSubtractions>().get() && openings && openings->size()) {
+	if (!timed_out && !settings_.get<ifcopenshell::geometry::settings::DisableOpeningSubtractions>().get() && openings && openings->size()) {
 		representation_id_builder << "-openings";
 		for (auto it = openings->begin(); it != openings->end(); ++it) {
 			representation_id_builder << "-" << (*it)->id();
@@ -201,6 +257,11 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 			} else {
 				kernel_->convert_openings(product, opening_items, shapes, *place, opened_shapes);
 			}
+		} catch (const IfcGeom::timeout_error&) {
+			scope.release();
+			timed_out = true;
+			opened_shapes = shapes;
+			record_timeout_(product, "without openings", cancellation->elapsed_seconds());
 		} catch (const std::exception& e) {
 			Logger::Message(Logger::LOG_ERROR, std::string("Error processing openings for: ") + e.what() + ":", product);
 			caught_error = true;
@@ -237,6 +298,11 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 		}
 	}
 
+	if (timed_out) {
+		// Not to be shared with products that were converted in full
+		representation_id_builder << "-timeout";
+	}
+
 	shape = new IfcGeom::Representation::BRep(settings_, product_type, representation_id_builder.str(), shapes);
 
 	std::string context_string = "";
@@ -385,6 +451,44 @@ IfcGeom::BRepElement* ifcopenshell::geometry::Converter::create_brep_for_represe
 	);
 }
 
+bool ifcopenshell::geometry::Converter::convert_bounding_box_(const IfcUtil::IfcBaseEntity* product, IfcGeom::ConversionResults& shapes) {
+	try {
+		auto product_shape = product->get("Representation");
+		if (product_shape.isNull()) {
+			return false;
+		}
+		aggregate_of_instance::ptr representations = ((IfcUtil::IfcBaseClass*) product_shape)->as<IfcUtil::IfcBaseEntity>()->get("Representations");
+		if (!representations) {
+			return false;
+		}
+		for (auto& r : *representations) {
+			if (r->as<IfcUtil::IfcBaseEntity>()->get_value<std::string>("RepresentationIdentifier", "") != "Box") {
+				continue;
+			}
+			auto item = mapping_->map(r);
+			if (item && kernel_->convert(item, shapes) && !shapes.empty()) {
+				return true;
+			}
+		}
+	} catch (const std::exception& e) {
+		Logger::Error(e);
+	}
+	return false;
+}
+
+void ifcopenshell::geometry::Converter::record_timeout_(const IfcUtil::IfcBaseEntity* product, const std::string& fallback, double seconds) {
+	timed_out_.push_back({
+		(int) product->id(),
+		product->get_value<std::string>("GlobalId", ""),
+		product->declaration().name(),
+		fallback,
+		seconds
+	});
+	std::stringstream ss;
+	ss << "Conversion exceeded the time budget of " << settings_.get<ifcopenshell::geometry::settings::ElementTimeout>().get() << "s, emitted " << fallback << " for:";
+	Logger::Warning(ss.str(), product);
+}
+
 IfcGeom::ConversionResults ifcopenshell::geometry::Converter::convert(IfcUtil::IfcBaseClass * item)
 {
 	std::clock_t map_start = std::clock();
@@ -11,17 +11,34 @@
 
 #include <boost/function.hpp>
 
+#include <memory>
+
 namespace ifcopenshell { namespace geometry {
 
+	// An element of which the conversion exceeded the ElementTimeout budget
+	struct timed_out_element {
+		int product_id;
+		std::string product_guid;
+		std::string product_type;
+		// What was emitted instead: "without openings", "bounding box" or "nothing"
+		std::string fallback;
+		double seconds;
+	};
+
 	class Converter {
 	public:
 		typedef boost::shared_ptr<IfcGeom::Representation::BRep> brep_ptr;
+		typedef ifcopenshell::geometry::kernels::AbstractKernel::result_cache_t brep_cache_t;
 	private:
 		std::string geometry_library_;
 		ifcopenshell::geometry::abstract_mapping* mapping_;
 		ifcopenshell::geometry::kernels::AbstractKernel* kernel_;
 		ifcopenshell::geometry::Settings settings_;
-		std::map<ifcopenshell::geometry::taxonomy::ptr, brep_ptr, ifcopenshell::geometry::taxonomy::less_functor> cache_;
+		std::shared_ptr<brep_cache_t> brep_cache_;
+		std::vector<timed_out_element> timed_out_;
+
+		bool convert_bounding_box_(const IfcUtil::IfcBaseEntity* product, IfcGeom::ConversionResults& shapes);
+		void record_timeout_(const IfcUtil::IfcBaseEntity* product, const std::string& fallback, double seconds);
 
 	public:
 		ifcopenshell::geometry::kernels::AbstractKernel* kernel() { return kernel_; }
@@ -32,6 +49,22 @@ namespace ifcopenshell { namespace geometry {
 
 		ifcopenshell::geometry::abstract_mapping* mapping() const { return mapping_; }
 
+		const std::shared_ptr<brep_cache_t>& brep_cache() const { return brep_cache_; }
+
+		// Uses the mapping and BRep caches of another Converter for the same file and
+		// settings, so that Converters on different threads reuse each other's work.
+		// The BRep cache is only shared when the kernel's shapes are thread-safe.
+		void share_caches(const Converter& other);
+
+		// Elements that exceeded the ElementTimeout budget since the last call to
+		// take_timed_out_elements(), in the order in which they were converted.
+		const std::vector<timed_out_element>& timed_out_elements() const { return timed_out_; }
+		std::vector<timed_out_element> take_timed_out_elements() {
+			std::vector<timed_out_element> taken;
+			taken.swap(timed_out_);
+			return taken;
+		}
+
 		/*
 		virtual NativeElement<double, double>* convert(
 			const IteratorSettings& settings, IfcUtil::IfcBaseClass* representation,
@@ -68,6 +68,8 @@
 #include "../ifcgeom/Converter.h"
 #include "../ifcgeom/abstract_mapping.h"
 #include "../ifcgeom/GeometrySerializer.h"
+#include "../ifcgeom/work_stealing_pool.h"
+#include "../ifcgeom/task_cost_estimator.h"
 
 #ifdef IFOPSH_WITH_OPENCASCADE
 #include <Standard_Failure.hxx>
@@ -84,6 +86,8 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <condition_variable>
+#include <memory>
 
 namespace {
 	struct geometry_conversion_result {
@@ -99,6 +103,11 @@ namespace {
 
 		std::vector<IfcGeom::BRepElement*> breps;
 		std::vector<IfcGeom::Element*> elements;
+
+		// See IfcGeom::task_cost
+		std::string product_guid;
+		double predicted_cost = 0.;
+		double elapsed_ms = -1.;
 	};
 }
 
@@ -116,6 +125,9 @@ namespace IfcGeom {
 		std::vector<geometry_conversion_result> tasks_;
 		std::vector<geometry_conversion_result>::iterator task_iterator_;
 
+		// Milliseconds per task from a previous run, keyed by the GlobalId of its first product
+		std::map<std::string, double> recorded_timings_;
+
 		std::list<IfcGeom::Element*> all_processed_elements_;
 		std::list<IfcGeom::BRepElement*> all_processed_native_elements_;
 
@@ -123,7 +135,12 @@ namespace IfcGeom {
 		typename std::list<IfcGeom::BRepElement*>::const_iterator native_task_result_iterator_;
 
 		std::mutex element_ready_mutex_;
+		std::condition_variable element_ready_cv_;
+		std::condition_variable element_consumed_cv_;
 		bool task_result_ptr_initialized = false;
+		// When non-zero, elements are released once next() moves past them and
+		// workers wait while this many elements are pending.
+		size_t result_queue_size_ = 0;
 		// ?
 		size_t async_elements_returned_ = 0;
 		size_t task_result_index_ = 0;
@@ -139,8 +156,9 @@ namespace IfcGeom {
 		// When single-threaded
 		ifcopenshell::geometry::Converter* converter_;
 		
-		// When multi-threaded
+		// When multi-threaded, kernel_pool[i] is only used by worker i of pool_
 		std::vector<ifcopenshell::geometry::Converter*> kernel_pool;
+		std::unique_ptr<work_stealing_pool> pool_;
 
 		// The object is fetched beforehand to be sure that get() returns a valid element
 		TriangulationElement* current_triangulation;
@@ -165,10 +183,42 @@ namespace IfcGeom {
 
 		std::array<std::chrono::high_resolution_clock::time_point, 4> time_points;
 
+		std::vector<ifcopenshell::geometry::timed_out_element> timed_out_;
+		std::mutex timed_out_mutex_;
+
 		/// @todo public/private sections all over the place: move all public to the beginning of the class
 	public:
 		void set_cache(GeometrySerializer* cache) { cache_ = cache; }
 
+		/// Timings obtained from task_costs() on a previous run, to be used in
+		/// ordering the tasks. Needs to be called before initialize().
+		void set_recorded_timings(const std::map<std::string, double>& timings) { recorded_timings_ = timings; }
+
+		void set_recorded_timings(const std::vector<task_cost>& costs) {
+			recorded_timings_.clear();
+			for (auto& c : costs) {
+				if (c.actual >= 0. && !c.product_guid.empty()) {
+					recorded_timings_[c.product_guid] = c.actual;
+				}
+			}
+		}
+
+		/// Predicted and actual cost per task, complete once all elements have been processed.
+		std::vector<task_cost> task_costs() const {
+			std::vector<task_cost> costs;
+			costs.reserve(tasks_.size());
+			for (auto& t : tasks_) {
+				costs.push_back({ t.representation ? (int) t.representation->id() : -1, t.product_guid, t.predicted_cost, t.elapsed_ms });
+			}
+			return costs;
+		}
+
+		/// Elements that exceeded the element-timeout setting and were emitted in simplified form
+		std::vector<ifcopenshell::geometry::timed_out_element> timed_out_elements() {
+			std::lock_guard<std::mutex> lk(timed_out_mutex_);
+			return timed_out_;
+		}
+
 		const std::string& unit_name() const { return unit_name_; }
 		double unit_magnitude() const { return unit_magnitude_; }
 		// Check if error occurred during iterator initialization or iteration over elements.
@@ -195,20 +245,28 @@ namespace IfcGeom {
 			}
 
 			time_points[0] = high_resolution_clock::now();
+			// Lazily loaded files cannot be read from multiple threads
+			ifc_file->load_all();
+			result_queue_size_ = (size_t) std::max(settings_.get<ifcopenshell::geometry::settings::ResultQueueSize>().get(), 0);
 			converter_ = new ifcopenshell::geometry::Converter(geometry_library_, ifc_file, settings_);
 			std::vector<ifcopenshell::geometry::geometry_conversion_task> reps;
-			if (num_threads_ != 1) {
-				// @todo this shouldn't be necessary with properly immutable taxonomy items
-				converter_->mapping()->use_caching() = false;
-			}
 			converter_->mapping()->get_representations(reps, filters_);
 			time_points[1] = high_resolution_clock::now();
 
+			task_cost_estimator estimate_cost;
+
 			for (auto& task : reps) {
 				geometry_conversion_result res;
 				res.index = task.index;
+				res.representation = task.representation;
+				res.predicted_cost = estimate_cost(task.representation, task.products);
+				if (task.products && task.products->size()) {
+					auto first = (*task.products->begin())->as<IfcUtil::IfcBaseEntity>();
+					if (first && first->declaration().is("IfcRoot")) {
+						res.product_guid = (std::string) first->get("GlobalId");
+					}
+				}
 				if (!settings_.get<ifcopenshell::geometry::settings::NoParallelMapping>().get()) {
-					res.representation = task.representation;
 					res.products_2 = task.products;
 				} else {
 					res.item = converter_->mapping()->map(task.representation);
@@ -223,6 +281,21 @@ namespace IfcGeom {
 				tasks_.push_back(res);
 			}
 
+			if (!recorded_timings_.empty()) {
+				auto costs = task_costs();
+				task_cost_estimator::apply_recorded_timings(costs, recorded_timings_);
+				for (size_t i = 0; i < costs.size(); ++i) {
+					tasks_[i].predicted_cost = costs[i].predicted;
+				}
+			}
+
+			if (num_threads_ != 1) {
+				// Longest first, so that expensive tasks do not end up running alone at the end
+				std::stable_sort(tasks_.begin(), tasks_.end(), [](const geometry_conversion_result& a, const geometry_conversion_result& b) {
+					return a.predicted_cost > b.predicted_cost;
+				});
+			}
+
 			size_t num_products = 0;
 			for (auto& r : tasks_) {
 				num_products += !settings_.get<ifcopenshell::geometry::settings::NoParallelMapping>().get() ? r.products_2->size() : r.products.size();
@@ -294,18 +367,51 @@ namespace IfcGeom {
 				return;
 			}
 
-			std::lock_guard<std::mutex> lk(element_ready_mutex_);
+			{
+				std::unique_lock<std::mutex> lk(element_ready_mutex_);
+
+				if (result_queue_size_ && num_threads_ != 1) {
+					element_consumed_cv_.wait(lk, [this]() {
+						return all_processed_elements_.size() < result_queue_size_ || terminating_;
+					});
+				}
 
-			all_processed_elements_.insert(all_processed_elements_.end(), rep->elements.begin(), rep->elements.end());
-			all_processed_native_elements_.insert(all_processed_native_elements_.end(), rep->breps.begin(), rep->breps.end());
+				all_processed_elements_.insert(all_processed_elements_.end(), rep->elements.begin(), rep->elements.end());
+				all_processed_native_elements_.insert(all_processed_native_elements_.end(), rep->breps.begin(), rep->breps.end());
 
-			if (!task_result_ptr_initialized) {
-				task_result_iterator_ = all_processed_elements_.begin();
-				native_task_result_iterator_ = all_processed_native_elements_.begin();
-				task_result_ptr_initialized = true;
+				if (!task_result_ptr_initialized) {
+					task_result_iterator_ = all_processed_elements_.begin();
+					native_task_result_iterator_ = all_processed_native_elements_.begin();
+					task_result_ptr_initialized = true;
+				}
+
+				progress_ = (int) (++processed_ * 100 / tasks_.size());
+			}
+
+			element_ready_cv_.notify_all();
+		}
+
+		// Deletes the oldest element, the one the consumer has moved past.
+		void release_front_() {
+			IfcGeom::Element* elem = all_processed_elements_.front();
+			IfcGeom::BRepElement* brep = all_processed_native_elements_.front();
+			all_processed_elements_.pop_front();
+			all_processed_native_elements_.pop_front();
+			// For native output the element is the brep itself
+			if (brep != elem) {
+				delete brep;
 			}
+			delete elem;
+		}
 
-			progress_ = (int) (++processed_ * 100 / tasks_.size());
+		// The mapped item and element pointers of a task are no longer needed
+		// once its elements are queued.
+		void release_task_data_(geometry_conversion_result* rep) {
+			rep->item.reset();
+			rep->products_2.reset();
+			std::vector<std::pair<const IfcUtil::IfcBaseEntity*, ifcopenshell::geometry::taxonomy::matrix4::ptr>>().swap(rep->products);
+			std::vector<IfcGeom::BRepElement*>().swap(rep->breps);
+			std::vector<IfcGeom::Element*>().swap(rep->elements);
 		}
 
 		void process_concurrently() {
@@ -317,77 +423,57 @@ namespace IfcGeom {
 			kernel_pool.reserve(conc_threads);
 			for (unsigned i = 0; i < conc_threads; ++i) {
 				kernel_pool.push_back(new ifcopenshell::geometry::Converter(geometry_library_, ifc_file, settings_));
+				kernel_pool.back()->share_caches(*converter_);
 			}
 
-			std::vector<std::future<geometry_conversion_result*>> threadpool;			
-			
-			for (auto& rep : tasks_) {
-				ifcopenshell::geometry::Converter* K = nullptr;
-				if (threadpool.size() < kernel_pool.size()) {
-					K = kernel_pool[threadpool.size()];
-				}
-
-				while (threadpool.size() == conc_threads) {
-					for (int i = 0; i < (int)threadpool.size(); i++) {
-						auto& fu = threadpool[i];
-						std::future_status status;
-						status = fu.wait_for(std::chrono::seconds(0));
-						if (status == std::future_status::ready) {
-							process_finished_rep(fu.get());							
-
-							std::swap(threadpool[i], threadpool.back());
-							threadpool.pop_back();
-							std::swap(kernel_pool[i], kernel_pool.back());
-							K = kernel_pool.back();
-							break;
-						} // if
-					}   // for
-				}	 // while
-
-				std::future<geometry_conversion_result*> fu = std::async(
-					std::launch::async, [this](
-						ifcopenshell::geometry::Converter* kernel,
-						ifcopenshell::geometry::Settings settings,
-						geometry_conversion_result* rep) {
-							// Catch exceptions to be safe from freezing the iterator.
-							try {
-								this->create_element_(kernel, settings, rep);
-							} catch (const std::exception& e) {
-								Logger::Error(
-									std::string("Exception '") + e.what() + 
-									std::string("' occurred while iterator was creating a shape: "), 
-									rep->item->instance
-								);
-								had_error_processing_elements_ = true;
-							} catch (...) {
-								Logger::Error(
-									"Unknown exception occurred while iteartor was creating a shape: ", 
-									rep->item->instance
-								);
-								had_error_processing_elements_ = true;
-							}
-							return rep;
-						},
-					K,
-					std::ref(settings_),
-					&rep);
-
-				if (terminating_) {
-					break;
-				}
+			pool_.reset(new work_stealing_pool(conc_threads));
 
-				threadpool.emplace_back(std::move(fu));
+			for (auto& rep : tasks_) {
+				pool_->submit([this, &rep](size_t worker) {
+					if (terminating_) {
+						return;
+					}
+					auto t0 = std::chrono::steady_clock::now();
+					// Catch exceptions to be safe from freezing the iterator.
+					try {
+						this->create_element_(kernel_pool[worker], settings_, &rep);
+					} catch (const std::exception& e) {
+						Logger::Error(
+							std::string("Exception '") + e.what() + 
+							std::string("' occurred while iterator was creating a shape: "), 
+							rep.item ? rep.item->instance : nullptr
+						);
+						had_error_processing_elements_ = true;
+					} catch (...) {
+						Logger::Error(
+							"Unknown exception occurred while iteartor was creating a shape: ", 
+							rep.item ? rep.item->instance : nullptr
+						);
+						had_error_processing_elements_ = true;
+					}
+					rep.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+					process_finished_rep(&rep);
+					if (result_queue_size_) {
+						release_task_data_(&rep);
+					}
+				});
 			}
 
-			for (auto& fu : threadpool) {
-				process_finished_rep(fu.get());
-			}
+			pool_->wait();
 
-			finished_ = true;
+			{
+				std::lock_guard<std::mutex> lk(element_ready_mutex_);
+				finished_ = true;
+			}
+			element_ready_cv_.notify_all();
 
 			Logger::SetProduct(boost::none);
 
 			if (!terminating_) {
+				auto stats = pool_->stats();
+				Logger::Notice("Geometry workers: " + std::to_string(stats.workers) +
+					", utilization " + std::to_string((int) (stats.utilization * 100. + 0.5)) + "%" +
+					", " + std::to_string(stats.stolen) + " of " + std::to_string(stats.executed) + " tasks stolen");
 				Logger::Status("\rDone creating geometry (" + boost::lexical_cast<std::string>(all_processed_elements_.size()) +
 					" objects)								");
 			}
@@ -449,6 +535,16 @@ namespace IfcGeom {
 			return progress_;
 		}
 
+		/// Number of tasks not yet picked up by a geometry worker, zero when single-threaded.
+		size_t queue_depth() const {
+			return pool_ ? pool_->queue_depth() : 0;
+		}
+
+		/// Fraction of worker time spent converting geometry, zero when single-threaded.
+		double worker_utilization() const {
+			return pool_ ? pool_->utilization() : 0.;
+		}
+
 		std::string getLog() const { return Logger::GetLog(); }
 
 		IfcParse::IfcFile* file() const { return ifc_file; }
@@ -503,7 +599,9 @@ namespace IfcGeom {
 			geometry_conversion_result* task = nullptr;
 			for (; task_iterator_ < tasks_.end();) {
 				task = &*task_iterator_++;
+				auto t0 = std::chrono::steady_clock::now();
 				create_element_(converter_, settings_, task);
+				task->elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
 				if (task->elements.empty()) {
 					task = nullptr;
 				} else {
@@ -512,7 +610,11 @@ namespace IfcGeom {
 			}
 			if (task) {
 				process_finished_rep(task);
-				return task->item->instance->as<IfcUtil::IfcBaseClass>();
+				auto product = task->item->instance->as<IfcUtil::IfcBaseClass>();
+				if (result_queue_size_) {
+					release_task_data_(task);
+				}
+				return product;
 			} else {
 				return nullptr;
 			}
@@ -545,6 +647,17 @@ namespace IfcGeom {
 				return kernel->create_brep_for_representation_and_product(rep->item, product, place);
 			}));
 
+			auto timed_out = kernel->take_timed_out_elements();
+			if (!timed_out.empty()) {
+				// The other products reuse the simplified shape of the first
+				const auto first = timed_out.front();
+				for (auto it = rep->products.begin() + 1; it != rep->products.end(); ++it) {
+					timed_out.push_back({ (int) it->first->id(), it->first->get_value<std::string>("GlobalId", ""), it->first->declaration().name(), first.fallback, first.seconds });
+				}
+				std::lock_guard<std::mutex> lk(timed_out_mutex_);
+				timed_out_.insert(timed_out_.end(), timed_out.begin(), timed_out.end());
+			}
+
 			if (!brep) {
 				return;
 			}
@@ -613,21 +726,20 @@ namespace IfcGeom {
 		}
 
 		bool wait_for_element() {
-			while (true) {
-				size_t s;
-				{
-					std::lock_guard<std::mutex> lk(element_ready_mutex_);
-					s = all_processed_elements_.size();
-				}
-				if (s > async_elements_returned_) {
-					++async_elements_returned_;
-					return true;
-				} else if (finished_) {
-					return false;
-				} else {
-					std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			std::unique_lock<std::mutex> lk(element_ready_mutex_);
+			element_ready_cv_.wait(lk, [this]() {
+				return all_processed_elements_.size() > async_elements_returned_ || finished_;
+			});
+			if (all_processed_elements_.size() > async_elements_returned_) {
+				++async_elements_returned_;
+				if (result_queue_size_) {
+					// Released elements have been removed from the front
+					task_result_iterator_ = all_processed_elements_.begin();
+					native_task_result_iterator_ = all_processed_native_elements_.begin();
 				}
+				return true;
 			}
+			return false;
 		}
 
 		void log_timepoints() const {
@@ -646,6 +758,30 @@ namespace IfcGeom {
 				duration<double, std::milli> ms_double = (*it) - (*jt);
 				Logger::Notice(labels[std::distance(time_points.begin(), jt)] + " took " + std::to_string(ms_double.count()) + "ms");
 			}
+
+			log_task_costs();
+		}
+
+		// Reports how well the predicted cost ranks the tasks and which tasks took longest
+		void log_task_costs() const {
+			auto costs = task_costs();
+			costs.erase(std::remove_if(costs.begin(), costs.end(), [](const task_cost& c) { return c.actual < 0.; }), costs.end());
+			if (costs.empty()) {
+				return;
+			}
+
+			Logger::Notice("Rank correlation of predicted and actual cost over " + std::to_string(costs.size()) + " tasks: " +
+				std::to_string(task_cost_estimator::rank_correlation(costs)));
+
+			const size_t n = std::min(costs.size(), (size_t) 5);
+			std::partial_sort(costs.begin(), costs.begin() + n, costs.end(), [](const task_cost& a, const task_cost& b) {
+				return a.actual > b.actual;
+			});
+			for (size_t i = 0; i < n; ++i) {
+				Logger::Notice("Representation #" + std::to_string(costs[i].representation_id) +
+					(costs[i].product_guid.empty() ? "" : " of " + costs[i].product_guid) +
+					" took " + std::to_string(costs[i].actual) + "ms, predicted cost " + std::to_string(costs[i].predicted));
+			}
 		}
 
 	public:
@@ -668,6 +804,17 @@ namespace IfcGeom {
 		const IfcUtil::IfcBaseClass* next() {
 			using std::chrono::high_resolution_clock;
 			if (num_threads_ != 1) {
+				if (result_queue_size_) {
+					{
+						std::lock_guard<std::mutex> lk(element_ready_mutex_);
+						if (!all_processed_elements_.empty()) {
+							release_front_();
+							--async_elements_returned_;
+						}
+					}
+					element_consumed_cv_.notify_all();
+				}
+
 				if (!wait_for_element()) {
 					Logger::SetProduct(boost::none);
 					time_points[3] = high_resolution_clock::now();
@@ -675,8 +822,25 @@ namespace IfcGeom {
 					return nullptr;
 				}
 
-				task_result_iterator_++;
-				native_task_result_iterator_++;
+				if (!result_queue_size_) {
+					task_result_iterator_++;
+					native_task_result_iterator_++;
+				}
+
+				return (*task_result_iterator_)->product();
+			} else if (result_queue_size_) {
+				if (!all_processed_elements_.empty()) {
+					release_front_();
+				}
+				if (all_processed_elements_.empty() && !create()) {
+					Logger::SetProduct(boost::none);
+					time_points[3] = high_resolution_clock::now();
+					log_timepoints();
+					return nullptr;
+				}
+
+				task_result_iterator_ = all_processed_elements_.begin();
+				native_task_result_iterator_ = all_processed_native_elements_.begin();
 
 				return (*task_result_iterator_)->product();
 			} else {
@@ -883,11 +1047,18 @@ namespace IfcGeom {
 
 		~Iterator() {
 			if (num_threads_ != 1) {
-				terminating_ = true;
+				{
+					std::lock_guard<std::mutex> lk(element_ready_mutex_);
+					terminating_ = true;
+				}
+				element_consumed_cv_.notify_all();
 
 				if (init_future_.valid()) {
 					init_future_.wait();
 				}
+
+				// Workers need to be joined before their kernels are deleted
+				pool_.reset();
 			}
 
 			if (owns_ifc_file) {
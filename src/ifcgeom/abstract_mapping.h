@@ -6,10 +6,12 @@
 #include "../ifcgeom/taxonomy.h"
 #include "../ifcgeom/IteratorSettings.h"
 #include "../ifcgeom/ConversionSettings.h"
+#include "../ifcgeom/sharded_cache.h"
 
 #include <boost/function.hpp>
 
 #include <map>
+#include <memory>
 #include <string>
 #include <tuple>
 
@@ -26,10 +28,15 @@ namespace geometry {
 	typedef boost::function<bool(IfcUtil::IfcBaseEntity*)> filter_t;
     
     class abstract_mapping {
+	public:
+		// Mapped taxonomy items by identity of the IFC instance
+		typedef IfcGeom::sharded_cache<uint32_t, taxonomy::ptr> cache_t;
+
 	protected:
 		Settings settings_;
 
 		bool use_caching_ = true;
+		std::shared_ptr<cache_t> cache_ = std::make_shared<cache_t>();
 
 	public:
 		abstract_mapping(Settings& s) : settings_(s) {}
@@ -53,6 +60,13 @@ namespace geometry {
 
 		bool use_caching() const { return use_caching_; }
 		bool& use_caching() { return use_caching_; }
+
+		const std::shared_ptr<cache_t>& cache() const { return cache_; }
+
+		// Mappings of the same file and settings, e.g. one per worker thread, can
+		// use a single cache. Cached items are never modified after they have been
+		// inserted, so they can be read concurrently.
+		void share_cache(const abstract_mapping& other) { cache_ = other.cache_; }
     };
 
 	namespace impl {
@@ -0,0 +1,83 @@
+/********************************************************************************
+ *																			  *
+ * This file is part of IfcOpenShell.										   *
+ *																			  *
+ * IfcOpenShell is free software: you can redistribute it and/or modify		 *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or		  *
+ * (at your option) any later version.										  *
+ *																			  *
+ * IfcOpenShell is distributed in the hope that it will be useful,			  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of			   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the				 *
+ * Lesser GNU General Public License for more details.						  *
+ *																			  *
+ * You should have received a copy of the Lesser GNU General Public License	 *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.		 *
+ *																			  *
+ ********************************************************************************/
+
+#ifndef CANCELLATION_TOKEN_H
+#define CANCELLATION_TOKEN_H
+
+#include "../ifcparse/IfcException.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace IfcGeom {
+
+	// Thrown from a conversion that has exceeded its time budget or was cancelled
+	class timeout_error : public IfcParse::IfcException {
+	public:
+		timeout_error()
+			: IfcParse::IfcException("Conversion exceeded its time budget") {}
+	};
+
+	// Cooperative cancellation of the conversion of a single element. Kernels
+	// poll expired() in long running operations, or call check() between steps
+	// at which the conversion can be abandoned. Nothing is interrupted
+	// preemptively, so the budget is exceeded by at most one such step.
+	class cancellation_token {
+	public:
+		typedef std::chrono::steady_clock clock;
+
+		// A budget of zero or less seconds never expires
+		explicit cancellation_token(double seconds = 0.)
+			: started_(clock::now())
+			, has_deadline_(seconds > 0.)
+			, deadline_(started_ + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(has_deadline_ ? std::min(seconds, 1.e9) : 0.)))
+		{}
+
+		cancellation_token(const cancellation_token&) = delete;
+		cancellation_token& operator=(const cancellation_token&) = delete;
+
+		// Can be called from any thread
+		void cancel() { cancelled_ = true; }
+
+		bool expired() const {
+			return cancelled_ || (has_deadline_ && clock::now() >= deadline_);
+		}
+
+		void check() const {
+			if (expired()) {
+				throw timeout_error();
+			}
+		}
+
+		double elapsed_seconds() const {
+			return std::chrono::duration<double>(clock::now() - started_).count();
+		}
+
+	private:
+		clock::time_point started_;
+		bool has_deadline_;
+		clock::time_point deadline_;
+		std::atomic<bool> cancelled_{ false };
+	};
+
+}
+
+#endif
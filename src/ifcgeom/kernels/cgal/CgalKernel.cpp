@@ -911,6 +911,9 @@ bool ifcopenshell::geometry::kernels::CgalKernel::convert_openings(const IfcUtil
 	auto iit = second_operand_instances.begin();
 	auto pit = second_operands.begin();
 	for (auto& nef : second_operands_nef) {
+		if (cancellation_) {
+			cancellation_->check();
+		}
 		auto& inst = *iit++;
 		auto& entity_shape = *pit++;
 		if (!preprocess_boolean_operand(inst, first_operands, first_operands_nef, all_operand_planes, entity_shape, nef, PP_MINKOWSKY_DILATE/*PP_SNAP_PLANES_TO_FIRST_OPERAND*/)) {
@@ -929,6 +932,9 @@ bool ifcopenshell::geometry::kernels::CgalKernel::convert_openings(const IfcUtil
 	auto it = entity_shapes.begin();
 	auto nit = first_operands_nef.begin();
 	for (auto& entity_shape : first_operands) {
+		if (cancellation_) {
+			cancellation_->check();
+		}
 		auto& a = *nit;
 
 		if constexpr (false) {
@@ -1567,7 +1573,7 @@ bool CgalKernel::process_as_2d_polygon(const taxonomy::boolean_result::ptr br, s
 	const auto& op_0_matrix_2_3 = extrusions[0].second->matrix->ccomponents()(2, 3);
 	if (std::find_if(extrusions.begin() + 1, extrusions.end(), [&op_0_matrix_2_3](extrusion_pair& p) {
 		auto ex = p.second;
-		return op_0_matrix_2_3 < ex->matrix->components()(2, 3);
+		return op_0_matrix_2_3 < ex->matrix->ccomponents()(2, 3);
 	}) != extrusions.end()) {
 		return false;
 	}
@@ -2031,6 +2037,9 @@ bool CgalKernel::convert_impl(const taxonomy::boolean_result::ptr br, Conversion
 
 		auto entity_instance = li.first;
 		for (auto& entity_shape : li.second) {
+			if (cancellation_) {
+				cancellation_->check();
+			}
 
 			CGAL::Nef_polyhedron_3<Kernel_> nef;
 			if (!preprocess_boolean_operand(entity_instance, ops, nefops, all_operand_planes, entity_shape, nef,
@@ -2061,6 +2070,9 @@ bool CgalKernel::convert_impl(const taxonomy::boolean_result::ptr br, Conversion
 	}
 
 	if (br->operation == taxonomy::boolean_result::SUBTRACTION && second_operand_collector_size) {
+		if (cancellation_) {
+			cancellation_->check();
+		}
 		a -= second_operand_collector.get_union();
 	}
 
@@ -45,6 +45,20 @@ namespace {
 	}
 }
 
+void ifcopenshell::geometry::OpenCascadeShape::prepare_for_sharing(const ifcopenshell::geometry::Settings& settings) const {
+	// Meshing stores the triangulation on the faces of the shape. Faces that are
+	// already meshed with the same deflection are left untouched by Triangulate(),
+	// so that copies of the shape can be triangulated concurrently afterwards.
+	if (settings.get<settings::IteratorOutput>().get() != settings::TRIANGULATED) {
+		return;
+	}
+	try {
+		BRepMesh_IncrementalMesh(shape_, settings.get<settings::MesherLinearDeflection>().get(), false, settings.get<settings::MesherAngularDeflection>().get());
+	} catch (...) {
+		Logger::Message(Logger::LOG_ERROR, "Failed to triangulate shape");
+	}
+}
+
 void ifcopenshell::geometry::OpenCascadeShape::Triangulate(ifcopenshell::geometry::Settings settings, const ifcopenshell::geometry::taxonomy::matrix4& place, IfcGeom::Representation::Triangulation* t, int item_id, int surface_style_id) const {
 
 	// @todo remove duplication with OpenCascadeKernel::convert(const taxonomy::matrix4::ptr matrix, gp_GTrsf& trsf);
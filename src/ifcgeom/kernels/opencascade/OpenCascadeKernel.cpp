@@ -47,6 +47,7 @@ bool IfcGeom::OpenCascadeKernel::convert_openings(const IfcUtil::IfcBaseEntity*
 	bst.attempt_2d = settings_.get<settings::BooleanAttempt2d>().get();
 	bst.debug = settings_.get<settings::DebugBooleanOperations>().get();
 	bst.precision = settings_.get<settings::Precision>().get();
+	bst.cancellation = cancellation_;
 
 	std::vector< std::pair<double, TopoDS_Shape> > opening_vector;
 
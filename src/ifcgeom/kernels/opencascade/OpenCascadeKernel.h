@@ -103,6 +103,9 @@ public:
 		, precision_(settings.get<ifcopenshell::geometry::settings::Precision>().get())
 	{}
 
+	// Booleans are performed non-destructively and shapes are meshed before they are shared
+	virtual bool results_are_thread_safe() const { return true; }
+
 	bool convert(const ifcopenshell::geometry::taxonomy::extrusion::ptr, TopoDS_Shape&);
 	bool convert(const ifcopenshell::geometry::taxonomy::face::ptr, TopoDS_Shape&, bool reversed_surface = false);
 	bool convert(const ifcopenshell::geometry::taxonomy::loop::ptr, TopoDS_Wire&);
@@ -29,6 +29,11 @@
 #include <ShapeAnalysis_Edge.hxx>
 #include <Bnd_OBB.hxx>
 
+#if OCC_VERSION_HEX >= 0x70500
+#include <Message_ProgressIndicator.hxx>
+#include <Message_ProgressScope.hxx>
+#endif
+
 #include <vector>
 #include <thread>
 
@@ -845,9 +850,33 @@ bool IfcGeom::util::points_on_planar_face_generator::operator()(gp_Pnt& p) {
 }
 
 
+#if OCC_VERSION_HEX >= 0x70500
+namespace {
+	// Lets BOPAlgo abandon a running operation once the element's time budget is exceeded
+	class cancellation_progress : public Message_ProgressIndicator {
+	public:
+		cancellation_progress(const IfcGeom::cancellation_token& token)
+			: token_(token) {}
+
+		virtual Standard_Boolean UserBreak() override {
+			return token_.expired();
+		}
+
+		virtual void Show(const Message_ProgressScope&, const Standard_Boolean) override {}
+
+	private:
+		const IfcGeom::cancellation_token& token_;
+	};
+}
+#endif
+
 bool IfcGeom::util::boolean_operation(const boolean_settings& settings, const TopoDS_Shape& a_input, const TopTools_ListOfShape& b_input, BOPAlgo_Operation op, TopoDS_Shape& result, double fuzziness) {
 	using namespace std::string_literals;
 
+	if (settings.cancellation) {
+		settings.cancellation->check();
+	}
+
 	const bool do_unify = true;
 	const bool do_subtraction_eliminate_disjoint_bbox = true;
 	const bool do_subtraction_eliminate_touching = true;
@@ -1149,7 +1178,21 @@ bool IfcGeom::util::boolean_operation(const boolean_settings& settings, const To
 	{
 		PERF("boolean operation: build");
 
+#if OCC_VERSION_HEX >= 0x70500
+		if (settings.cancellation) {
+			Handle(Message_ProgressIndicator) progress = new cancellation_progress(*settings.cancellation);
+			builder->Build(progress->Start());
+		} else {
+			builder->Build();
+		}
+#else
 		builder->Build();
+#endif
+	}
+	if (settings.cancellation && settings.cancellation->expired()) {
+		// An interrupted build is not done, abandon rather than retry with other settings
+		delete builder;
+		throw IfcGeom::timeout_error();
 	}
 	if (builder->IsDone()) {
 		if (builder->DSFiller()->HasWarning(STANDARD_TYPE(BOPAlgo_AlertAcquiredSelfIntersection))) {
@@ -30,6 +30,8 @@
 #include <TopTools_IndexedMapOfShape.hxx>
 #include <BOPAlgo_Operation.hxx>
 
+#include "../../cancellation_token.h"
+
 namespace IfcGeom {
 	namespace util {
 
@@ -90,6 +92,8 @@ namespace IfcGeom {
 		struct boolean_settings {
 			bool debug, attempt_2d;
 			double precision;
+			// Checked before every operation and polled by BOPAlgo while it runs
+			const IfcGeom::cancellation_token* cancellation = nullptr;
 		};
 
 		bool boolean_operation(const boolean_settings& settings, const TopoDS_Shape&, const TopTools_ListOfShape&, BOPAlgo_Operation, TopoDS_Shape&, double fuzziness = -1.);
@@ -203,15 +203,30 @@ bool OpenCascadeKernel::convert_impl(const taxonomy::sweep_along_curve::ptr scs,
 	// For tiny radii occt will fail building the sweep, in which case we enlarge the inputs to occt, and add a scale matrix to the output
 	bool enlarged = false;
 	static double enlarge_factor = 1000.;
+	// The sweep may be shared through the mapping cache, enlargement is applied to copies
+	auto sweep = scs;
 	if (scs->basis->kind() == taxonomy::FACE) {
-		auto w = std::static_pointer_cast<taxonomy::face>(scs->basis)->children[0];
+		auto f = std::static_pointer_cast<taxonomy::face>(scs->basis);
+		auto w = f->children[0];
 		if (w->children.size() == 1 && w->children[0]->basis && w->children[0]->basis->kind() == taxonomy::CIRCLE) {
 			auto circ = std::static_pointer_cast<taxonomy::circle>(w->children[0]->basis);
 			enlarged = circ->radius < 1.e-4;
 			if (enlarged) {
-				// @todo immutability
-				circ->radius *= enlarge_factor;
-				auto crv = std::static_pointer_cast<taxonomy::geom_item>(scs->curve);
+				auto enlarged_circ = taxonomy::circle::ptr(circ->clone_());
+				enlarged_circ->radius *= enlarge_factor;
+				auto enlarged_edge = taxonomy::edge::ptr(w->children[0]->clone_());
+				enlarged_edge->basis = enlarged_circ;
+				auto enlarged_loop = taxonomy::loop::ptr(w->clone_());
+				enlarged_loop->matrix = w->matrix;
+				enlarged_loop->children = { enlarged_edge };
+				auto enlarged_face = taxonomy::face::ptr(f->clone_());
+				enlarged_face->matrix = f->matrix;
+				enlarged_face->instance = f->instance;
+				enlarged_face->children[0] = enlarged_loop;
+
+				auto original_crv = std::static_pointer_cast<taxonomy::geom_item>(scs->curve);
+				auto crv = taxonomy::geom_item::ptr(static_cast<taxonomy::geom_item*>(original_crv->clone_()));
+				crv->matrix = original_crv->matrix;
 				if (crv->matrix) {
 					crv->matrix = taxonomy::make<taxonomy::matrix4>(
 						Eigen::Scaling(enlarge_factor) *
@@ -221,10 +236,14 @@ bool OpenCascadeKernel::convert_impl(const taxonomy::sweep_along_curve::ptr scs,
 					crv->matrix = taxonomy::make<taxonomy::matrix4>();
 					crv->matrix->components().topLeftCorner<3, 3>() = Eigen::Scaling(enlarge_factor, enlarge_factor, enlarge_factor).toDenseMatrix();
 				}
+
+				sweep = taxonomy::sweep_along_curve::ptr(scs->clone_());
+				sweep->basis = enlarged_face;
+				sweep->curve = crv;
 			}
 		}
 	}
-	if (!convert(scs, shape)) {
+	if (!convert(sweep, shape)) {
 		return false;
 	}
 	taxonomy::matrix4::ptr m;
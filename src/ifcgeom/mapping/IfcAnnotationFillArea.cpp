@@ -27,6 +27,11 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcAnnotationFillArea* inst) {
 	auto loop = taxonomy::cast<taxonomy::loop>(map(inst->OuterBoundary()));
 	if (loop) {
 		auto face = taxonomy::make<taxonomy::face>();
+		// The mapped loops are cached, modify copies
+		auto copy = taxonomy::loop::ptr(loop->clone_());
+		copy->matrix = loop->matrix;
+		copy->instance = loop->instance;
+		loop = copy;
 		loop->external = true;
 		face->children = { loop };
 
@@ -35,6 +40,10 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcAnnotationFillArea* inst) {
 			for (auto& v : *inner_boundaries) {
 				auto inner_loop = taxonomy::cast<taxonomy::loop>(map(v));
 				if (inner_loop) {
+					auto inner_copy = taxonomy::loop::ptr(inner_loop->clone_());
+					inner_copy->matrix = inner_loop->matrix;
+					inner_copy->instance = inner_loop->instance;
+					inner_loop = inner_copy;
 					inner_loop->external = false;
 					face->children.push_back(inner_loop);
 				}
@@ -27,6 +27,11 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcArbitraryClosedProfileDef* i
 	auto loop = taxonomy::cast<taxonomy::loop>(map(inst->OuterCurve()));
 	if (loop) {
 		auto face = taxonomy::make<taxonomy::face>();
+		// The mapped loops are cached, modify copies
+		auto copy = taxonomy::loop::ptr(loop->clone_());
+		copy->matrix = loop->matrix;
+		copy->instance = loop->instance;
+		loop = copy;
 		loop->external = true;
 		face->children = { loop };
 
@@ -36,6 +41,10 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcArbitraryClosedProfileDef* i
 			for (auto& v : *voids) {
 				auto inner_loop = taxonomy::cast<taxonomy::loop>(map(v));
 				if (inner_loop) {
+					auto inner_copy = taxonomy::loop::ptr(inner_loop->clone_());
+					inner_copy->matrix = inner_loop->matrix;
+					inner_copy->instance = inner_loop->instance;
+					inner_loop = inner_copy;
 					inner_loop->external = false;
 					face->children.push_back(inner_loop);
 				}
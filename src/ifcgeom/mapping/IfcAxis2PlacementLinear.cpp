@@ -31,7 +31,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcAxis2PlacementLinear* inst)
 	Eigen::Vector3d o, axis(0, 0, 1), refDirection;
 
    taxonomy::matrix4::ptr m = taxonomy::cast<taxonomy::matrix4>(map(inst->Location()));
-   o = m->components().col(3).head<3>();
+   o = m->ccomponents().col(3).head<3>();
 
 	// From 8.9.3.4 IfcAxis2PlacementLinear there are 4 cases that need to be considered
 	// 1) Axis is given but not RefDirection
@@ -51,7 +51,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcAxis2PlacementLinear* inst)
       taxonomy::direction3::ptr a = taxonomy::cast<taxonomy::direction3>(map(inst->Axis()));
       axis = *a->components_;
 
-	   refDirection = m->components().col(0).head<3>(); // RefDirection is the curve tangent when omitted
+	   refDirection = m->ccomponents().col(0).head<3>(); // RefDirection is the curve tangent when omitted
       // refDirection is not necessarily orthogonal to axis.
       // axis.cross(refDirection) gives y. y.cross(axis) gives x=refDirection
       refDirection = axis.cross(refDirection).cross(axis);
@@ -65,7 +65,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcAxis2PlacementLinear* inst)
    } 
 	else if (!hasAxis && !hasRef) 
 	{
-       refDirection = m->components().col(0).head<3>(); // RefDirection is the curve tangent when omitted
+       refDirection = m->ccomponents().col(0).head<3>(); // RefDirection is the curve tangent when omitted
        Eigen::Vector3d up(0, 0, 1);
        axis = refDirection.cross(up.cross(refDirection));
    }
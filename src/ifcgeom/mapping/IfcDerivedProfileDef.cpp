@@ -26,7 +26,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcDerivedProfileDef* inst) {
 	if (it == nullptr) {
 		return nullptr;
 	}
-	// @todo we mutate it so we need to clone otherwise we alter the cached item.
+	// We mutate it so we need to clone otherwise we alter the cached item.
 	it = taxonomy::item::ptr(it->clone_());
 
 	taxonomy::matrix4::ptr m;
@@ -45,10 +45,12 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcDerivedProfileDef* inst) {
 			return nullptr;
 		}
 	}
-	if (!taxonomy::cast<taxonomy::geom_item>(it)->matrix) {
-		// @todo should this not be initialized by default? matrix4 already has a 'lazy identity' mechanism.
-		taxonomy::cast<taxonomy::geom_item>(it)->matrix = taxonomy::make<taxonomy::matrix4>();
+	// The clone shares its matrix with the cached item, so it is replaced rather than modified
+	auto geom = taxonomy::cast<taxonomy::geom_item>(it);
+	if (geom->matrix) {
+		geom->matrix = taxonomy::make<taxonomy::matrix4>(Eigen::Matrix4d(geom->matrix->ccomponents() * m->ccomponents()));
+	} else {
+		geom->matrix = taxonomy::make<taxonomy::matrix4>(m->ccomponents());
 	}
-	taxonomy::cast<taxonomy::geom_item>(it)->matrix->components() *= m->ccomponents();
 	return it;
 }
@@ -43,8 +43,11 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcEdge* inst) {
 		auto basis = map(inst->as<IfcSchema::IfcEdgeCurve>()->EdgeGeometry());
 		auto loop = taxonomy::dcast<taxonomy::loop>(basis);
 		if (loop && loop->children.size() == 1) {
-			loop->calculate_linear_edge_curves();
-			basis = loop->children[0]->basis;
+			// The mapped loop is cached, compute the curve on a copy of its edge
+			auto single = taxonomy::make<taxonomy::loop>();
+			single->children.push_back(taxonomy::edge::ptr(loop->children[0]->clone_()));
+			single->calculate_linear_edge_curves();
+			basis = single->children[0]->basis;
 		}
 		e->basis = basis;
 		e->curve_sense = inst->as<IfcSchema::IfcEdgeCurve>()->SameSense();
@@ -38,8 +38,10 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcEllipse* inst) {
 	// ellipse is rotated. Note that special care is taken
 	// when creating a trimmed curve off of an ellipse like this.
 	if (y > x) {
-		// @todo is a copy necesary here or can this be done in place?
+		// The placement is shared with other items through the mapping cache,
+		// so the rotated matrix is a copy.
 		auto m4_copy = *el->matrix;
+		el->matrix = taxonomy::make<taxonomy::matrix4>();
 		el->matrix->components() <<
 			m4_copy.components().col(1),
 			-m4_copy.components().col(0),
@@ -45,8 +45,10 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcEllipseProfileDef* inst) {
 	}
 
 	if (ry > rx) {
-		// @todo is a copy necesary here or can this be done in place?
+		// The placement is shared with other items through the mapping cache,
+		// so the rotated matrix is a copy.
 		auto m4_copy = *m4;
+		m4 = taxonomy::make<taxonomy::matrix4>();
 		m4->components() <<
 			m4_copy.components().col(1),
 			-m4_copy.components().col(0),
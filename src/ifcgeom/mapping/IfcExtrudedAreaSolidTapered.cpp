@@ -42,10 +42,14 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcExtrudedAreaSolidTapered* in
 		taxonomy::cast<taxonomy::face>(map(inst->EndSweptArea()))
 	};
 
-	if (!loft->children.back()->matrix) {
-		loft->children.back()->matrix = taxonomy::make<taxonomy::matrix4>();
+	// The end profile is shared with other items through the mapping cache, so
+	// it is copied before it is moved to the end of the extrusion.
+	Eigen::Matrix4d old = Eigen::Matrix4d::Identity();
+	if (loft->children.back()->matrix) {
+		old = loft->children.back()->matrix->ccomponents();
 	}
-	auto old = loft->children.back()->matrix->ccomponents();
+	loft->children.back() = std::static_pointer_cast<taxonomy::geom_item>(taxonomy::item::ptr(loft->children.back()->clone_()));
+	loft->children.back()->matrix = taxonomy::make<taxonomy::matrix4>();
 	loft->children.back()->matrix->components() = old * end_profile;
 
 	taxonomy::matrix4::ptr matrix;
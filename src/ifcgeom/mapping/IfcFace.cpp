@@ -26,18 +26,16 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcFace* inst) {
 	auto bounds = inst->Bounds();
 	for (auto& bound : *bounds) {
 		if (auto r = taxonomy::cast<taxonomy::loop>(map(bound->Bound()))) {
+			// The mapped loop is cached, modify a copy
+			auto copy = taxonomy::loop::ptr(r->clone_());
+			copy->matrix = r->matrix;
+			copy->instance = r->instance;
+			r = copy;
 			if (!bound->Orientation()) {
 				r->reverse();
 			}
 			// @todo check why loop sets external to true initially
 			r->external = bound->declaration().is(IfcSchema::IfcFaceOuterBound::Class());
-			/*
-			// Make a copy in case we need immutability later for e.g. caching
-			auto s = r->clone();
-			((taxonomy::loop*)s)->external = true;
-			delete r;
-			r = s;
-			*/
 			face->children.push_back(r);
 		}
 	}
@@ -29,7 +29,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcMappedItem* inst) {
 	taxonomy::matrix4::ptr trsf2 = taxonomy::cast<taxonomy::matrix4>(map(placement));
 	Eigen::Matrix4d res = gtrsf->ccomponents() * trsf2->ccomponents();
 
-	// @todo immutable for caching?
+	// The mapped representation is shared through the cache and not modified here
 	// @todo allow for multiple levels of matrix?
 	auto shapes = taxonomy::dcast<taxonomy::collection>(map(rmap->MappedRepresentation()));
 	if (shapes == nullptr) {
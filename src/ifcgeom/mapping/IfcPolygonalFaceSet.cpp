@@ -25,12 +25,16 @@ using namespace ifcopenshell::geometry;
 
 taxonomy::ptr mapping::map_impl(const IfcSchema::IfcPolygonalFaceSet* inst) {
 	IfcSchema::IfcCartesianPointList3D* point_list = inst->Coordinates();
-	auto coordinates = point_list->CoordList();
+	// The coordinates and inner indices are read directly from the flat
+	// attribute storage, rather than copied into nested vectors
+	const auto& coordinates = point_list->data().get_attribute_value(
+		IfcSchema::IfcCartesianPointList3D::Class().attribute_index("CoordList")).as_flat_aggregate_of_aggregate<double>();
 	auto polygonal_faces = inst->Faces();
 
 	std::vector<taxonomy::point3::ptr> points;
 	points.reserve(coordinates.size());
-	for (auto& coords : coordinates) {
+	for (size_t i = 0; i < coordinates.size(); ++i) {
+		auto coords = coordinates[i];
 		points.push_back(taxonomy::make<taxonomy::point3>(
 			coords.size() < 1 ? 0. : coords[0] * length_unit_,
 			coords.size() < 2 ? 0. : coords[1] * length_unit_,
@@ -68,15 +72,17 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcPolygonalFaceSet* inst) {
 		}
 
 		if (f->as<IfcSchema::IfcIndexedPolygonalFaceWithVoids>()) {
-			auto indices = f->as<IfcSchema::IfcIndexedPolygonalFaceWithVoids>()->InnerCoordIndices();
+			const auto& indices = f->data().get_attribute_value(
+				IfcSchema::IfcIndexedPolygonalFaceWithVoids::Class().attribute_index("InnerCoordIndices")).as_flat_aggregate_of_aggregate<int>();
 			{
 				taxonomy::point3::ptr previous;
-				for (auto& li : indices) {
+				for (size_t i = 0; i < indices.size(); ++i) {
+					auto li = indices[i];
 					auto loop = taxonomy::make<taxonomy::loop>();
 					fa->children.push_back(loop);
 					loop->external = false;
 
-					for (std::vector<int>::const_iterator jt = li.begin(); jt != li.end(); ++jt) {
+					for (const int* jt = li.begin(); jt != li.end(); ++jt) {
 						if (*jt < 1 || *jt > max_index) {
 							throw IfcParse::IfcException("IfcPolygonalFaceSet index out of bounds for index " + boost::lexical_cast<std::string>(*jt));
 						}
@@ -68,7 +68,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcSweptDiskSolid* inst) {
 	if (inst->as<IfcSchema::IfcSweptDiskSolidPolygonal>()) {
 		auto fr = inst->as<IfcSchema::IfcSweptDiskSolidPolygonal>()->FilletRadius();
 		if (fr && *fr > tol) {
-			fillet_loop(loop, *fr);
+			loop = fillet_loop(loop, *fr);
 		}
 	}
 #endif
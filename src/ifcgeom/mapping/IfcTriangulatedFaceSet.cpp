@@ -25,12 +25,17 @@ using namespace ifcopenshell::geometry;
 
 taxonomy::ptr mapping::map_impl(const IfcSchema::IfcTriangulatedFaceSet* inst) {
 	IfcSchema::IfcCartesianPointList3D* point_list = inst->Coordinates();
-	auto coordinates = point_list->CoordList();
-	std::vector<std::vector<int>> indices_list = inst->CoordIndex();
+	// The coordinates and indices are read directly from the flat attribute
+	// storage, rather than copied into nested vectors by CoordList() and CoordIndex()
+	const auto& coordinates = point_list->data().get_attribute_value(
+		IfcSchema::IfcCartesianPointList3D::Class().attribute_index("CoordList")).as_flat_aggregate_of_aggregate<double>();
+	const auto& indices_list = inst->data().get_attribute_value(
+		IfcSchema::IfcTriangulatedFaceSet::Class().attribute_index("CoordIndex")).as_flat_aggregate_of_aggregate<int>();
 
 	std::vector<taxonomy::point3::ptr> points;
 	points.reserve(coordinates.size());
-	for (auto& coords : coordinates) {
+	for (size_t i = 0; i < coordinates.size(); ++i) {
+		auto coords = coordinates[i];
 		points.push_back(taxonomy::make<taxonomy::point3>(
 			coords.size() < 1 ? 0. : coords[0] * length_unit_,
 			coords.size() < 2 ? 0. : coords[1] * length_unit_,
@@ -41,7 +46,8 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcTriangulatedFaceSet* inst) {
 
 	auto shell = taxonomy::make<taxonomy::shell>();
 
-	for (auto& indices : indices_list) {
+	for (size_t i = 0; i < indices_list.size(); ++i) {
+		auto indices = indices_list[i];
 		auto fa = taxonomy::make<taxonomy::face>();
 		shell->children.push_back(fa);
 
@@ -50,7 +56,7 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcTriangulatedFaceSet* inst) {
 			fa->children = { loop };
 			loop->external = true;
 			taxonomy::point3::ptr first, previous;
-			for (std::vector<int>::const_iterator jt = indices.begin(); jt != indices.end(); ++jt) {
+			for (const int* jt = indices.begin(); jt != indices.end(); ++jt) {
 				if (*jt < 1 || *jt > max_index) {
 					throw IfcParse::IfcException("IfcTriangulatedFaceSet index out of bounds for index " + boost::lexical_cast<std::string>(*jt));
 				}
@@ -626,10 +626,9 @@ taxonomy::ptr mapping::map_impl(const IfcSchema::IfcSurfaceStyle* style) {
 taxonomy::ptr mapping::map(const IfcBaseInterface* inst) {
     auto iden = inst->as<IfcUtil::IfcBaseClass>()->identity();
     if (use_caching_) {
-        std::lock_guard<std::mutex> guard(cache_guard_);
-        auto it = cache_.find(iden);
-        if (it != cache_.end()) {
-            return it->second;
+        taxonomy::ptr cached;
+        if (cache_->find(iden, cached)) {
+            return cached;
         }
     }
     taxonomy::ptr item = nullptr;
@@ -644,8 +643,10 @@ taxonomy::ptr mapping::map(const IfcBaseInterface* inst) {
 
     if (item) {
         if (use_caching_) {
-            std::lock_guard<std::mutex> guard(cache_guard_);
-            cache_.insert({iden, item});
+            // Another thread sharing the cache may have mapped the same instance
+            // in the meantime, in which case its item is used so that identities
+            // remain unique per instance.
+            item = cache_->insert(iden, item);
         }
     } else if (!matched) {
         Logger::Message(Logger::LOG_ERROR, "No operation defined for:", inst);
@@ -1065,7 +1066,7 @@ bool mapping::get_layerset_information(const IfcUtil::IfcBaseInterface* p, layer
             auto offset_matrix = taxonomy::make<taxonomy::matrix4>();
             offset_matrix->components()(2, 3) = offset;
             offset_matrix->components()(3, 3) = 1.;
-            offset_matrix->components() *= extrusion_position->components();
+            offset_matrix->components() *= extrusion_position->ccomponents();
 
             auto pln = taxonomy::make<taxonomy::plane>();
             pln->matrix = offset_matrix;
@@ -6,8 +6,6 @@
 #include "../../ifcparse/IfcFile.h"
 #include "../../ifcparse/IfcLogger.h"
 
-#include <mutex>
-
 #define INCLUDE_SCHEMA(x) STRINGIFY(../../ifcparse/x.h)
 #include INCLUDE_SCHEMA(IfcSchema)
 #undef INCLUDE_SCHEMA
@@ -25,9 +23,6 @@ namespace geometry {
 		double length_unit_, angle_unit_;
 		std::string length_unit_name_;
 
-		std::map<uint32_t, ifcopenshell::geometry::taxonomy::ptr> cache_;
-      std::mutex cache_guard_; // provides mutually exclusive access to cache_
-
 		const IfcParse::declaration* placement_rel_to_type_;
 		const IfcUtil::IfcBaseEntity* placement_rel_to_instance_;
 
@@ -60,6 +55,15 @@ namespace geometry {
 								if (style) {
 									auto mstyle = map(style);
 									if (mstyle) {
+										if (item->instance != inst) {
+											// The item was returned as-is from the mapping of another
+											// instance and may be shared, so style a copy instead.
+											auto original = taxonomy::cast<taxonomy::geom_item>(item);
+											auto copy = taxonomy::cast<taxonomy::geom_item>(taxonomy::ptr(item->clone_()));
+											copy->matrix = original->matrix;
+											copy->instance = original->instance;
+											item = copy;
+										}
 										taxonomy::cast<taxonomy::geom_item>(item)->surface_style = taxonomy::cast<taxonomy::style>(mstyle);
 									}
 								}
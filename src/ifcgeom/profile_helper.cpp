@@ -1,8 +1,30 @@
 #include "profile_helper.h"
 
+#include <map>
+
 using namespace ifcopenshell::geometry;
 
 taxonomy::loop::ptr ifcopenshell::geometry::fillet_loop(taxonomy::loop::ptr loop, double radius) {
+	// The loop may be shared with other items through the mapping cache, so
+	// the fillets are applied to a copy of its edges and points. Points shared
+	// by consecutive edges remain shared in the copy.
+	loop = taxonomy::loop::ptr(loop->clone_());
+	std::map<const taxonomy::point3*, taxonomy::point3::ptr> copies;
+	auto copy_point = [&copies](boost::variant<boost::blank, taxonomy::point3::ptr, double>& v) {
+		if (auto* p = boost::get<taxonomy::point3::ptr>(&v)) {
+			auto& copy = copies[p->get()];
+			if (!copy) {
+				copy = taxonomy::point3::ptr((*p)->clone_());
+			}
+			*p = copy;
+		}
+	};
+	for (auto& e : loop->children) {
+		e = taxonomy::edge::ptr(e->clone_());
+		copy_point(e->start);
+		copy_point(e->end);
+	}
+
 	std::vector<profile_point_with_edges_3d> pps(loop->children.size());
 	for (int b = 0; b < loop->children.size(); ++b) {
 		int c = (b - 1) % loop->children.size();
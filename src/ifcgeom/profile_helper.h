@@ -27,6 +27,7 @@ namespace ifcopenshell {
 
 		taxonomy::loop::ptr profile_helper(const taxonomy::matrix4::ptr& m4, const std::vector<profile_point>& points);
 
+		// Returns a copy of the loop with its corners rounded, lp is not modified
 		taxonomy::loop::ptr fillet_loop(taxonomy::loop::ptr lp, double radius);
 	}
 
@@ -0,0 +1,108 @@
+/********************************************************************************
+ *																			  *
+ * This file is part of IfcOpenShell.										   *
+ *																			  *
+ * IfcOpenShell is free software: you can redistribute it and/or modify		 *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or		  *
+ * (at your option) any later version.										  *
+ *																			  *
+ * IfcOpenShell is distributed in the hope that it will be useful,			  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of			   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the				 *
+ * Lesser GNU General Public License for more details.						  *
+ *																			  *
+ * You should have received a copy of the Lesser GNU General Public License	 *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.		 *
+ *																			  *
+ ********************************************************************************/
+
+#ifndef SHARDED_CACHE_H
+#define SHARDED_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace IfcGeom {
+
+	// A map that can be read and written from multiple threads. Keys are spread
+	// over a fixed number of shards that each have their own lock, so that
+	// workers looking up different keys rarely wait for each other. Values are
+	// never replaced once inserted: when two threads compute a value for the
+	// same key, the first one inserted wins and is returned to both, so that
+	// everybody ends up sharing the same (immutable) value.
+	template <typename K, typename V, size_t N = 64, typename Hash = std::hash<K>>
+	class sharded_cache {
+	public:
+		sharded_cache() = default;
+		sharded_cache(const sharded_cache&) = delete;
+		sharded_cache& operator=(const sharded_cache&) = delete;
+
+		bool find(const K& k, V& v) const {
+			auto& s = shard_(k);
+			{
+				std::lock_guard<std::mutex> lk(s.mutex);
+				auto it = s.values.find(k);
+				if (it != s.values.end()) {
+					v = it->second;
+					++hits_;
+					return true;
+				}
+			}
+			++misses_;
+			return false;
+		}
+
+		// Returns the value that is in the cache after insertion, which is the
+		// value inserted earlier by another thread if there was one.
+		V insert(const K& k, const V& v) {
+			auto& s = shard_(k);
+			std::lock_guard<std::mutex> lk(s.mutex);
+			return s.values.insert({ k, v }).first->second;
+		}
+
+		size_t size() const {
+			size_t n = 0;
+			for (auto& s : shards_) {
+				std::lock_guard<std::mutex> lk(s.mutex);
+				n += s.values.size();
+			}
+			return n;
+		}
+
+		void clear() {
+			for (auto& s : shards_) {
+				std::lock_guard<std::mutex> lk(s.mutex);
+				s.values.clear();
+			}
+		}
+
+		size_t hits() const { return hits_; }
+		size_t misses() const { return misses_; }
+
+	private:
+		struct shard {
+			mutable std::mutex mutex;
+			std::unordered_map<K, V, Hash> values;
+		};
+
+		std::array<shard, N> shards_;
+		mutable std::atomic<size_t> hits_{ 0 };
+		mutable std::atomic<size_t> misses_{ 0 };
+
+		shard& shard_(const K& k) {
+			return shards_[Hash{}(k) % N];
+		}
+
+		const shard& shard_(const K& k) const {
+			return shards_[Hash{}(k) % N];
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,239 @@
+/********************************************************************************
+ *																			  *
+ * This file is part of IfcOpenShell.										   *
+ *																			  *
+ * IfcOpenShell is free software: you can redistribute it and/or modify		 *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or		  *
+ * (at your option) any later version.										  *
+ *																			  *
+ * IfcOpenShell is distributed in the hope that it will be useful,			  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of			   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the				 *
+ * Lesser GNU General Public License for more details.						  *
+ *																			  *
+ * You should have received a copy of the Lesser GNU General Public License	 *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.		 *
+ *																			  *
+ ********************************************************************************/
+
+#ifndef TASK_COST_ESTIMATOR_H
+#define TASK_COST_ESTIMATOR_H
+
+#include "../ifcparse/IfcBaseClass.h"
+#include "../ifcparse/IfcException.h"
+#include "../ifcparse/aggregate_of_instance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace IfcGeom {
+
+	// Predicted and measured cost of converting one representation for its products
+	struct task_cost {
+		int representation_id;
+		// GlobalId of the first product, which is the key for recorded timings
+		std::string product_guid;
+		// In milliseconds when timings were provided, otherwise in arbitrary units
+		double predicted;
+		// Wall-clock milliseconds, negative when the task has not been processed
+		double actual;
+	};
+
+	// Estimates the relative cost of a geometry_conversion_task from the IFC
+	// entities alone, before anything is mapped. The unit is roughly the cost of
+	// a single extrusion. Only relative values matter: tasks are ordered by it
+	// so that the expensive ones do not start last.
+	class task_cost_estimator {
+	public:
+		static constexpr double item_cost = 1.;
+		static constexpr double boolean_cost = 10.;
+		static constexpr double planar_face_cost = 0.02;
+		static constexpr double advanced_face_cost = 0.5;
+		static constexpr double triangle_cost = 0.002;
+		// Products sharing a representation reuse the first product's shape
+		static constexpr double additional_product_factor = 0.25;
+
+		double operator()(const IfcUtil::IfcBaseEntity* representation, const aggregate_of_instance::ptr& products) const {
+			double cost = item_cost;
+			try {
+				cost = representation_cost_(representation, 0);
+			} catch (const IfcParse::IfcException&) {
+			}
+
+			if (!products || products->size() == 0) {
+				return cost;
+			}
+
+			double total = cost * (1. + additional_product_factor * (products->size() - 1));
+			for (auto& p : *products) {
+				// Every opening is a boolean subtraction from the product's shape
+				total += num_openings_(p->as<IfcUtil::IfcBaseEntity>()) * (boolean_cost + cost);
+			}
+			return total;
+		}
+
+		// Replaces the estimates by timings recorded on a previous run where available.
+		// The remaining estimates are scaled to milliseconds with the ratio between the
+		// recorded timings and the estimates of the same tasks.
+		static void apply_recorded_timings(std::vector<task_cost>& costs, const std::map<std::string, double>& timings) {
+			double recorded = 0., estimated = 0.;
+			for (auto& c : costs) {
+				auto it = timings.find(c.product_guid);
+				if (it != timings.end()) {
+					recorded += it->second;
+					estimated += c.predicted;
+				}
+			}
+			if (estimated <= 0.) {
+				return;
+			}
+			const double scale = recorded / estimated;
+			for (auto& c : costs) {
+				auto it = timings.find(c.product_guid);
+				c.predicted = it == timings.end() ? c.predicted * scale : it->second;
+			}
+		}
+
+		// Spearman's rank correlation between predicted and actual cost of the processed tasks
+		static double rank_correlation(const std::vector<task_cost>& costs) {
+			std::vector<const task_cost*> processed;
+			for (auto& c : costs) {
+				if (c.actual >= 0.) {
+					processed.push_back(&c);
+				}
+			}
+			if (processed.size() < 2) {
+				return 0.;
+			}
+			auto predicted_rank = ranks_(processed, [](const task_cost* c) { return c->predicted; });
+			auto actual_rank = ranks_(processed, [](const task_cost* c) { return c->actual; });
+			const double mean = (processed.size() - 1) / 2.;
+			double cov = 0., var_p = 0., var_a = 0.;
+			for (size_t i = 0; i < processed.size(); ++i) {
+				cov += (predicted_rank[i] - mean) * (actual_rank[i] - mean);
+				var_p += (predicted_rank[i] - mean) * (predicted_rank[i] - mean);
+				var_a += (actual_rank[i] - mean) * (actual_rank[i] - mean);
+			}
+			if (var_p <= 0. || var_a <= 0.) {
+				return 0.;
+			}
+			return cov / std::sqrt(var_p * var_a);
+		}
+
+	private:
+		static const int max_depth = 32;
+
+		template <typename Fn>
+		static std::vector<double> ranks_(const std::vector<const task_cost*>& costs, Fn value) {
+			std::vector<size_t> order(costs.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return value(costs[a]) < value(costs[b]); });
+			// Ties get the average of their ranks
+			std::vector<double> rank(costs.size());
+			for (size_t i = 0; i < order.size();) {
+				size_t j = i;
+				while (j + 1 < order.size() && value(costs[order[j + 1]]) == value(costs[order[i]])) {
+					++j;
+				}
+				for (size_t k = i; k <= j; ++k) {
+					rank[order[k]] = (i + j) / 2.;
+				}
+				i = j + 1;
+			}
+			return rank;
+		}
+
+		static size_t num_openings_(const IfcUtil::IfcBaseEntity* product) {
+			if (!product || !product->declaration().is("IfcElement")) {
+				return 0;
+			}
+			try {
+				auto openings = product->get_inverse("HasOpenings");
+				return openings ? openings->size() : 0;
+			} catch (const IfcParse::IfcException&) {
+				return 0;
+			}
+		}
+
+		static size_t num_faces_(const IfcUtil::IfcBaseClass* shell) {
+			if (!shell || !shell->declaration().as_entity() || !shell->declaration().is("IfcConnectedFaceSet")) {
+				return 0;
+			}
+			auto faces = shell->as<IfcUtil::IfcBaseEntity>()->get("CfsFaces");
+			return faces.isNull() ? 0 : faces.size();
+		}
+
+		double representation_cost_(const IfcUtil::IfcBaseEntity* representation, int depth) const {
+			double cost = 0.;
+			if (representation && depth < max_depth) {
+				aggregate_of_instance::ptr items = representation->get("Items");
+				if (items) {
+					for (auto& i : *items) {
+						cost += item_cost_(i->as<IfcUtil::IfcBaseEntity>(), depth + 1);
+					}
+				}
+			}
+			return std::max(cost, item_cost);
+		}
+
+		double item_cost_(const IfcUtil::IfcBaseEntity* item, int depth) const {
+			if (!item || depth >= max_depth) {
+				return item_cost;
+			}
+			const auto& decl = item->declaration();
+			if (decl.is("IfcBooleanResult")) {
+				IfcUtil::IfcBaseClass* first = item->get("FirstOperand");
+				IfcUtil::IfcBaseClass* second = item->get("SecondOperand");
+				return boolean_cost +
+					item_cost_(first ? first->as<IfcUtil::IfcBaseEntity>() : nullptr, depth + 1) +
+					item_cost_(second ? second->as<IfcUtil::IfcBaseEntity>() : nullptr, depth + 1);
+			} else if (decl.is("IfcCsgSolid")) {
+				IfcUtil::IfcBaseClass* root = item->get("TreeRootExpression");
+				return item_cost_(root ? root->as<IfcUtil::IfcBaseEntity>() : nullptr, depth + 1);
+			} else if (decl.is("IfcMappedItem")) {
+				IfcUtil::IfcBaseClass* source = item->get("MappingSource");
+				if (source) {
+					IfcUtil::IfcBaseClass* mapped = source->as<IfcUtil::IfcBaseEntity>()->get("MappedRepresentation");
+					return representation_cost_(mapped ? mapped->as<IfcUtil::IfcBaseEntity>() : nullptr, depth + 1);
+				}
+			} else if (decl.is("IfcManifoldSolidBrep")) {
+				const double face_cost = decl.is("IfcAdvancedBrep") ? advanced_face_cost : planar_face_cost;
+				IfcUtil::IfcBaseClass* outer = item->get("Outer");
+				size_t faces = num_faces_(outer);
+				if (decl.is("IfcFacetedBrepWithVoids") || decl.is("IfcAdvancedBrepWithVoids")) {
+					aggregate_of_instance::ptr voids = item->get("Voids");
+					if (voids) {
+						for (auto& v : *voids) {
+							faces += num_faces_(v);
+						}
+					}
+				}
+				return item_cost + faces * face_cost;
+			} else if (decl.is("IfcShellBasedSurfaceModel") || decl.is("IfcFaceBasedSurfaceModel")) {
+				aggregate_of_instance::ptr shells = item->get(decl.is("IfcShellBasedSurfaceModel") ? "SbsmBoundary" : "FbsmFaces");
+				size_t faces = 0;
+				if (shells) {
+					for (auto& s : *shells) {
+						faces += num_faces_(s);
+					}
+				}
+				return item_cost + faces * planar_face_cost;
+			} else if (decl.is("IfcTriangulatedFaceSet")) {
+				auto indices = item->get("CoordIndex");
+				return item_cost + (indices.isNull() ? 0 : indices.size()) * triangle_cost;
+			} else if (decl.is("IfcPolygonalFaceSet")) {
+				auto faces = item->get("Faces");
+				return item_cost + (faces.isNull() ? 0 : faces.size()) * planar_face_cost;
+			}
+			return item_cost;
+		}
+	};
+
+}
+
+#endif
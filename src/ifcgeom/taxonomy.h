@@ -12,6 +12,7 @@
 
 #include <Eigen/Dense>
 
+#include <atomic>
 #include <map>
 #include <string>
 #include <tuple>
@@ -101,7 +102,8 @@ typedef item const* ptr;
 			private:
 				uint32_t identity_;
 				static std::atomic_uint32_t counter_;
-				mutable size_t computed_hash_;
+				// Computed lazily, atomic because items are shared between threads
+				mutable std::atomic<size_t> computed_hash_;
 			public:
 				DECLARE_PTR(item)
 
@@ -115,18 +117,31 @@ typedef item const* ptr;
 				virtual void reverse() { throw taxonomy::topology_error(); }
 				virtual size_t calc_hash() const = 0;
 				virtual size_t hash() const {
-					if (computed_hash_) {
-						return computed_hash_;
+					size_t h = computed_hash_.load(std::memory_order_relaxed);
+					if (h) {
+						return h;
 					}
-					computed_hash_ = calc_hash();
-					if (computed_hash_ == 0) {
-						computed_hash_++;
+					h = calc_hash();
+					if (h == 0) {
+						h++;
 					}
-					return computed_hash_;
+					computed_hash_.store(h, std::memory_order_relaxed);
+					return h;
 				}
 
 				item(const IfcUtil::IfcBaseInterface* instance = nullptr) : identity_(counter_++), computed_hash_(0), instance(instance) {}
 
+				// Copies are made in order to be modified, so the hash is not carried over
+				item(const item& other) : identity_(other.identity_), computed_hash_(0), instance(other.instance), orientation(other.orientation) {}
+
+				item& operator=(const item& other) {
+					identity_ = other.identity_;
+					computed_hash_ = 0;
+					instance = other.instance;
+					orientation = other.orientation;
+					return *this;
+				}
+
 				virtual ~item() {}
 
 				uint32_t identity() const { return identity_; }
@@ -666,9 +681,11 @@ typedef item const* ptr;
 				*/
 
 				virtual void reverse() {
-					// @todo this needs to create copies of the children in case of shared_ptr
 					std::reverse(children.begin(), children.end());
 					for (auto& child : children) {
+						// Children may be shared with other items through the mapping
+						// cache, so a copy is reversed instead.
+						child = typename T::ptr(static_cast<T*>(child->clone_()));
 						child->reverse();
 					}
 				}
@@ -0,0 +1,206 @@
+/********************************************************************************
+ *																			  *
+ * This file is part of IfcOpenShell.										   *
+ *																			  *
+ * IfcOpenShell is free software: you can redistribute it and/or modify		 *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or		  *
+ * (at your option) any later version.										  *
+ *																			  *
+ * IfcOpenShell is distributed in the hope that it will be useful,			  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of			   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the				 *
+ * Lesser GNU General Public License for more details.						  *
+ *																			  *
+ * You should have received a copy of the Lesser GNU General Public License	 *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.		 *
+ *																			  *
+ ********************************************************************************/
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace IfcGeom {
+
+	// A fixed set of worker threads that live as long as the pool. Every worker
+	// owns a queue and, when that is empty, steals from the queues of the others.
+	// Both take from the front, so tasks start roughly in submission order and
+	// callers can prioritize by submitting the most expensive work first.
+	// Tasks are passed the index of the worker that runs them, so that
+	// per-worker state (such as a Converter) can be used without locking. Idle
+	// workers and callers of wait() block on condition variables, nothing polls.
+	class work_stealing_pool {
+	public:
+		typedef std::function<void(size_t)> task_type;
+
+		struct statistics {
+			size_t workers;
+			// Tasks submitted but not yet picked up by a worker
+			size_t queued;
+			// Tasks currently executing
+			size_t active;
+			size_t executed;
+			// Tasks executed by a worker other than the one they were queued on
+			size_t stolen;
+			// Fraction of worker time spent executing tasks since construction
+			double utilization;
+		};
+
+		explicit work_stealing_pool(size_t num_workers)
+			: queues_(num_workers == 0 ? 1 : num_workers)
+			, busy_nanoseconds_(queues_.size())
+			, started_(std::chrono::steady_clock::now())
+		{
+			for (auto& b : busy_nanoseconds_) {
+				b = 0;
+			}
+			workers_.reserve(queues_.size());
+			for (size_t i = 0; i < queues_.size(); ++i) {
+				workers_.emplace_back([this, i]() { run_(i); });
+			}
+		}
+
+		work_stealing_pool(const work_stealing_pool&) = delete;
+		work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+		// Tasks that have not been picked up yet are still executed before the
+		// workers are joined.
+		~work_stealing_pool() {
+			{
+				std::lock_guard<std::mutex> lk(mutex_);
+				stopping_ = true;
+			}
+			work_available_.notify_all();
+			for (auto& t : workers_) {
+				t.join();
+			}
+		}
+
+		size_t num_workers() const { return workers_.size(); }
+
+		// Tasks are dealt round-robin over the worker deques, stealing evens out
+		// whatever imbalance that leaves. Tasks must not throw.
+		void submit(task_type fn) {
+			auto& q = queues_[next_queue_++ % queues_.size()];
+			{
+				// Counted under mutex_ so that a worker that just found all
+				// deques empty cannot miss the notification.
+				std::lock_guard<std::mutex> lk(mutex_);
+				std::lock_guard<std::mutex> qlk(q.mutex);
+				q.tasks.push_back(std::move(fn));
+				++queued_;
+			}
+			work_available_.notify_one();
+		}
+
+		// Blocks until every submitted task has finished executing.
+		void wait() {
+			std::unique_lock<std::mutex> lk(mutex_);
+			all_done_.wait(lk, [this]() { return queued_ == 0 && active_ == 0; });
+		}
+
+		size_t queue_depth() const { return queued_; }
+
+		double utilization() const {
+			std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started_;
+			if (elapsed.count() <= 0.) {
+				return 0.;
+			}
+			double busy = 0.;
+			for (auto& b : busy_nanoseconds_) {
+				busy += (double) b;
+			}
+			return busy / (elapsed.count() * workers_.size());
+		}
+
+		statistics stats() const {
+			return { workers_.size(), queued_, active_, executed_, stolen_, utilization() };
+		}
+
+	private:
+		struct worker_queue {
+			std::mutex mutex;
+			std::deque<task_type> tasks;
+		};
+
+		std::vector<worker_queue> queues_;
+		std::vector<std::atomic<uint64_t>> busy_nanoseconds_;
+		std::vector<std::thread> workers_;
+		std::chrono::steady_clock::time_point started_;
+
+		std::mutex mutex_;
+		std::condition_variable work_available_;
+		std::condition_variable all_done_;
+		bool stopping_ = false;
+
+		std::atomic<size_t> next_queue_{ 0 };
+		std::atomic<size_t> queued_{ 0 };
+		std::atomic<size_t> active_{ 0 };
+		std::atomic<size_t> executed_{ 0 };
+		std::atomic<size_t> stolen_{ 0 };
+
+		// active_ is incremented before queued_ is decremented, so that wait()
+		// never observes both as zero while a task is in flight.
+		bool take_(worker_queue& q, task_type& fn) {
+			std::lock_guard<std::mutex> lk(q.mutex);
+			if (q.tasks.empty()) {
+				return false;
+			}
+			fn = std::move(q.tasks.front());
+			q.tasks.pop_front();
+			++active_;
+			--queued_;
+			return true;
+		}
+
+		bool find_task_(size_t worker, task_type& fn) {
+			if (take_(queues_[worker], fn)) {
+				return true;
+			}
+			for (size_t i = 1; i < queues_.size(); ++i) {
+				if (take_(queues_[(worker + i) % queues_.size()], fn)) {
+					++stolen_;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void run_(size_t worker) {
+			task_type fn;
+			while (true) {
+				if (find_task_(worker, fn)) {
+					auto t0 = std::chrono::steady_clock::now();
+					fn(worker);
+					fn = nullptr;
+					busy_nanoseconds_[worker] += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+					++executed_;
+					if (--active_ == 0 && queued_ == 0) {
+						std::lock_guard<std::mutex> lk(mutex_);
+						all_done_.notify_all();
+					}
+				} else {
+					std::unique_lock<std::mutex> lk(mutex_);
+					work_available_.wait(lk, [this]() { return stopping_ || queued_ != 0; });
+					if (stopping_ && queued_ == 0) {
+						return;
+					}
+				}
+			}
+		}
+	};
+
+}
+
+#endif
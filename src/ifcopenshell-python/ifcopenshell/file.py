@@ -24,7 +24,7 @@ import zipfile
 import functools
 import ifcopenshell
 from pathlib import Path
-from typing import Optional, Any, Union, Callable, Generator, Literal, TYPE_CHECKING
+from typing import Optional, Any, Union, Callable, Generator, Literal, Sequence, TYPE_CHECKING
 
 from . import ifcopenshell_wrapper
 from .entity_instance import entity_instance
@@ -93,6 +93,15 @@ class Transaction:
         self.batch_delete_ids = set()
         self.batch_inverses = []
 
+    def rollback_batch(self) -> None:
+        self.operations = self.operations[: self.batch_delete_index] + [
+            o for o in self.operations[self.batch_delete_index :] if o["action"] != "delete"
+        ]
+        self.is_batched = False
+        self.batch_delete_index = 0
+        self.batch_delete_ids = set()
+        self.batch_inverses = []
+
     def store_create(self, element: ifcopenshell.entity_instance) -> None:
         if element.id():
             self.operations.append({"action": "create", "value": self.serialise_entity_instance(element)})
@@ -495,6 +504,25 @@ class file:
         """
         return self[guid]
 
+    def by_guids(self, guids: Sequence[str]) -> list[Union[ifcopenshell.entity_instance, None]]:
+        """Return the IFC entity instances with the given IFC GUIDs.
+
+        Resolving many GUIDs at once, e.g. the components of a BCF topic or
+        the entries of a diff, is considerably faster than calling
+        :meth:`by_guid` for each of them.
+
+        :param guids: GlobalId values in 22-character encoded form
+        :type guids: Sequence[str]
+
+        :returns: The entity instances in the same order as guids, with None
+            for GUIDs that are not found
+        :rtype: list[Union[ifcopenshell.entity_instance, None]]
+        """
+        return [
+            None if inst is None else entity_instance(inst, self)
+            for inst in self.wrapped_data.by_guids([str(guid) for guid in guids])
+        ]
+
     def add(self, inst: ifcopenshell.entity_instance, _id: int = None) -> ifcopenshell.entity_instance:
         """Adds an entity including any dependent entities to an IFC file.
         If the entity already exists, it is not re-added. Existence of entity is checked by it's `.identity()`.
@@ -625,6 +653,12 @@ class file:
             self.transaction.unbatch()
         return self.wrapped_data.unbatch()
 
+    def rollback_batch(self):
+        """Discards the deletions since batch(), which leaves the file unaltered"""
+        if self.transaction:
+            self.transaction.rollback_batch()
+        return self.wrapped_data.rollback_batch()
+
     def __iter__(self) -> Generator[ifcopenshell.entity_instance, None, None]:
         return iter(self[id] for id in self.wrapped_data.entity_names())
 
@@ -102,6 +102,7 @@ SETTING = Literal[
     "piecewise-step-param",
     "use-python-opencascade",
     "no-parallel-mapping",
+    "element-timeout",
     "triangulation-type",
     "model-rotation",
     "model-offset",
@@ -7,16 +7,28 @@ import ifcopenshell.api.project
 import ifcopenshell.api.root
 import ifcopenshell.api.unit
 import ifcopenshell.geom
+import ifcopenshell.guid
+import ifcopenshell.template
 import ifcopenshell.ifcopenshell_wrapper as W
 import ifcopenshell.util.shape
 from ifcopenshell.util.shape_builder import ShapeBuilder, V
+from test.test_wall_opening import (
+    create_case,
+    create_ifcaxis2placement,
+    create_ifclocalplacement,
+    create_ifcpolyline,
+    opening,
+    rect,
+)
 from typing import get_args
 
 
 class TestGeomSettings:
     def test_settings(self):
         settings = ifcopenshell.geom.settings()
-        assert set(get_args(ifcopenshell.geom.SETTING)) == set(settings.setting_names())
+        # Not offered in Python, as it deletes elements that Python may still refer to
+        unsupported = {"result-queue-size"}
+        assert set(get_args(ifcopenshell.geom.SETTING)) == set(settings.setting_names()) - unsupported
 
         assert "use-python-opencascade" in settings.setting_names()
         assert settings.get(settings.USE_PYTHON_OPENCASCADE) is False
@@ -181,6 +193,78 @@ class TestAssignObject:
         assert len(set(vs)) == 12
 
 
+class TestElementTimeout:
+    def convert_wall(self, f, **settings):
+        iterator = ifcopenshell.geom.iterator(ifcopenshell.geom.settings(**settings), f, include=f.by_type("IfcWall"))
+        assert iterator.initialize()
+        return iterator, iterator.get()
+
+    def test_wall_is_emitted_without_openings(self, tmp_path):
+        fn = str(tmp_path / "wall-openings.ifc")
+        create_case(fn, [opening(i * 4.0 + 2.0, 2.0, rect(1.0, 1.0), 0.2) for i in range(3)])
+        f = ifcopenshell.open(fn)
+        wall = f.by_type("IfcWall")[0]
+
+        # The budget is exceeded before the first boolean operation on the openings
+        iterator, shape = self.convert_wall(f, ELEMENT_TIMEOUT=1.0e-9)
+        timed_out = iterator.timed_out_elements()
+        assert [(e.product_id, e.product_guid, e.fallback) for e in timed_out] == [
+            (wall.id(), wall.GlobalId, "without openings")
+        ]
+
+        _, unopened = self.convert_wall(f, DISABLE_OPENING_SUBTRACTIONS=True)
+        assert shape.geometry.verts == unopened.geometry.verts
+
+        iterator, opened = self.convert_wall(f)
+        assert not iterator.timed_out_elements()
+        assert len(opened.geometry.verts) > len(unopened.geometry.verts)
+
+
+class TestSharedProfileCurve:
+    def test_curve_used_as_outer_and_inner_boundary(self):
+        f = ifcopenshell.template.create()
+        owner_history = f.by_type("IfcOwnerHistory")[0]
+        context = f.by_type("IfcGeometricRepresentationContext")[0]
+
+        # One curve bounds the solid profiles and is the void of the profiles with a hole
+        square = [(0.0, 0.0), (1.0, 0.0), (1.0, 1.0), (0.0, 1.0), (0.0, 0.0)]
+        outer = [(-1.0, -1.0), (2.0, -1.0), (2.0, 2.0), (-1.0, 2.0), (-1.0, -1.0)]
+        curve = create_ifcpolyline(f, square)
+        solid = f.createIfcArbitraryClosedProfileDef("AREA", None, curve)
+        with_void = f.createIfcArbitraryProfileDefWithVoids("AREA", None, create_ifcpolyline(f, outer), [curve])
+
+        expected = {}
+        for i in range(32):
+            profile, volume = (solid, 1.0) if i % 2 else (with_void, 8.0)
+            extrusion = f.createIfcExtrudedAreaSolid(
+                profile, create_ifcaxis2placement(f), f.createIfcDirection((0.0, 0.0, 1.0)), 1.0
+            )
+            representation = f.createIfcShapeRepresentation(context, "Body", "SweptSolid", [extrusion])
+            product = f.createIfcBuildingElementProxy(
+                ifcopenshell.guid.new(),
+                owner_history,
+                None,
+                None,
+                None,
+                create_ifclocalplacement(f, (i * 4.0, 0.0, 0.0)),
+                f.createIfcProductDefinitionShape(None, None, [representation]),
+            )
+            expected[product.id()] = volume
+
+        iterator = ifcopenshell.geom.iterator(ifcopenshell.geom.settings(), f, num_threads=4)
+        assert iterator.initialize()
+        volumes = {}
+        while True:
+            shape = iterator.get()
+            volumes[shape.id] = ifcopenshell.util.shape.get_volume(shape.geometry)
+            if not iterator.next():
+                break
+
+        assert volumes.keys() == expected.keys()
+        for product_id, volume in volumes.items():
+            assert volume == pytest.approx(expected[product_id])
+
+
 if __name__ == "__main__":
     import pytest
 
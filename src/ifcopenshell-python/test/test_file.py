@@ -193,6 +193,11 @@ class TestFile(test.bootstrap.IFC4):
         assert self.file.by_guid(1) == element
         assert self.file.by_guid("id") == element
 
+    def test_getting_elements_by_guids(self):
+        wall = self.file.createIfcWall(ifcopenshell.guid.new())
+        slab = self.file.createIfcSlab("id")
+        assert self.file.by_guids([slab.GlobalId, ifcopenshell.guid.new(), wall.GlobalId]) == [slab, None, wall]
+
     def test_adding_an_element(self):
         g = ifcopenshell.file()
         element = g.createIfcWall()
@@ -275,6 +280,27 @@ class TestFile(test.bootstrap.IFC4):
         self.file.unbatch()
         assert len(list(self.file)) == 0
 
+    def test_batched_removing_elements_that_reference_each_other(self):
+        person = self.file.createIfcPerson()
+        role = self.file.createIfcActorRole()
+        role2 = self.file.createIfcActorRole()
+        person.Roles = [role, role2]
+        self.file.batch()
+        self.file.remove(person)
+        self.file.remove(role)
+        self.file.unbatch()
+        assert list(self.file) == [role2]
+
+    def test_rolling_back_batched_removal(self):
+        person = self.file.createIfcPerson()
+        role = self.file.createIfcActorRole()
+        person.Roles = [role]
+        self.file.batch()
+        self.file.remove(role)
+        self.file.rollback_batch()
+        assert person.Roles == (role,)
+        assert len(list(self.file)) == 2
+
     def test_creating_ifc_data_from_a_string(self):
         element = self.file.createIfcWall()
         g = ifcopenshell.file.from_string(self.file.wrapped_data.to_string())
@@ -286,3 +312,79 @@ class TestFile(test.bootstrap.IFC4):
         g = ifcopenshell.file(schema="IFC4")
         g.assign_header_from(f)
         assert g.header.file_name.name == "test"
+
+    def test_creating_ifc_data_from_a_string_lazily(self):
+        wall = self.file.createIfcWall(GlobalId=ifcopenshell.guid.new(), Name="Wall")
+        self.file.createIfcRelAggregates(GlobalId=ifcopenshell.guid.new(), RelatingObject=wall)
+        ifcopenshell.ifcopenshell_wrapper.file.lazy_load(True)
+        try:
+            g = ifcopenshell.file.from_string(self.file.wrapped_data.to_string())
+        finally:
+            ifcopenshell.ifcopenshell_wrapper.file.lazy_load(False)
+        assert g.by_id(wall.id()).Name == "Wall"
+        assert g.by_type("IfcRelAggregates")[0].RelatingObject == g.by_id(wall.id())
+        assert g.by_guid(wall.GlobalId) == g.by_id(wall.id())
+        assert len(g.get_inverse(g.by_id(wall.id()))) == 1
+        assert len(list(g)) == 2
+
+    def test_loading_a_lazy_file_completely(self):
+        wall = self.file.createIfcWall(GlobalId=ifcopenshell.guid.new(), Name="Wall")
+        ifcopenshell.ifcopenshell_wrapper.file.lazy_load(True)
+        try:
+            g = ifcopenshell.file.from_string(self.file.wrapped_data.to_string())
+        finally:
+            ifcopenshell.ifcopenshell_wrapper.file.lazy_load(False)
+        g.wrapped_data.load_all()
+        g.wrapped_data.load_all()
+        assert g.by_id(wall.id()).Name == "Wall"
+        assert len(list(g)) == 1
+
+    def test_writing_only_the_journalled_changes(self, tmp_path):
+        self.file.createIfcWall(GlobalId=ifcopenshell.guid.new(), Name="Wall")
+        self.file.createIfcSlab(GlobalId=ifcopenshell.guid.new(), Name="Slab")
+        original = tmp_path / "original.ifc"
+        self.file.write(str(original))
+        g = ifcopenshell.open(str(original))
+        g.start_journal()
+        wall = g.by_type("IfcWall")[0]
+        wall.Name = "Changed"
+        g.remove(g.by_type("IfcSlab")[0])
+        column = g.createIfcColumn(GlobalId=ifcopenshell.guid.new())
+        assert g.journal_diff().count("\n") == 4
+        changed = tmp_path / "changed.ifc"
+        g.write_incremental(str(changed), str(original))
+        h = ifcopenshell.open(str(changed))
+        assert h.by_id(wall.id()).Name == "Changed"
+        assert not h.by_type("IfcSlab")
+        assert h.by_id(column.id()).is_a("IfcColumn")
+
+    def test_journal_started_after_changes_is_incomplete(self, tmp_path):
+        wall = self.file.createIfcWall(GlobalId=ifcopenshell.guid.new(), Name="Wall")
+        original = tmp_path / "original.ifc"
+        changed = tmp_path / "changed.ifc"
+        self.file.write(str(original))
+        self.file.start_journal()
+        wall.Name = "Changed"
+        with pytest.raises(RuntimeError):
+            self.file.write_incremental(str(changed), str(original))
+        self.file.write(str(original))
+        self.file.clear_journal()
+        wall.Name = "Changed again"
+        self.file.write_incremental(str(changed), str(original))
+        assert ifcopenshell.open(str(changed)).by_id(wall.id()).Name == "Changed again"
+
+    def test_reading_nested_numeric_aggregates(self):
+        points = self.file.createIfcCartesianPointList3D(((0.0, 0.0, 0.0), (1.0, 0.0, 0.0), (0.0, 1.0, 0.0)))
+        self.file.createIfcTriangulatedFaceSet(points, None, True, ((1, 2, 3), (3, 2, 1)), None)
+        g = ifcopenshell.file.from_string(self.file.wrapped_data.to_string())
+        assert g.by_type("IfcCartesianPointList3D")[0].CoordList == ((0.0, 0.0, 0.0), (1.0, 0.0, 0.0), (0.0, 1.0, 0.0))
+        assert g.by_type("IfcTriangulatedFaceSet")[0].CoordIndex == ((1, 2, 3), (3, 2, 1))
+
+    def test_reporting_memory_usage(self):
+        before = self.file.memory_usage()
+        self.file.createIfcWall(GlobalId=ifcopenshell.guid.new(), Name="Wall")
+        usage = self.file.memory_usage()
+        assert usage["instances"]["IfcWall"] > 0
+        assert usage["attributes"]["STRING"] > 0
+        assert usage["guid_map"] > 0
+        assert usage["total"] > before["total"]
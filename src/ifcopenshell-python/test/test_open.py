@@ -16,6 +16,7 @@
 # You should have received a copy of the GNU Lesser General Public License
 # along with IfcOpenShell.  If not, see <http://www.gnu.org/licenses/>.
 
+import os
 from pathlib import Path
 import pytest
 import ifcopenshell
@@ -58,6 +59,30 @@ class TestOpen:
             ".ifcXML",
         )
 
+    @pytest.mark.skipif(
+        "IFCOPENSHELL_TEST_LARGE_FILES" not in os.environ, reason="Writes a synthetic file larger than 4GB"
+    )
+    def test_open_ifcspf_larger_than_4gb(self, tmp_path):
+        path = tmp_path / "large.ifc"
+        with open(path, "w") as f:
+            f.write("ISO-10303-21;\nHEADER;\nFILE_DESCRIPTION((''),'2;1');\n")
+            f.write("FILE_NAME('','',(''),(''),'','','');\nFILE_SCHEMA(('IFC4'));\nENDSEC;\nDATA;\n")
+            f.write("#1=IFCCARTESIANPOINT((0.,0.,0.));\n")
+            # Pad the data section with a comment so that the next instance starts beyond 2^32
+            padding = "x" * (1 << 24)
+            f.write("/*")
+            for _ in range(257):
+                f.write(padding)
+            f.write("*/\n")
+            f.write("#2=IFCAXIS2PLACEMENT3D(#1,$,$);\n")
+            f.write("#3=IFCCARTESIANPOINT((1.,2.,3.));\n")
+            f.write("ENDSEC;\nEND-ISO-10303-21;\n")
+        assert path.stat().st_size > 1 << 32
+        ifc_file = ifcopenshell.open(path)
+        assert ifc_file.by_id(2).Location == ifc_file.by_id(1)
+        assert ifc_file.by_id(3).Coordinates == (1.0, 2.0, 3.0)
+        assert len(ifc_file.get_inverse(ifc_file.by_id(1))) == 1
+
     @pytest.mark.skip("IFC-XML temporarily disabled")
     def test_invalid_ifcspf(self):
         with pytest.raises(ifcopenshell.Error):
@@ -67,3 +92,31 @@ class TestOpen:
     def test_invalid_ifcxml(self):
         with pytest.raises(IOError):
             assert ifcopenshell.open(TEST_FILE_DIR / "invalid.ifcxml")
+
+    def test_open_ifcspf_snapshot(self, tmp_path):
+        source = str(TEST_FILE_DIR / "WallInstance_IFC4Add2.ifc")
+        snapshot = str(tmp_path / "WallInstance_IFC4Add2.ifc.snapshot")
+        f = ifcopenshell.open(source)
+        assert f.wrapped_data.write_snapshot(snapshot, source)
+        g = ifcopenshell.file(ifcopenshell.ifcopenshell_wrapper.file.read_snapshot(snapshot, source))
+        assert g.wrapped_data.to_string() == f.wrapped_data.to_string()
+        wall = f.by_type("IfcWall")[0]
+        assert g.by_guid(wall.GlobalId).id() == wall.id()
+        assert len(g.get_inverse(g.by_id(wall.id()))) == len(f.get_inverse(wall))
+
+        modified = str(tmp_path / "modified.ifc")
+        with open(source, "rb") as src, open(modified, "wb") as dst:
+            dst.write(src.read() + b"\n")
+        assert ifcopenshell.ifcopenshell_wrapper.file.read_snapshot(snapshot, modified) is None
+
+    def test_open_ifcspf_snapshot_after_touching_the_source(self, tmp_path):
+        source = tmp_path / "WallInstance_IFC4Add2.ifc"
+        source.write_bytes((TEST_FILE_DIR / "WallInstance_IFC4Add2.ifc").read_bytes())
+        snapshot = str(tmp_path / "WallInstance_IFC4Add2.ifc.snapshot")
+        assert ifcopenshell.open(source).wrapped_data.write_snapshot(snapshot, str(source))
+        assert ifcopenshell.ifcopenshell_wrapper.file.read_snapshot(snapshot, str(source), True) is not None
+
+        # The modification time is part of the validation, even when the contents are unchanged
+        mtime = source.stat().st_mtime
+        os.utime(source, (mtime + 10, mtime + 10))
+        assert ifcopenshell.ifcopenshell_wrapper.file.read_snapshot(snapshot, str(source)) is None
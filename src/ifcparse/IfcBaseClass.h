@@ -27,6 +27,7 @@
 #include "utils.h"
 
 #include <atomic>
+#include <type_traits>
 #include <boost/shared_ptr.hpp>
 
 class aggregate_of_instance;
@@ -37,6 +38,15 @@ namespace IfcParse {
 
 namespace IfcUtil {
 
+/// Whether T is a class generated for an entity of a schema, which is
+/// identified by the entity declaration returned by T::Class()
+template <typename T, typename = void>
+struct is_entity_class : std::false_type {};
+
+template <typename T>
+struct is_entity_class<T, std::void_t<decltype(T::Class())>>
+    : std::is_same<decltype(T::Class()), const IfcParse::entity&> {};
+
 class IFC_PARSE_API IfcBaseInterface {
   protected:
     static bool is_null(const IfcBaseInterface* not_this) {
@@ -53,6 +63,18 @@ class IFC_PARSE_API IfcBaseInterface {
         throw IfcParse::IfcException("Instance of type " + this->declaration().name() + " cannot be cast to base class");
     }
 
+    // Whether the declaration of this instance is T::Class() or a subtype of
+    // it, when T is an entity class
+    template <typename T>
+    std::enable_if_t<is_entity_class<T>::value, bool> is_declaration_of() const {
+        return this->declaration().is(T::Class());
+    }
+
+    template <typename T>
+    std::enable_if_t<!is_entity_class<T>::value, bool> is_declaration_of() const {
+        return true;
+    }
+
   public:
     virtual const IfcEntityInstanceData& data() const = 0;
     virtual IfcEntityInstanceData& data() = 0;
@@ -65,7 +87,12 @@ class IFC_PARSE_API IfcBaseInterface {
         if (is_null(this)) {
             return static_cast<T*>(0);
         }
-        auto type = dynamic_cast<T*>(this);
+        T* type = nullptr;
+        // Instances of entities that are not a subtype of T are rejected
+        // without a dynamic_cast
+        if (!is_entity_class<T>::value || is_declaration_of<T>()) {
+            type = dynamic_cast<T*>(this);
+        }
         if (do_throw && !type) {
             raise_error_on_concrete_class<T>();
         }
@@ -77,7 +104,10 @@ class IFC_PARSE_API IfcBaseInterface {
         if (is_null(this)) {
             return static_cast<const T*>(0);
         }
-        auto type = dynamic_cast<const T*>(this);
+        const T* type = nullptr;
+        if (!is_entity_class<T>::value || is_declaration_of<T>()) {
+            type = dynamic_cast<const T*>(this);
+        }
         if (do_throw && !type) {
             raise_error_on_concrete_class<T>();
         }
@@ -104,11 +134,56 @@ public:
         , data_(std::move(data))
     {}
 
+    // Instances are allocated in the arena of the file being read, if any
+    static void* operator new(size_t n) { return IfcParse::arena::allocate(n); }
+    static void operator delete(void* p) { IfcParse::arena::deallocate(p); }
+
     const IfcEntityInstanceData& data() const { return data_; }
     IfcEntityInstanceData& data() { return data_; }
 
     virtual const IfcParse::declaration& declaration() const = 0;
 
+    // Instances of the classes generated for a schema are only created for
+    // declarations of that schema, and entity classes derive from
+    // IfcBaseClass without virtual inheritance. Hence, when T is such a class,
+    // a declaration that is a subtype of T::Class() suffices to cast.
+
+    template <class T>
+    T* as(bool do_throw = false) {
+        if constexpr (is_entity_class<T>::value && std::is_base_of<IfcBaseClass, T>::value) {
+            if (is_null(this)) {
+                return static_cast<T*>(0);
+            }
+            if (is_declaration_of<T>()) {
+                return static_cast<T*>(this);
+            }
+            if (do_throw) {
+                raise_error_on_concrete_class<T>();
+            }
+            return static_cast<T*>(0);
+        } else {
+            return IfcBaseInterface::as<T>(do_throw);
+        }
+    }
+
+    template <class T>
+    const T* as(bool do_throw = false) const {
+        if constexpr (is_entity_class<T>::value && std::is_base_of<IfcBaseClass, T>::value) {
+            if (is_null(this)) {
+                return static_cast<const T*>(0);
+            }
+            if (is_declaration_of<T>()) {
+                return static_cast<const T*>(this);
+            }
+            if (do_throw) {
+                raise_error_on_concrete_class<T>();
+            }
+            return static_cast<const T*>(0);
+        } else {
+            return IfcBaseInterface::as<T>(do_throw);
+        }
+    }
+
     template <typename T>
     void set_attribute_value(size_t i, const T& t);
 
@@ -149,6 +224,10 @@ class IFC_PARSE_API IfcBaseEntity : public IfcBaseClass {
 
     AttributeValue get(const std::string& name) const;
 
+    /// Returns the attribute value at the position of the handle, which needs
+    /// to be obtained from the declaration of this instance or a supertype
+    AttributeValue get(const IfcParse::attribute_handle& handle) const;
+
     template <typename T>
     T get_value(const std::string& name) const;
 
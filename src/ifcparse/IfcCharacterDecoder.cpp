@@ -80,13 +80,13 @@ IfcCharacterDecoder::~IfcCharacterDecoder() {
 }
 
 namespace {
-unsigned int reference_helper = 0;
+size_t reference_helper = 0;
 
 class pure_impure_helper {
   private:
     bool pure_;
     IfcParse::IfcSpfStream* stream_;
-    unsigned int& pointer_;
+    size_t& pointer_;
     std::wstring builder_;
 
     char peek() {
@@ -96,7 +96,7 @@ class pure_impure_helper {
         return stream_->Peek();
     }
 
-    unsigned int tell() {
+    size_t tell() {
         if (pure_) {
             return pointer_;
         }
@@ -117,7 +117,7 @@ class pure_impure_helper {
           stream_(stream),
           pointer_(reference_helper) {}
 
-    pure_impure_helper(IfcParse::IfcSpfStream* stream, unsigned int& pointer)
+    pure_impure_helper(IfcParse::IfcSpfStream* stream, size_t& pointer)
         : pure_(true),
           stream_(stream),
           pointer_(pointer) {}
@@ -244,7 +244,7 @@ IfcCharacterDecoder::operator std::string() {
     return pure_impure_helper(stream_).get(mode, substitution_character);
 }
 
-std::string IfcCharacterDecoder::get(unsigned int& ptr) {
+std::string IfcCharacterDecoder::get(size_t& ptr) {
     return pure_impure_helper(stream_, ptr).get(mode, substitution_character);
 }
 
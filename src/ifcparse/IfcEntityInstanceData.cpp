@@ -18,8 +18,8 @@ public:
     int operator()(const empty_aggregate_of_aggregate_t& /*unused*/) const { return 0; }
     int operator()(const std::vector<int>& i) const { return (int)i.size(); }
     int operator()(const std::vector<double>& i) const { return (int)i.size(); }
-    int operator()(const std::vector<std::vector<int>>& i) const { return (int)i.size(); }
-    int operator()(const std::vector<std::vector<double>>& i) const { return (int)i.size(); }
+    int operator()(const flat_aggregate_of_aggregate<int>& i) const { return (int)i.size(); }
+    int operator()(const flat_aggregate_of_aggregate<double>& i) const { return (int)i.size(); }
     int operator()(const std::vector<std::string>& i) const { return (int)i.size(); }
     int operator()(const std::vector<boost::dynamic_bitset<>>& i) const { return (int)i.size(); }
     int operator()(const EnumerationReference& /*i*/) const { return -1; }
@@ -28,6 +28,79 @@ public:
     int operator()(const aggregate_of_aggregate_of_instance::ptr& i) const { return i->size(); }
 };
 
+namespace {
+    size_t heap_usage(const std::string& s) {
+        // Short strings are stored within the object
+        const char* object = reinterpret_cast<const char*>(&s);
+        if (s.data() >= object && s.data() < object + sizeof(std::string)) {
+            return 0;
+        }
+        return s.capacity() + 1;
+    }
+
+    size_t heap_usage(const boost::dynamic_bitset<>& b) {
+        return b.num_blocks() * sizeof(boost::dynamic_bitset<>::block_type);
+    }
+}
+
+// Estimates the memory held by an attribute value outside of the storage_t
+// in which it resides
+class MemoryUsageVisitor {
+public:
+    typedef size_t result_type;
+
+    template <typename T>
+    size_t operator()(const T& /*i*/) const { return 0; }
+    size_t operator()(const std::string& i) const { return heap_usage(i); }
+    size_t operator()(const boost::dynamic_bitset<>& i) const { return heap_usage(i); }
+    size_t operator()(const std::vector<int>& i) const { return i.capacity() * sizeof(int); }
+    size_t operator()(const std::vector<double>& i) const { return i.capacity() * sizeof(double); }
+    size_t operator()(const std::vector<std::string>& i) const {
+        size_t n = i.capacity() * sizeof(std::string);
+        for (const auto& s : i) {
+            n += heap_usage(s);
+        }
+        return n;
+    }
+    size_t operator()(const std::vector<boost::dynamic_bitset<>>& i) const {
+        size_t n = i.capacity() * sizeof(boost::dynamic_bitset<>);
+        for (const auto& b : i) {
+            n += heap_usage(b);
+        }
+        return n;
+    }
+    template <typename T>
+    size_t operator()(const flat_aggregate_of_aggregate<T>& i) const {
+        return i.values().capacity() * sizeof(T) + i.offsets().capacity() * sizeof(size_t);
+    }
+    size_t operator()(const aggregate_of_instance::ptr& i) const {
+        return i ? sizeof(aggregate_of_instance) + i->size() * sizeof(IfcUtil::IfcBaseClass*) : 0;
+    }
+    size_t operator()(const aggregate_of_aggregate_of_instance::ptr& i) const {
+        if (!i) {
+            return 0;
+        }
+        size_t n = sizeof(aggregate_of_aggregate_of_instance) + i->size() * sizeof(std::vector<IfcUtil::IfcBaseClass*>);
+        for (auto it = i->begin(); it != i->end(); ++it) {
+            n += it->capacity() * sizeof(IfcUtil::IfcBaseClass*);
+        }
+        return n;
+    }
+};
+
+size_t IfcEntityInstanceData::memory_usage(std::map<IfcUtil::ArgumentType, size_t>& usage) const {
+    size_t unattributed = storage_.memory_usage();
+    for (size_t i = 0, count = (size_t) storage_.size(); i < count; ++i) {
+        size_t n = storage_.memory_usage(i);
+        unattributed -= n;
+        if (!storage_.is_shared(i)) {
+            n += storage_.apply_visitor(MemoryUsageVisitor{}, i);
+        }
+        usage[static_cast<IfcUtil::ArgumentType>(storage_.index(i))] += n;
+    }
+    return unattributed;
+}
+
 AttributeValue::operator int() const
 {
     return array_->get<int>(index_);
@@ -98,12 +171,12 @@ AttributeValue::operator boost::shared_ptr<aggregate_of_instance>() const
 
 AttributeValue::operator std::vector<std::vector<int>>() const
 {
-    return array_->get<std::vector<std::vector<int>>>(index_);
+    return array_->get<flat_aggregate_of_aggregate<int>>(index_).as_vector_of_vector();
 }
 
 AttributeValue::operator std::vector<std::vector<double>>() const
 {
-    return array_->get<std::vector<std::vector<double>>>(index_);
+    return array_->get<flat_aggregate_of_aggregate<double>>(index_).as_vector_of_vector();
 }
 
 AttributeValue::operator boost::shared_ptr<aggregate_of_aggregate_of_instance>() const
@@ -23,6 +23,7 @@
 #include "ArgumentType.h"
 #include "variantarray.h"
 #include "aggregate_of_instance.h"
+#include "flat_aggregate_of_aggregate.h"
 #include "IfcSchema.h"
 
 #include <boost/optional.hpp>
@@ -30,6 +31,8 @@
 #include <boost/logic/tribool.hpp>
 #include <boost/dynamic_bitset.hpp>
 
+#include <map>
+
 class EnumerationReference {
 private:
     const IfcParse::enumeration_type* enumeration_;
@@ -108,9 +111,10 @@ typedef VariantArray <
     // AGGREGATES OF AGGREGATES:
     empty_aggregate_of_aggregate_t,
     // An aggregate of an aggregate of ints. E.g. ((1, 2), (3))
-    std::vector<std::vector<int>>,
+    // Stored flat, see flat_aggregate_of_aggregate.h
+    flat_aggregate_of_aggregate<int>,
     // An aggregate of an aggregate of floats. E.g. ((1., 2.3), (4.))
-    std::vector<std::vector<double>>,
+    flat_aggregate_of_aggregate<double>,
     // An aggregate of an aggregate of entities. E.g. ((#1, #2), (#3))
     aggregate_of_aggregate_of_instance::ptr
 > storage_t;
@@ -153,6 +157,13 @@ struct AttributeValue {
     operator std::vector<std::vector<double>>() const;
     operator boost::shared_ptr<aggregate_of_aggregate_of_instance>() const;
 
+    // Returns the aggregate of aggregates of ints or floats without copying
+    // it into nested vectors. T is either int or double.
+    template <typename T>
+    const flat_aggregate_of_aggregate<T>& as_flat_aggregate_of_aggregate() const {
+        return array_->get<flat_aggregate_of_aggregate<T>>(index_);
+    }
+
     bool isNull() const;
     unsigned int size() const;
 
@@ -193,6 +204,13 @@ class IFC_PARSE_API IfcEntityInstanceData {
         return storage_.size();
     }
 
+    /// Adds the estimated number of bytes occupied by every attribute value to
+    /// usage, keyed by the type of the value. This includes the memory held by
+    /// strings and aggregates, but not that of interned strings and of the
+    /// instances referred to. Returns the number of bytes of the storage that
+    /// is not attributed to a value.
+    size_t memory_usage(std::map<IfcUtil::ArgumentType, size_t>& usage) const;
+
     void toString(std::ostream&, bool upper = false, const IfcParse::entity* ent = nullptr) const;
 };
 
@@ -1,10 +1,12 @@
 #include "IfcFile.h"
 #include "IfcLogger.h"
+#include "string_pool.h"
 
 IfcParse::parse_context::~parse_context() {
     for (auto& t : tokens_) {
         boost::apply_visitor([](auto& v) {
-            if constexpr (std::is_same_v<std::decay_t<decltype(v)>, parse_context*>) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(v)>, parse_context*> ||
+                          std::is_same_v<std::decay_t<decltype(v)>, numeric_aggregate*>) {
                 delete v;
             }
         }, t);
@@ -25,6 +27,10 @@ void IfcParse::parse_context::push(IfcUtil::IfcBaseClass* inst) {
     tokens_.push_back(inst);
 }
 
+void IfcParse::parse_context::push(numeric_aggregate* aggregate) {
+    tokens_.push_back(aggregate);
+}
+
 namespace {
     template<typename Variant, typename T>
     struct is_type_in_variant;
@@ -81,6 +87,13 @@ namespace {
         }
     }
 
+    // GlobalIds are unique, so these are not interned
+    bool is_interned(const IfcParse::parameter_type* param_type) {
+        return param_type == nullptr ||
+            param_type->as_named_type() == nullptr ||
+            param_type->as_named_type()->declared_type()->name() != "IfcGloballyUniqueId";
+    }
+
     template <size_t Depth, typename Fn>
     void construct_(IfcParse::parse_context& p, const IfcParse::aggregation_type* aggr, Fn fn) {
         if (p.tokens_.empty()) {
@@ -97,13 +110,13 @@ namespace {
                 } else if (aggr_type == IfcUtil::Argument_AGGREGATE_OF_BINARY) {
                     fn(std::vector<boost::dynamic_bitset<>>{});
                 } else if (aggr_type == IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE) {
-                    fn(aggregate_of_instance::ptr(new aggregate_of_instance));
+                    fn(IfcParse::make_shared_in_arena<aggregate_of_instance>());
                 } else if (aggr_type == IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_INT) {
                     fn(std::vector<std::vector<int>>{});
                 } else if (aggr_type == IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_DOUBLE) {
                     fn(std::vector<std::vector<double>>{});
                 } else if (aggr_type == IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE) {
-                    fn(aggregate_of_aggregate_of_instance::ptr(new aggregate_of_aggregate_of_instance));
+                    fn(IfcParse::make_shared_in_arena<aggregate_of_aggregate_of_instance>());
                 }
             }
             return;
@@ -217,6 +230,8 @@ namespace {
                     if constexpr (Depth < 3) {
                         construct_<Depth + 1>(*v, nullptr, append_to_aggregate_storage);
                     }
+                } else if constexpr (std::is_same_v<std::decay_t<decltype(v)>, IfcParse::numeric_aggregate*>) {
+                    // Only read for attribute values, see construct()
                 } else {
                     append_to_aggregate_storage(IfcParse::reference_or_simple_type{ v });
                 }
@@ -227,6 +242,25 @@ namespace {
     }
 }
 
+namespace {
+    template <typename T>
+    struct is_std_vector_of_vector : std::false_type {};
+    template <typename T>
+    struct is_std_vector_of_vector<std::vector<std::vector<T>>> : std::true_type {};
+    template <typename T>
+    constexpr bool is_std_vector_of_vector_v = is_std_vector_of_vector<T>::value;
+
+    // Moves the numbers out of the aggregate, which is only constructed once
+    template <typename T>
+    void set_numeric_aggregate(storage_t& storage, uint8_t index, IfcParse::numeric_aggregate& aggregate, std::vector<T>& values) {
+        if (aggregate.nested) {
+            storage.set(index, flat_aggregate_of_aggregate<T>(std::move(values), std::move(aggregate.offsets)));
+        } else {
+            storage.set(index, std::move(values));
+        }
+    }
+}
+
 IfcEntityInstanceData IfcParse::parse_context::construct(int name, unresolved_references& references_to_resolve, const IfcParse::declaration* decl, boost::optional<size_t> expected_size) {
     std::vector<const IfcParse::parameter_type*> parameter_types;
     std::unique_ptr<IfcParse::named_type> transient_named_type;
@@ -237,7 +271,8 @@ IfcEntityInstanceData IfcParse::parse_context::construct(int name, unresolved_re
         transient_named_type.reset(new IfcParse::named_type(const_cast<IfcParse::declaration*>(decl)));
         parameter_types = { &*transient_named_type };
     } else if ((decl != nullptr) && (decl->as_entity() != nullptr)) {
-        auto entity_attrs = decl->as_entity()->all_attributes();
+        const auto& entity_attrs = decl->as_entity()->all_attributes();
+        parameter_types.reserve(entity_attrs.size());
         std::transform(
             entity_attrs.begin(),
             entity_attrs.end(),
@@ -264,6 +299,8 @@ IfcEntityInstanceData IfcParse::parse_context::construct(int name, unresolved_re
         : tokens_.size()
     );
 
+    auto* strings = IfcParse::string_pool::current();
+
     auto it = tokens_.begin();
     auto kt = parameter_types.begin();
     for (; it != tokens_.end() && ((decl == nullptr) || kt != parameter_types.end()); ++it) {
@@ -276,10 +313,16 @@ IfcEntityInstanceData IfcParse::parse_context::construct(int name, unresolved_re
 
         auto index = (uint8_t) std::distance(tokens_.begin(), it);
 
-        boost::apply_visitor([this, &storage, name, &references_to_resolve, index, param_type](const auto& v) {
+        boost::apply_visitor([this, &storage, name, &references_to_resolve, index, param_type, strings](const auto& v) {
             if constexpr (std::is_same_v<std::decay_t<decltype(v)>, IfcParse::Token>) {
-                dispatch_token(v, param_type && param_type->as_named_type() ? param_type->as_named_type()->declared_type() : nullptr, [this, &storage, name, &references_to_resolve, index](auto v) {
-                    if constexpr (std::is_same_v<std::decay_t<decltype(v)>, IfcParse::reference_or_simple_type>) {
+                dispatch_token(v, param_type && param_type->as_named_type() ? param_type->as_named_type()->declared_type() : nullptr, [this, &storage, name, &references_to_resolve, index, param_type, strings](const auto& v) {
+                    if constexpr (std::is_same_v<std::decay_t<decltype(v)>, std::string>) {
+                        if (strings != nullptr && is_interned(param_type)) {
+                            storage.set_shared(index, strings->intern(v));
+                        } else {
+                            storage.set(index, v);
+                        }
+                    } else if constexpr (std::is_same_v<std::decay_t<decltype(v)>, IfcParse::reference_or_simple_type>) {
                         if (name > 0) {
                             references_to_resolve.push_back(std::make_pair(
                                 // @todo previously this was storage but apparently the 
@@ -309,10 +352,18 @@ IfcEntityInstanceData IfcParse::parse_context::construct(int name, unresolved_re
                         if (name > 0) {
                             references_to_resolve.push_back({ {name, index }, v });
                         }
+                    } else if constexpr (is_std_vector_of_vector_v<std::decay_t<decltype(v)>>) {
+                        storage.set(index, flat_aggregate_of_aggregate<typename std::decay_t<decltype(v)>::value_type::value_type>(v));
                     } else {
                         storage.set(index, v);
                     }
                 });
+            } else if constexpr (std::is_same_v<std::decay_t<decltype(v)>, IfcParse::numeric_aggregate*>) {
+                if (v->integers) {
+                    set_numeric_aggregate(storage, index, *v, v->ints);
+                } else {
+                    set_numeric_aggregate(storage, index, *v, v->reals);
+                }
             } else {
                 storage.set(index, v);
             }
@@ -22,17 +22,28 @@
 
 #include "ifc_parse_api.h"
 #include "IfcParse.h"
+#include "IfcFileView.h"
+#include "change_journal.h"
 #include "IfcSchema.h"
 #include "IfcSpfHeader.h"
+#include "arena.h"
+#include "guid_index.h"
+#include "inverse_index.h"
+#include "string_pool.h"
 
+#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <boost/variant.hpp>
 #include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 
 namespace IfcParse {
 
@@ -69,12 +80,57 @@ class IFC_PARSE_API file_open_status {
 typedef boost::variant<int, IfcUtil::IfcBaseClass*> reference_or_simple_type;
 typedef std::list<std::pair<MutableAttributeValue, boost::variant<reference_or_simple_type, std::vector<reference_or_simple_type>, std::vector<std::vector<reference_or_simple_type>>>>> unresolved_references;
 
+/// The numbers of an aggregate of numbers, or of an aggregate of aggregates
+/// of numbers, read from the file without creating tokens and nested parse
+/// contexts for them.
+struct numeric_aggregate {
+    bool integers = false;
+    bool nested = false;
+    std::vector<int> ints;
+    std::vector<double> reals;
+    // For nested aggregates, offsets[i] to offsets[i + 1] delimits the
+    // numbers of the i-th inner aggregate
+    std::vector<size_t> offsets;
+};
+
+/// The estimated number of bytes held by an IfcFile by category, see
+/// IfcFile::memory_statistics(). Memory allocated in the arena of the file is
+/// attributed to the instances and attribute values it holds.
+struct IFC_PARSE_API file_memory_statistics {
+    /// The instance objects and the type indices of their attribute storage,
+    /// by declaration. Includes the simple type instances owned by the file.
+    std::map<const IfcParse::declaration*, size_t> instances;
+    /// The attribute values of these instances, by the type of the value
+    std::map<IfcUtil::ArgumentType, size_t> attributes;
+    /// The index of the instances referring to an instance
+    size_t inverse_index = 0;
+    /// The index of the instances by GlobalId
+    size_t guid_map = 0;
+    /// The indices of the instances by name and type, and of the instances
+    /// not read yet when the file is lazily loaded
+    size_t instance_maps = 0;
+    /// The header entities and their attribute values
+    size_t header = 0;
+    /// The SPF data held by the stream and the lexer, which are only retained
+    /// after reading when the file is lazily loaded
+    size_t stream = 0;
+    /// The string values interned when reading the file
+    size_t strings = 0;
+    /// Memory reserved by the arena, but not allocated
+    size_t arena_unused = 0;
+    /// The change journal
+    size_t journal = 0;
+
+    size_t total() const;
+};
+
 struct parse_context {
-    std::list<
+    std::vector<
         boost::variant<
         IfcUtil::IfcBaseClass*,
         Token,
-        parse_context*
+        parse_context*,
+        numeric_aggregate*
         >> tokens_;
 
     parse_context() {};
@@ -92,6 +148,8 @@ struct parse_context {
 
     void push(IfcUtil::IfcBaseClass* inst);
 
+    void push(numeric_aggregate* aggregate);
+
     IfcEntityInstanceData construct(int name, unresolved_references& references_to_resolve, const IfcParse::declaration* decl, boost::optional<size_t> expected_size);
 };
 
@@ -104,14 +162,14 @@ class IFC_PARSE_API IfcFile {
     typedef std::map<const IfcParse::declaration*, aggregate_of_instance::ptr> entities_by_type_t;
     typedef boost::unordered_map<unsigned int, IfcUtil::IfcBaseClass*> entity_by_id_t;
     typedef boost::unordered_map<uint32_t, IfcUtil::IfcBaseClass*> entity_by_iden_t;
-    typedef std::map<std::string, IfcUtil::IfcBaseClass*> entity_by_guid_t;
-    typedef std::tuple<int, short, short> inverse_attr_record;
+    typedef IfcParse::guid_index entity_by_guid_t;
+    typedef IfcParse::inverse_index::key_type inverse_attr_record;
     enum INVERSE_ATTR {
         INSTANCE_ID,
         INSTANCE_TYPE,
         ATTRIBUTE_INDEX
     };
-    typedef std::map<inverse_attr_record, std::vector<int>> entities_by_ref_t;
+    typedef IfcParse::inverse_index entities_by_ref_t;
     typedef std::map<int, std::vector<int>> entities_by_ref_excl_t;
     typedef std::map<unsigned int, aggregate_of_instance::ptr> ref_map_t;
     typedef entity_by_id_t::const_iterator const_iterator;
@@ -153,7 +211,54 @@ class IFC_PARSE_API IfcFile {
     static bool guid_map() { return guid_map_; }
     static void guid_map(bool b) { guid_map_ = b; }
 
+    /// Number of threads used to read the data section of SPF files. The data
+    /// section is split into chunks at instance boundaries that are read
+    /// concurrently and merged afterwards. 0 uses the hardware concurrency,
+    /// 1 (default) reads the file sequentially. The same number of threads is
+    /// used to build the inverse index, also in build_inverses().
+    static unsigned parse_threads_;
+    static unsigned parse_threads() { return parse_threads_; }
+    static void parse_threads(unsigned n) { parse_threads_ = n; }
+
+    /// Number of threads used to format instances when writing SPF files with
+    /// operator<<, see IfcSpfWriter. 0 uses the hardware concurrency, 1
+    /// (default) formats the instances on the calling thread.
+    static unsigned write_threads_;
+    static unsigned write_threads() { return write_threads_; }
+    static void write_threads(unsigned n) { write_threads_ = n; }
+
+    /// When enabled, opening a file only scans the data section to record the
+    /// offset and type of every instance. Instances are parsed when first
+    /// requested by instance_by_id() or instances_by_type(), together with the
+    /// instances they refer to. Operations that need the complete file, such
+    /// as inverse lookups, iteration and removal, parse the remaining
+    /// instances. The stream needs to remain valid for the lifetime of the file.
+    /// As parsing on demand modifies the file, also from const member functions,
+    /// a lazily loaded file must only be accessed by a single thread until
+    /// load_all() has been called.
+    static bool lazy_load_;
+    static bool lazy_load() { return lazy_load_; }
+    static void lazy_load(bool b) { lazy_load_ = b; }
+
+    /// Parses the instances that have not been parsed yet in lazy mode, after
+    /// which the file can be read concurrently. Does nothing for files that are
+    /// fully loaded.
+    void load_all() { materialize_all_(); }
+
+    /// When enabled, string attribute values parsed from SPF files are stored once
+    /// per distinct value in a pool owned by the file, instead of as a copy per
+    /// attribute. GlobalIds and strings in aggregates are stored as before.
+    static bool intern_strings_;
+    static bool intern_strings() { return intern_strings_; }
+    static void intern_strings(bool b) { intern_strings_ = b; }
+
   private:
+    // Parses instances using the schema and routines of a file that does not
+    // hold them
+    friend class IfcSpfReader;
+    // Records modifications by set_attribute_value() for commit()
+    friend class IfcUtil::IfcBaseClass;
+
     typedef std::map<uint32_t, IfcUtil::IfcBaseClass*> entity_entity_map_t;
 
     file_open_status good_ = file_open_status::SUCCESS;
@@ -163,6 +268,12 @@ class IFC_PARSE_API IfcFile {
 
     // std::vector<Argument*> internal_attribute_vector_, internal_attribute_vector_simple_type_;
 
+    // Holds the instances and attribute values created while reading the
+    // file. Declared before the members that may refer to memory within it.
+    arena arena_;
+    // Holds the interned string attribute values when intern_strings() is enabled
+    string_pool strings_;
+
     entity_by_id_t byid_;
     // this is for simple types
     entity_by_iden_t byidentity_;
@@ -181,19 +292,88 @@ class IFC_PARSE_API IfcFile {
 
     void initialize_(IfcParse::IfcSpfStream* stream);
 
+    /// Instances and references read from a contiguous range of the data
+    /// section. Ranges are read independently and merged in file order.
+    struct data_section_chunk {
+        size_t begin = 0;
+        size_t end = std::numeric_limits<size_t>::max();
+        // Offset of the first instance name encountered at or beyond end
+        size_t next = std::numeric_limits<size_t>::max();
+        bool syntax_error = false;
+        std::vector<IfcUtil::IfcBaseClass*> instances;
+        // Spliced into the arena and string pool of the file when merged
+        arena storage;
+        string_pool strings;
+        entities_by_ref_t byref;
+        unresolved_references references_to_resolve;
+    };
+
+    void read_data_section_(IfcParse::IfcSpfLexer* lexer, data_section_chunk& chunk, bool report_progress);
+    bool read_data_section_parallel_(unsigned num_threads);
+    void merge_data_section_(data_section_chunk& chunk);
+    void register_parsed_instance_(IfcUtil::IfcBaseClass* instance);
+
+    void load_(IfcParse::IfcSpfLexer* lexer, entities_by_ref_t& byref, unresolved_references& references, unsigned entity_instance_name, const IfcParse::entity* entity, parse_context&, int attribute_index);
+
     void build_inverses_(IfcUtil::IfcBaseClass*);
 
+    void resolve_references_(unresolved_references& references);
+
+    /// Location in the data section of an instance that has not been parsed yet
+    struct unloaded_instance {
+        unsigned name;
+        size_t offset;
+        const IfcParse::declaration* decl;
+    };
+
+    // Sorted by instance name, entries remain after they have been parsed
+    std::vector<unloaded_instance> unloaded_;
+    std::map<const IfcParse::declaration*, std::vector<unsigned>> unloaded_by_type_;
+    std::unique_ptr<IfcParse::IfcSpfStream> owned_stream_;
+
+    void scan_data_section_();
+    const unloaded_instance* find_unloaded_(unsigned name) const;
+    /// Parses the instances and the instances they refer to, if not already present.
+    void materialize_(std::vector<unsigned> names);
+    /// Parses all remaining instances and discards the offset index.
+    void materialize_all_();
+
     typedef boost::multi_index_container<
         int,
         boost::multi_index::indexed_by<
             boost::multi_index::sequenced<>,
-            boost::multi_index::ordered_unique<
+            boost::multi_index::hashed_unique<
                 boost::multi_index::identity<int>>>>
         batch_deletion_ids_t;
     batch_deletion_ids_t batch_deletion_ids_;
     bool batch_mode_ = false;
     void process_deletion_();
 
+    // The most recently committed version
+    IfcFileView::ptr committed_;
+    mutable std::mutex committed_mutex_;
+
+    // Names of the instances that were added, modified or removed, and of
+    // the instances of which the inverses changed since the last commit().
+    // Only recorded once a version has been committed.
+    bool track_changes_ = false;
+    boost::unordered_set<unsigned> changed_instances_;
+    boost::unordered_set<unsigned> changed_inverses_;
+
+    void instance_changed_(unsigned id) {
+        if (track_changes_) {
+            changed_instances_.insert(id);
+        }
+    }
+
+    void inverses_changed_(unsigned id) {
+        if (track_changes_ && id != 0) {
+            changed_inverses_.insert(id);
+        }
+    }
+
+    change_journal journal_;
+
   public:
     IfcParse::IfcSpfLexer* tokens;
     IfcParse::IfcSpfStream* stream;
@@ -203,8 +383,8 @@ class IFC_PARSE_API IfcFile {
 #else
     IfcFile(const std::string& path);
 #endif
-    IfcFile(std::istream& stream, int length);
-    IfcFile(void* data, int length);
+    IfcFile(std::istream& stream, size_t length);
+    IfcFile(void* data, size_t length);
     IfcFile(IfcParse::IfcSpfStream* stream);
     IfcFile(const IfcParse::schema_definition* schema = IfcParse::schema_by_name("IFC4"));
 
@@ -272,6 +452,10 @@ class IFC_PARSE_API IfcFile {
     /// Returns the entity with the specified GlobalId
     IfcUtil::IfcBaseClass* instance_by_guid(const std::string& guid);
 
+    /// Returns the entities with the specified GlobalIds, in the same order,
+    /// with nullptr for GlobalIds that are not found
+    std::vector<IfcUtil::IfcBaseClass*> instances_by_guid(const std::vector<std::string>& guids);
+
     /// Performs a depth-first traversal, returning all entity instance
     /// attributes as a flat list. NB: includes the root instance specified
     /// in the first function argument.
@@ -305,12 +489,29 @@ class IFC_PARSE_API IfcFile {
     IfcUtil::IfcBaseClass* addEntity(IfcUtil::IfcBaseClass* entity, int id = -1);
     void addEntities(aggregate_of_instance::ptr entities);
 
+    /// Defers the removal of entity instances by removeEntity() until
+    /// unbatch(), which removes them all at once. This is considerably faster
+    /// when removing many instances, because the references to the removed
+    /// instances are unset in a single pass over the instances that refer to
+    /// them.
     void batch() { batch_mode_ = true; }
+
+    /// Removes the instances passed to removeEntity() since batch(). Either
+    /// all of them are removed, or, when an exception is thrown, none are
+    /// and the file is left in batch mode, so that the removal can be
+    /// retried or discarded with rollback_batch().
     void unbatch() {
         process_deletion_();
         batch_mode_ = false;
     }
 
+    /// Discards the removals requested since batch() and leaves batch mode.
+    /// Instances are only removed by unbatch(), so the file is unaltered.
+    void rollback_batch() {
+        batch_deletion_ids_.clear();
+        batch_mode_ = false;
+    }
+
     /// Removes entity instance from file and unsets references.
     ///
     /// Attention when running removeEntity inside a loop over a list of entities to be removed.
@@ -338,8 +539,69 @@ class IFC_PARSE_API IfcFile {
 
     std::pair<IfcUtil::IfcBaseClass*, double> getUnit(const std::string& unit_type);
 
+    /// Appends the references in the attributes of all instances to the
+    /// inverse index, scanning the instances on parse_threads() threads.
     void build_inverses();
 
+    /// Writes the header, instances and inverse index of the file to a binary
+    /// snapshot at path that can be read back by read_snapshot() without
+    /// parsing. The size, modification time and hashes of the SPF file at
+    /// source_path are recorded to detect when the snapshot is outdated.
+    /// Returns false on failure.
+    bool write_snapshot(const std::string& path, const std::string& source_path);
+
+    /// Reads a snapshot written by write_snapshot(). Returns nullptr when the
+    /// snapshot does not exist, was written by an incompatible version, or when
+    /// the file at source_path no longer matches the recorded size, modification
+    /// time and a hash over a sample of its blocks. With verify_contents the
+    /// entire file at source_path is hashed as well, which for large files takes
+    /// a considerable part of the time needed to parse them.
+    static IfcFile* read_snapshot(const std::string& path, const std::string& source_path, bool verify_contents = false);
+
+    /// Publishes the current state of the entity instances as a new version
+    /// and returns a view of it. Views of earlier versions are unaffected.
+    /// Only to be called by the thread modifying the file. The first commit
+    /// copies all instances, subsequent commits only the instances modified
+    /// since the previous one.
+    IfcFileView::ptr commit();
+
+    /// Returns a view of the most recently committed version, or nullptr if
+    /// there is none. May be called from any thread, also while the file is
+    /// modified or committed.
+    IfcFileView::ptr view() const;
+
+    /// Starts recording the instances that are added, modified and removed by
+    /// addEntity(), set_attribute_value() and removeEntity(), see change_journal.
+    /// Start the journal before modifying a file read from SPF to be able to
+    /// save it incrementally with IfcSpfWriter::write_incremental(). Starting
+    /// it does not make the journal complete when the file was already
+    /// modified, such as a file created in memory. Save the file and call
+    /// clear_journal() first in that case.
+    void start_journal() { journal_.start(); }
+
+    /// Stops recording changes and discards the journal
+    void stop_journal() { journal_.stop(); }
+
+    /// Discards the recorded changes, to be called after the file is saved,
+    /// so that the saved file becomes the base of subsequent incremental saves.
+    void clear_journal() { journal_.clear(); }
+
+    const change_journal& journal() const { return journal_; }
+
+    /// Returns the number of allocations and bytes served by the arena in
+    /// which the instances, attribute values and aggregates read from the file
+    /// are allocated, and the number and size of the blocks it reserved.
+    arena::statistics allocation_statistics() const { return arena_.stats(); }
+
+    /// Returns the number of string values interned when reading the file and
+    /// an estimate of the memory saved by doing so.
+    const string_pool::statistics& string_statistics() const { return strings_.stats(); }
+
+    /// Returns an estimate of the memory held by the file, broken down by
+    /// instance type, attribute value type and index. Takes time linear in
+    /// the number of instances.
+    file_memory_statistics memory_statistics() const;
+
     entity_by_guid_t& internal_guid_map() { return byguid_; };
 };
 
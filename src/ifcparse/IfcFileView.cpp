@@ -0,0 +1,214 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "IfcFileView.h"
+
+#include "IfcException.h"
+#include "IfcFile.h"
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <set>
+
+using namespace IfcParse;
+
+namespace {
+    bool global_id_of(const IfcParse::declaration* ifcroot_type, const IfcParse::declaration& decl, const IfcEntityInstanceData& data, std::string& global_id) {
+        if (ifcroot_type == nullptr || !decl.is(*ifcroot_type) || data.size() == 0) {
+            return false;
+        }
+        auto attr = data.get_attribute_value(0);
+        if (attr.isNull() || attr.type() != IfcUtil::Argument_STRING) {
+            return false;
+        }
+        global_id = (std::string) attr;
+        return true;
+    }
+}
+
+const IfcFileView::instance* IfcFileView::find_(unsigned id) const {
+    const entry* e = instances_.get(id);
+    return e != nullptr ? e->state.get() : nullptr;
+}
+
+const IfcFileView::instance* IfcFileView::instance_by_id(unsigned id) const {
+    const instance* inst = find_(id);
+    if (inst == nullptr) {
+        throw IfcException("Instance #" + boost::lexical_cast<std::string>(id) + " not found");
+    }
+    return inst;
+}
+
+const IfcFileView::instance* IfcFileView::instance_by_guid(const std::string& guid) const {
+    const unsigned* id = by_guid_.find(guid);
+    if (id == nullptr) {
+        throw IfcException("Instance with GlobalId '" + guid + "' not found");
+    }
+    return find_(*id);
+}
+
+const IfcFileView::instance* IfcFileView::resolve(const IfcUtil::IfcBaseClass* reference) const {
+    const unsigned* id = by_address_.find(reference);
+    return id != nullptr ? find_(*id) : nullptr;
+}
+
+void IfcFileView::collect_by_type_(const IfcParse::entity* ent, std::vector<const instance*>& instances) const {
+    auto it = by_type_.find(ent);
+    if (it != by_type_.end()) {
+        for (unsigned id : *it->second) {
+            instances.push_back(find_(id));
+        }
+    }
+    for (const auto* st : ent->subtypes()) {
+        collect_by_type_(st, instances);
+    }
+}
+
+std::vector<const IfcFileView::instance*> IfcFileView::instances_by_type(const IfcParse::declaration* type) const {
+    std::vector<const instance*> instances;
+    if (type != nullptr && type->as_entity() != nullptr) {
+        collect_by_type_(type->as_entity(), instances);
+    }
+    return instances;
+}
+
+std::vector<const IfcFileView::instance*> IfcFileView::instances_by_type(const std::string& type) const {
+    return instances_by_type(schema_->declaration_by_name(type));
+}
+
+std::vector<const IfcFileView::instance*> IfcFileView::instances_by_reference(unsigned id) const {
+    return getInverse(id, nullptr, -1);
+}
+
+std::vector<const IfcFileView::instance*> IfcFileView::getInverse(unsigned id, const IfcParse::declaration* type, int attribute_index) const {
+    std::vector<const instance*> instances;
+    const entry* e = instances_.get(id);
+    if (e == nullptr || !e->inverses) {
+        return instances;
+    }
+    for (const auto& ref : *e->inverses) {
+        if (attribute_index != -1 && ref.attribute != attribute_index) {
+            continue;
+        }
+        if (type != nullptr && !schema_->declarations()[ref.type]->is(*type)) {
+            continue;
+        }
+        instances.push_back(find_(ref.id));
+    }
+    return instances;
+}
+
+size_t IfcFileView::getTotalInverses(unsigned id) const {
+    const entry* e = instances_.get(id);
+    return (e != nullptr && e->inverses) ? e->inverses->size() : 0;
+}
+
+IfcFileView::ptr IfcFile::commit() {
+    materialize_all_();
+
+    const IfcFileView::ptr previous = view();
+    std::shared_ptr<IfcFileView> next(previous ? new IfcFileView(*previous) : new IfcFileView(schema_, ifcroot_type_));
+    next->version_ = previous ? previous->version_ + 1 : 1;
+
+    if (!previous) {
+        // Changes are only recorded once there is a version to compare to
+        for (const auto& p : byid_) {
+            changed_instances_.insert(p.first);
+            changed_inverses_.insert(p.first);
+        }
+        track_changes_ = true;
+    }
+
+    std::set<const IfcParse::declaration*> changed_types;
+    std::string global_id;
+
+    // In order of name, so that of instances with the same GlobalId the one
+    // added last is found, as in the file
+    std::vector<unsigned> changed(changed_instances_.begin(), changed_instances_.end());
+    std::sort(changed.begin(), changed.end());
+
+    for (unsigned id : changed) {
+        auto& e = next->instances_.at(id);
+        auto it = byid_.find(id);
+        IfcUtil::IfcBaseClass* inst = it == byid_.end() ? nullptr : it->second;
+
+        if (e.state) {
+            changed_types.insert(e.state->declaration_);
+            if (global_id_of(ifcroot_type_, *e.state->declaration_, e.state->data_, global_id)) {
+                next->by_guid_.erase(global_id, id);
+            }
+            next->by_address_.erase(e.state->address_, id);
+        }
+        if (inst != nullptr) {
+            changed_types.insert(&inst->declaration());
+            if (global_id_of(ifcroot_type_, inst->declaration(), inst->data(), global_id)) {
+                next->by_guid_.insert(global_id, id);
+            }
+            next->by_address_.insert(inst, id);
+        }
+
+        next->size_ += (inst != nullptr ? 1 : 0);
+        next->size_ -= (e.state ? 1 : 0);
+
+        e.state = inst != nullptr ? std::make_shared<const IfcFileView::instance>(inst, &inst->declaration(), id, inst->data()) : nullptr;
+        if (!e.state) {
+            e.inverses = nullptr;
+        }
+    }
+
+    for (unsigned id : changed_inverses_) {
+        if (byid_.find(id) == byid_.end()) {
+            continue;
+        }
+        auto refs = std::make_shared<std::vector<IfcFileView::inverse_reference>>();
+        byref_excl_.visit((int) id, [&refs](const inverse_attr_record& key, const int* begin, const int* end) {
+            for (auto it = begin; it != end; ++it) {
+                refs->push_back({std::get<INSTANCE_TYPE>(key), std::get<ATTRIBUTE_INDEX>(key), (unsigned) *it});
+            }
+        });
+        next->instances_.at(id).inverses = refs->empty() ? nullptr : refs;
+    }
+
+    for (const auto* ty : changed_types) {
+        auto it = bytype_excl_.find(ty);
+        if (it == bytype_excl_.end()) {
+            next->by_type_.erase(ty);
+        } else {
+            auto ids = std::make_shared<std::vector<unsigned>>();
+            ids->reserve(it->second->size());
+            for (auto* inst : *it->second) {
+                ids->push_back(inst->id());
+            }
+            next->by_type_[ty] = ids;
+        }
+    }
+
+    changed_instances_.clear();
+    changed_inverses_.clear();
+
+    std::lock_guard<std::mutex> lock(committed_mutex_);
+    committed_ = next;
+    return committed_;
+}
+
+IfcFileView::ptr IfcFile::view() const {
+    std::lock_guard<std::mutex> lock(committed_mutex_);
+    return committed_;
+}
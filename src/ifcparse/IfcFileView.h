@@ -0,0 +1,297 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef IFCFILEVIEW_H
+#define IFCFILEVIEW_H
+
+#include "ifc_parse_api.h"
+#include "IfcEntityInstanceData.h"
+#include "IfcSchema.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace IfcParse {
+
+class IfcFile;
+
+/// Array of values stored in fixed size chunks. Copies of the array share
+/// their chunks until these are modified, so that copying an array and
+/// modifying a few elements only copies the chunks holding these elements.
+/// Copies may be read concurrently, but only a single thread may copy and
+/// modify them.
+template <typename T, size_t ChunkSize = 256>
+class cow_array {
+    typedef std::array<T, ChunkSize> chunk;
+    std::vector<std::shared_ptr<chunk>> chunks_;
+
+  public:
+    /// Returns the element at i, or nullptr when no chunk holds it
+    const T* get(size_t i) const {
+        const size_t c = i / ChunkSize;
+        if (c >= chunks_.size() || !chunks_[c]) {
+            return nullptr;
+        }
+        return &(*chunks_[c])[i % ChunkSize];
+    }
+
+    /// Returns the element at i for modification, copying its chunk when it
+    /// is shared with other arrays
+    T& at(size_t i) {
+        const size_t c = i / ChunkSize;
+        if (c >= chunks_.size()) {
+            chunks_.resize(c + 1);
+        }
+        auto& ch = chunks_[c];
+        if (!ch) {
+            ch = std::make_shared<chunk>();
+        } else if (ch.use_count() > 1) {
+            // The count of a chunk can only be raised by the thread modifying
+            // the array, so it is never underestimated here
+            ch = std::make_shared<chunk>(*ch);
+        }
+        return (*ch)[i % ChunkSize];
+    }
+
+    size_t capacity() const {
+        return chunks_.size() * ChunkSize;
+    }
+};
+
+/// Hash map with buckets that are shared between copies of the map until
+/// they are modified, with the same threading constraints as cow_array. A key
+/// may map to multiple values, of which find() returns the one inserted last.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class cow_hash_map {
+    typedef std::vector<std::pair<K, V>> bucket;
+    std::vector<std::shared_ptr<bucket>> buckets_;
+    size_t size_ = 0;
+
+    size_t index_(const K& k) const {
+        return Hash()(k) & (buckets_.size() - 1);
+    }
+
+    bucket& mutable_bucket_(const K& k) {
+        auto& b = buckets_[index_(k)];
+        if (!b) {
+            b = std::make_shared<bucket>();
+        } else if (b.use_count() > 1) {
+            b = std::make_shared<bucket>(*b);
+        }
+        return *b;
+    }
+
+    void rehash_(size_t num_buckets) {
+        std::vector<std::shared_ptr<bucket>> old;
+        old.swap(buckets_);
+        buckets_.resize(num_buckets);
+        for (const auto& b : old) {
+            if (b) {
+                for (const auto& p : *b) {
+                    mutable_bucket_(p.first).push_back(p);
+                }
+            }
+        }
+    }
+
+    bool contains_(const K& k, const V& v) const {
+        const auto& b = buckets_[index_(k)];
+        return b && std::find(b->begin(), b->end(), std::make_pair(k, v)) != b->end();
+    }
+
+  public:
+    const V* find(const K& k) const {
+        if (buckets_.empty()) {
+            return nullptr;
+        }
+        const auto& b = buckets_[index_(k)];
+        if (b) {
+            for (auto it = b->rbegin(); it != b->rend(); ++it) {
+                if (it->first == k) {
+                    return &it->second;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /// Adds v to the values of k
+    void insert(const K& k, const V& v) {
+        if (size_ >= buckets_.size() * 2) {
+            size_t n = 64;
+            while (n < size_) {
+                n *= 2;
+            }
+            rehash_(n);
+        }
+        if (contains_(k, v)) {
+            return;
+        }
+        mutable_bucket_(k).emplace_back(k, v);
+        ++size_;
+    }
+
+    /// Removes v from the values of k
+    void erase(const K& k, const V& v) {
+        if (buckets_.empty() || !contains_(k, v)) {
+            return;
+        }
+        auto& b = mutable_bucket_(k);
+        b.erase(std::find(b.begin(), b.end(), std::make_pair(k, v)));
+        --size_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+};
+
+/// An immutable version of the entity instances in an IfcFile, published by
+/// IfcFile::commit(). A view is not affected by subsequent modifications of
+/// the file, so it can be read from any number of threads while a single
+/// thread modifies and commits the file.
+///
+/// Views of consecutive versions share the instances that have not been
+/// modified in between, so that committing a version only copies the
+/// modified instances, their inverses and the type lists they are part of.
+///
+/// Entity instance references in attribute values point to the instances in
+/// the file. They are only to be used to identify the instance, to be looked
+/// up in a view with resolve(), as the instance in the file may have been
+/// modified or removed since.
+///
+/// A view holds copies of the attribute values, which are not allocated in
+/// the arena of the file, so it remains valid after the file is destroyed.
+/// The references then point to destroyed instances, but can still be
+/// passed to resolve().
+class IFC_PARSE_API IfcFileView {
+  public:
+    typedef std::shared_ptr<const IfcFileView> ptr;
+
+    /// The state of an entity instance in a version
+    class IFC_PARSE_API instance {
+      private:
+        friend class IfcFile;
+
+        // The instance in the file, only used as a key in by_address_
+        const IfcUtil::IfcBaseClass* address_;
+        const IfcParse::declaration* declaration_;
+        unsigned id_;
+        IfcEntityInstanceData data_;
+
+      public:
+        instance(const IfcUtil::IfcBaseClass* address, const IfcParse::declaration* decl, unsigned id, const IfcEntityInstanceData& data)
+            : address_(address),
+              declaration_(decl),
+              id_(id),
+              data_(data) {}
+
+        const IfcParse::declaration& declaration() const { return *declaration_; }
+        unsigned id() const { return id_; }
+        const IfcEntityInstanceData& data() const { return data_; }
+        AttributeValue get_attribute_value(size_t index) const { return data_.get_attribute_value(index); }
+    };
+
+  private:
+    friend class IfcFile;
+
+    /// Entity type index, attribute index and name of a referencing instance
+    struct inverse_reference {
+        short type;
+        short attribute;
+        unsigned id;
+    };
+
+    struct entry {
+        std::shared_ptr<const instance> state;
+        std::shared_ptr<const std::vector<inverse_reference>> inverses;
+    };
+
+    const IfcParse::schema_definition* schema_;
+    const IfcParse::declaration* ifcroot_type_;
+    unsigned version_ = 0;
+    size_t size_ = 0;
+
+    cow_array<entry> instances_;
+    std::map<const IfcParse::declaration*, std::shared_ptr<const std::vector<unsigned>>> by_type_;
+    cow_hash_map<std::string, unsigned> by_guid_;
+    // Maps the instances in the file, referred to by attribute values, to
+    // their names in this version
+    cow_hash_map<const IfcUtil::IfcBaseClass*, unsigned> by_address_;
+
+    IfcFileView(const IfcParse::schema_definition* schema, const IfcParse::declaration* ifcroot_type)
+        : schema_(schema),
+          ifcroot_type_(ifcroot_type) {}
+
+    IfcFileView(const IfcFileView&) = default;
+
+    const instance* find_(unsigned id) const;
+    void collect_by_type_(const IfcParse::entity* ent, std::vector<const instance*>& instances) const;
+
+  public:
+    /// Version number, the first commit of a file is version 1
+    unsigned version() const { return version_; }
+
+    const IfcParse::schema_definition* schema() const { return schema_; }
+
+    /// Number of entity instances
+    size_t size() const { return size_; }
+
+    const instance* instance_by_id(unsigned id) const;
+    const instance* instance_by_guid(const std::string& guid) const;
+
+    /// Returns the state in this version of the entity instance referred to
+    /// by an attribute value of an instance in this version, or nullptr for
+    /// simple type instances
+    const instance* resolve(const IfcUtil::IfcBaseClass* reference) const;
+
+    std::vector<const instance*> instances_by_type(const IfcParse::declaration* type) const;
+    std::vector<const instance*> instances_by_type(const std::string& type) const;
+
+    /// Returns the instances referring to the instance
+    std::vector<const instance*> instances_by_reference(unsigned id) const;
+
+    /// Returns the instances of type, including subtypes, referring to the
+    /// instance by the attribute at attribute_index, or any attribute for -1
+    std::vector<const instance*> getInverse(unsigned id, const IfcParse::declaration* type, int attribute_index) const;
+
+    size_t getTotalInverses(unsigned id) const;
+
+    /// Calls fn(const instance&) for every instance in order of name
+    template <typename Fn>
+    void visit(Fn fn) const {
+        for (size_t i = 0; i < instances_.capacity(); ++i) {
+            const entry* e = instances_.get(i);
+            if (e != nullptr && e->state) {
+                fn(*e->state);
+            }
+        }
+    }
+};
+
+} // namespace IfcParse
+
+#endif
@@ -0,0 +1,128 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+// Estimates of the memory held by an IfcFile. The sizes of the containers are
+// computed from their capacity and element type. The overhead of the nodes
+// of node-based containers and of the system allocator is approximated.
+
+#include "IfcFile.h"
+#include "IfcSpfStream.h"
+
+#include <string>
+#include <vector>
+
+using namespace IfcParse;
+
+namespace {
+    // A tree node holds three pointers and a color besides the value
+    template <typename K, typename V, typename C, typename A>
+    size_t container_usage(const std::map<K, V, C, A>& m) {
+        return m.size() * (sizeof(typename std::map<K, V, C, A>::value_type) + 4 * sizeof(void*));
+    }
+
+    // A hashed node holds a pointer to the next node besides the value and
+    // every bucket holds a pointer
+    template <typename T>
+    size_t hashed_container_usage(const T& m) {
+        return m.size() * (sizeof(typename T::value_type) + sizeof(void*)) + m.bucket_count() * sizeof(void*);
+    }
+
+    template <typename T>
+    size_t container_usage(const std::vector<T>& v) {
+        return v.capacity() * sizeof(T);
+    }
+}
+
+size_t IfcParse::file_memory_statistics::total() const {
+    size_t n = inverse_index + guid_map + instance_maps + header + stream + strings + arena_unused + journal;
+    for (const auto& p : instances) {
+        n += p.second;
+    }
+    for (const auto& p : attributes) {
+        n += p.second;
+    }
+    return n;
+}
+
+file_memory_statistics IfcParse::IfcFile::memory_statistics() const {
+    file_memory_statistics stats;
+
+    auto add_instance = [&stats](const IfcUtil::IfcBaseClass* inst) {
+        const size_t object_size = inst->declaration().as_entity() != nullptr
+            ? sizeof(IfcUtil::IfcBaseEntity)
+            : sizeof(IfcUtil::IfcBaseType);
+        stats.instances[&inst->declaration()] += object_size + inst->data().memory_usage(stats.attributes);
+    };
+    for (const auto& p : byid_) {
+        add_instance(p.second);
+    }
+    for (const auto& p : byidentity_) {
+        if (p.second->declaration().as_entity() == nullptr) {
+            add_instance(p.second);
+        }
+    }
+
+    stats.inverse_index = byref_excl_.memory_usage();
+    stats.guid_map = byguid_.memory_usage();
+
+    stats.instance_maps = hashed_container_usage(byid_) +
+                          hashed_container_usage(byidentity_) +
+                          container_usage(bytype_excl_) +
+                          container_usage(entity_file_map_) +
+                          container_usage(unloaded_) +
+                          container_usage(unloaded_by_type_);
+    for (const auto& p : bytype_excl_) {
+        if (p.second) {
+            stats.instance_maps += sizeof(aggregate_of_instance) + p.second->size() * sizeof(IfcUtil::IfcBaseClass*);
+        }
+    }
+    for (const auto& p : unloaded_by_type_) {
+        stats.instance_maps += container_usage(p.second);
+    }
+
+    // The header entities are not part of the file, their attribute values
+    // are accounted for here rather than in attributes
+    std::map<IfcUtil::ArgumentType, size_t> header_attributes;
+    auto add_header_entity = [&stats, &header_attributes](const HeaderEntity& entity) {
+        stats.header += sizeof(HeaderEntity) + entity.data_.memory_usage(header_attributes);
+    };
+    try {
+        add_header_entity(_header.file_description());
+        add_header_entity(_header.file_name());
+        add_header_entity(_header.file_schema());
+    } catch (const IfcException&) {
+        // The header has not been read
+    }
+    for (const auto& p : header_attributes) {
+        stats.header += p.second;
+    }
+
+    if (owned_stream_) {
+        stats.stream += owned_stream_->memory_usage();
+    }
+    if (tokens != nullptr) {
+        stats.stream += sizeof(IfcSpfLexer);
+    }
+
+    stats.strings = strings_.stats().bytes;
+    stats.arena_unused = arena_.stats().bytes_reserved - arena_.stats().bytes;
+    stats.journal = journal_.memory_usage();
+
+    return stats;
+}
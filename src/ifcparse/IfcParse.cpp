@@ -27,6 +27,9 @@
 #include "IfcSchema.h"
 #include "IfcSIPrefix.h"
 #include "IfcSpfStream.h"
+#include "IfcSpfWriter.h"
+#include "spf_statement.h"
+#include "thread_utils.h"
 #include "utils.h"
 
 #include <algorithm>
@@ -34,17 +37,33 @@
 #include <boost/circular_buffer.hpp>
 #include <boost/variant.hpp>
 #include <boost/math/special_functions/fpclassify.hpp>
+#include <cctype>
+#include <charconv>
 #include <ctime>
 #include <set>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
 #include <iomanip>
+#include <thread>
 
 #ifdef USE_MMAP
 #include <boost/filesystem/path.hpp>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IFC_SPF_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(IFC_SPF_SSE2) && (((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))) || (defined(_MSC_VER) && defined(_M_X64)))
+#define IFC_SPF_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 #define PERMISSIVE_FLOAT
 
 using namespace IfcParse;
@@ -103,6 +122,23 @@ void init_locale() {
 
 #endif
 
+// ftell() returns a long, which is 32 bits on Windows, so the 64-bit variants
+// are used to obtain the size of files larger than 2GB.
+static size_t file_size(FILE* stream) {
+#if defined(_MSC_VER)
+    _fseeki64(stream, 0, SEEK_END);
+    const size_t size = (size_t)_ftelli64(stream);
+#elif defined(__MINGW64__) || defined(__MINGW32__)
+    fseeko64(stream, 0, SEEK_END);
+    const size_t size = (size_t)ftello64(stream);
+#else
+    fseeko(stream, 0, SEEK_END);
+    const size_t size = (size_t)ftello(stream);
+#endif
+    rewind(stream);
+    return size;
+}
+
 //
 // Opens the file and gets the filesize
 //
@@ -113,6 +149,7 @@ IfcSpfStream::IfcSpfStream(const std::string& path)
 #endif
     : stream_(0),
       buffer_(0),
+      owns_buffer_(true),
       valid(false),
       eof(false) {
 #ifdef _MSC_VER
@@ -152,7 +189,7 @@ IfcSpfStream::IfcSpfStream(const std::string& path)
         valid = true;
         buffer_ = mfs.data();
         ptr_ = 0;
-        len_ = mfs.size();
+        size = len_ = mfs.size();
     } else {
 #endif
         if (stream_ == NULL) {
@@ -160,11 +197,9 @@ IfcSpfStream::IfcSpfStream(const std::string& path)
         }
 
         valid = true;
-        fseek(stream_, 0, SEEK_END);
-        size = (unsigned int)ftell(stream_);
-        rewind(stream_);
+        size = file_size(stream_);
         char* buffer_rw = new char[size];
-        len_ = (unsigned int)fread(buffer_rw, 1, size, stream_);
+        len_ = fread(buffer_rw, 1, size, stream_);
         buffer_ = buffer_rw;
         eof = len_ == 0;
         ptr_ = 0;
@@ -175,22 +210,24 @@ IfcSpfStream::IfcSpfStream(const std::string& path)
 #endif
 }
 
-IfcSpfStream::IfcSpfStream(std::istream& stream, int length)
+IfcSpfStream::IfcSpfStream(std::istream& stream, size_t length)
     : stream_(0),
-      buffer_(0) {
+      buffer_(0),
+      owns_buffer_(true) {
     eof = false;
     size = length;
     char* buffer_rw = new char[size];
     stream.read(buffer_rw, size);
     buffer_ = buffer_rw;
-    valid = stream.gcount() == size;
+    valid = (size_t)stream.gcount() == size;
     ptr_ = 0;
     len_ = length;
 }
 
-IfcSpfStream::IfcSpfStream(void* data, int length)
+IfcSpfStream::IfcSpfStream(void* data, size_t length)
     : stream_(0),
-      buffer_(0) {
+      buffer_(0),
+      owns_buffer_(true) {
     eof = false;
     size = length;
     buffer_ = (char*)data;
@@ -199,11 +236,24 @@ IfcSpfStream::IfcSpfStream(void* data, int length)
     len_ = length;
 }
 
+IfcSpfStream::IfcSpfStream(const IfcSpfStream& other, size_t offset)
+    : stream_(0),
+      buffer_(other.buffer_),
+      ptr_(offset),
+      len_(other.len_),
+      owns_buffer_(false),
+      valid(other.valid),
+      eof(offset >= other.len_),
+      size(other.size) {}
+
 IfcSpfStream::~IfcSpfStream() {
     Close();
 }
 
 void IfcSpfStream::Close() {
+    if (!owns_buffer_) {
+        return;
+    }
 #ifdef USE_MMAP
     if (mfs.is_open()) {
         mfs.close();
@@ -216,10 +266,148 @@ void IfcSpfStream::Close() {
     }
 }
 
+namespace {
+    // Characters that end an unquoted token, or that require the
+    // lexer to process the token character by character.
+    inline bool is_token_boundary(char c) {
+        switch (c) {
+        case '(':
+        case ')':
+        case '=':
+        case ',':
+        case ';':
+        case '/':
+        case '\'':
+        case '\r':
+        case '\n':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    size_t find_token_boundary_scalar(const char* data, size_t offset, size_t length) {
+        while (offset < length && !is_token_boundary(data[offset])) {
+            ++offset;
+        }
+        return offset;
+    }
+
+#ifdef IFC_SPF_SSE2
+    inline unsigned count_trailing_zeros(unsigned mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (unsigned)index;
+#else
+        return (unsigned)__builtin_ctz(mask);
+#endif
+    }
+
+    size_t find_token_boundary_sse2(const char* data, size_t offset, size_t length) {
+        const __m128i c0 = _mm_set1_epi8('(');
+        const __m128i c1 = _mm_set1_epi8(')');
+        const __m128i c2 = _mm_set1_epi8('=');
+        const __m128i c3 = _mm_set1_epi8(',');
+        const __m128i c4 = _mm_set1_epi8(';');
+        const __m128i c5 = _mm_set1_epi8('/');
+        const __m128i c6 = _mm_set1_epi8('\'');
+        const __m128i c7 = _mm_set1_epi8('\r');
+        const __m128i c8 = _mm_set1_epi8('\n');
+        for (; offset + 16 <= length; offset += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+            __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, c0), _mm_cmpeq_epi8(v, c1));
+            m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, c2), _mm_cmpeq_epi8(v, c3)));
+            m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, c4), _mm_cmpeq_epi8(v, c5)));
+            m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, c6), _mm_cmpeq_epi8(v, c7)));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, c8));
+            const unsigned mask = (unsigned)_mm_movemask_epi8(m);
+            if (mask != 0) {
+                return offset + count_trailing_zeros(mask);
+            }
+        }
+        return find_token_boundary_scalar(data, offset, length);
+    }
+#endif
+
+#ifdef IFC_SPF_AVX2
+#ifndef _MSC_VER
+    __attribute__((target("avx2")))
+#endif
+    size_t find_token_boundary_avx2(const char* data, size_t offset, size_t length) {
+        const __m256i c0 = _mm256_set1_epi8('(');
+        const __m256i c1 = _mm256_set1_epi8(')');
+        const __m256i c2 = _mm256_set1_epi8('=');
+        const __m256i c3 = _mm256_set1_epi8(',');
+        const __m256i c4 = _mm256_set1_epi8(';');
+        const __m256i c5 = _mm256_set1_epi8('/');
+        const __m256i c6 = _mm256_set1_epi8('\'');
+        const __m256i c7 = _mm256_set1_epi8('\r');
+        const __m256i c8 = _mm256_set1_epi8('\n');
+        for (; offset + 32 <= length; offset += 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+            __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, c0), _mm256_cmpeq_epi8(v, c1));
+            m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, c2), _mm256_cmpeq_epi8(v, c3)));
+            m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, c4), _mm256_cmpeq_epi8(v, c5)));
+            m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, c6), _mm256_cmpeq_epi8(v, c7)));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, c8));
+            const unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+            if (mask != 0) {
+                return offset + count_trailing_zeros(mask);
+            }
+        }
+        return find_token_boundary_sse2(data, offset, length);
+    }
+
+    bool cpu_supports_avx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        // The OS needs to preserve the YMM registers (OSXSAVE and XCR0)
+        if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        // Required when called from a static initializer, which may run before
+        // the one in libgcc that initializes the CPU model data
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    typedef size_t (*find_token_boundary_fn)(const char*, size_t, size_t);
+
+    find_token_boundary_fn select_find_token_boundary() {
+#ifdef IFC_SPF_AVX2
+        if (cpu_supports_avx2()) {
+            return find_token_boundary_avx2;
+        }
+#endif
+#ifdef IFC_SPF_SSE2
+        return find_token_boundary_sse2;
+#else
+        return find_token_boundary_scalar;
+#endif
+    }
+
+    const find_token_boundary_fn find_token_boundary_impl = select_find_token_boundary();
+}
+
+size_t IfcSpfStream::find_token_boundary(size_t offset) const {
+    return find_token_boundary_impl(buffer_, offset, len_);
+}
+
 //
 // Seeks an arbitrary position in the file
 //
-void IfcSpfStream::Seek(unsigned int offset) {
+void IfcSpfStream::Seek(size_t offset) {
     ptr_ = offset;
     if (ptr_ >= len_) {
         throw IfcException("Reading outside of file limits");
@@ -237,14 +425,14 @@ char IfcSpfStream::Peek() {
 //
 // Returns the character at specified offset
 //
-char IfcSpfStream::Read(unsigned int offset) {
+char IfcSpfStream::Read(size_t offset) {
     return buffer_[offset];
 }
 
 //
 // Returns the cursor position
 //
-unsigned int IfcSpfStream::Tell() const {
+size_t IfcSpfStream::Tell() const {
     return ptr_;
 }
 
@@ -273,8 +461,8 @@ IfcSpfLexer::~IfcSpfLexer() {
     delete decoder_;
 }
 
-unsigned int IfcSpfLexer::skipWhitespace() const {
-    unsigned int index = 0;
+size_t IfcSpfLexer::skipWhitespace() const {
+    size_t index = 0;
     while (!stream->eof) {
         char character = stream->Peek();
         if ((character == ' ' || character == '\r' || character == '\n' || character == '\t')) {
@@ -287,7 +475,7 @@ unsigned int IfcSpfLexer::skipWhitespace() const {
     return index;
 }
 
-unsigned int IfcSpfLexer::skipComment() const {
+size_t IfcSpfLexer::skipComment() const {
     char character = stream->Peek();
     if (character != '/') {
         return 0;
@@ -298,7 +486,7 @@ unsigned int IfcSpfLexer::skipComment() const {
         stream->Seek(stream->Tell() - 1);
         return 0;
     }
-    unsigned int index = 2;
+    size_t index = 2;
     char intermediate = 0;
     while (!stream->eof) {
         character = stream->Peek();
@@ -327,7 +515,7 @@ Token IfcSpfLexer::Next() {
     if (stream->eof) {
         return NoneTokenPtr();
     }
-    unsigned int pos = stream->Tell();
+    size_t pos = stream->Tell();
 
     char character = stream->Peek();
 
@@ -343,6 +531,17 @@ Token IfcSpfLexer::Next() {
         return OperatorTokenPtr(this, pos, pos + 1);
     }
 
+    // Unquoted tokens without line breaks, such as numbers, keywords and
+    // instance names, are delimited without visiting every character.
+    const size_t boundary = stream->find_token_boundary(pos);
+    if (boundary > pos && !stream->is_eof_at(boundary)) {
+        character = stream->Read(boundary);
+        if (character != '\'' && character != '\r' && character != '\n') {
+            stream->Seek(boundary);
+            return GeneralTokenPtr(this, pos, boundary);
+        }
+    }
+
     int len = 0;
 
     while (!stream->eof) {
@@ -375,11 +574,11 @@ Token IfcSpfLexer::Next() {
     return t;
 }
 
-bool IfcSpfStream::is_eof_at(unsigned int local_ptr) const {
+bool IfcSpfStream::is_eof_at(size_t local_ptr) const {
     return local_ptr >= len_;
 }
 
-void IfcSpfStream::increment_at(unsigned int& local_ptr) {
+void IfcSpfStream::increment_at(size_t& local_ptr) {
     if (++local_ptr == len_) {
         return;
     }
@@ -389,7 +588,7 @@ void IfcSpfStream::increment_at(unsigned int& local_ptr) {
     }
 }
 
-char IfcSpfStream::peek_at(unsigned int local_ptr) {
+char IfcSpfStream::peek_at(size_t local_ptr) {
     return buffer_[local_ptr];
 }
 
@@ -397,7 +596,7 @@ char IfcSpfStream::peek_at(unsigned int local_ptr) {
 // Reads a std::string from the file at specified offset
 // Omits whitespace and comments
 //
-void IfcSpfLexer::TokenString(unsigned int offset, std::string& buffer) {
+void IfcSpfLexer::TokenString(size_t offset, std::string& buffer) {
     buffer.clear();
     while (!stream->is_eof_at(offset)) {
         char character = stream->peek_at(offset);
@@ -426,9 +625,9 @@ void IfcSpfLexer::TokenString(unsigned int offset, std::string& buffer) {
 }
 
 //Note: according to STEP standard, there may be newlines in tokens
-inline void RemoveTokenSeparators(IfcSpfStream* stream, unsigned start, unsigned end, std::string& oDestination) {
+inline void RemoveTokenSeparators(IfcSpfStream* stream, size_t start, size_t end, std::string& oDestination) {
     oDestination.clear();
-    for (unsigned i = start; i < end; i++) {
+    for (size_t i = start; i < end; i++) {
         char character = stream->Read(i);
         if (character == ' ' ||
             character == '\r' ||
@@ -440,10 +639,21 @@ inline void RemoveTokenSeparators(IfcSpfStream* stream, unsigned start, unsigned
     }
 }
 
+// std::from_chars() is locale-independent and does not need to handle
+// leading whitespace. It does not accept a leading plus sign though.
+static inline const char* skip_plus_sign(const char* pStart) {
+    if (pStart[0] == '+' && pStart[1] != '-' && pStart[1] != '+') {
+        return pStart + 1;
+    }
+    return pStart;
+}
+
 bool ParseInt(const char* pStart, int& val) {
-    char* pEnd;
-    long result = strtol(pStart, &pEnd, 10);
-    if (*pEnd != 0) {
+    pStart = skip_plus_sign(pStart);
+    const char* pEnd = pStart + strlen(pStart);
+    long result;
+    auto res = std::from_chars(pStart, pEnd, result);
+    if (res.ec != std::errc() || res.ptr != pEnd) {
         return false;
     }
     val = (int)result;
@@ -451,6 +661,25 @@ bool ParseInt(const char* pStart, int& val) {
 }
 
 bool ParseFloat(const char* pStart, double& val) {
+#ifdef __cpp_lib_to_chars
+    {
+        const char* pFirst = skip_plus_sign(pStart);
+        const char* pLast = pFirst + strlen(pFirst);
+        double result;
+        auto res = std::from_chars(pFirst, pLast, result);
+        if (res.ec == std::errc()) {
+            if (res.ptr != pLast) {
+                return false;
+            }
+            val = result;
+            return true;
+        }
+        // Values out of the range of double are handled by strtod() below
+        if (res.ec != std::errc::result_out_of_range) {
+            return false;
+        }
+    }
+#endif
     char* pEnd;
 #ifdef _MSC_VER
     double result = _strtod_l(pStart, &pEnd, locale);
@@ -483,14 +712,14 @@ bool ParseBool(const char* pStart, int& val) {
     return true;
 }
 
-Token IfcParse::OperatorTokenPtr(IfcSpfLexer* lexer, unsigned start, unsigned end) {
+Token IfcParse::OperatorTokenPtr(IfcSpfLexer* lexer, size_t start, size_t end) {
     char first = lexer->stream->Read(start);
     Token token(lexer, start, end, Token_OPERATOR);
     token.value_char = first;
     return token;
 }
 
-Token IfcParse::GeneralTokenPtr(IfcSpfLexer* lexer, unsigned start, unsigned end) {
+Token IfcParse::GeneralTokenPtr(IfcSpfLexer* lexer, size_t start, size_t end) {
     Token token(lexer, start, end, Token_NONE);
 
     //extract token into temp buffer (remove eol-s, no encoding changes)
@@ -686,7 +915,159 @@ std::string TokenFunc::toString(const Token& token) {
 // Aditionally, registers the ids (i.e. #[\d]+) in the inverse map
 //
 void IfcParse::IfcFile::load(unsigned entity_instance_name, const IfcParse::entity* entity, parse_context& context, int attribute_index) {
-    Token next = tokens->Next();
+    load_(tokens, byref_excl_, references_to_resolve, entity_instance_name, entity, context, attribute_index);
+    byref_excl_.build();
+}
+
+namespace {
+    // Resolves named types declared as another type, e.g. IfcLengthMeasure to REAL
+    const IfcParse::parameter_type* underlying_type(const IfcParse::parameter_type* pt) {
+        while (pt != nullptr && pt->as_named_type() != nullptr && pt->as_named_type()->declared_type()->as_type_declaration() != nullptr) {
+            pt = pt->as_named_type()->declared_type()->as_type_declaration()->declared_type();
+        }
+        return pt;
+    }
+
+    // Returns the simple type of the numbers in an aggregate of numbers or an
+    // aggregate of aggregates of numbers, or nullptr for other types
+    const IfcParse::simple_type* numeric_aggregate_element_type(const IfcParse::parameter_type* pt, bool& nested) {
+        const auto* aggr = underlying_type(pt) ? underlying_type(pt)->as_aggregation_type() : nullptr;
+        if (aggr == nullptr) {
+            return nullptr;
+        }
+        const auto* element = underlying_type(aggr->type_of_element());
+        nested = element->as_aggregation_type() != nullptr;
+        if (nested) {
+            element = underlying_type(element->as_aggregation_type()->type_of_element());
+        }
+        const auto* simple = element->as_simple_type();
+        if (simple == nullptr || (
+            simple->declared_type() != IfcParse::simple_type::integer_type &&
+            simple->declared_type() != IfcParse::simple_type::real_type &&
+            simple->declared_type() != IfcParse::simple_type::number_type))
+        {
+            return nullptr;
+        }
+        return simple;
+    }
+
+    // Reads a comma-separated list of numbers from data at offset, which is
+    // just past the opening parenthesis, up to and including the closing one.
+    template <typename T>
+    bool read_numbers(const char* data, size_t length, size_t& offset, std::vector<T>& values) {
+        using IfcParse::spf_statement::is_whitespace;
+        for (;;) {
+            while (offset < length && is_whitespace(data[offset])) {
+                ++offset;
+            }
+            if (offset == length) {
+                return false;
+            }
+            const char* first = data + offset;
+            if (*first == '+') {
+                ++first;
+            }
+            T value;
+            auto res = std::from_chars(first, data + length, value);
+            if (res.ec != std::errc()) {
+                return false;
+            }
+            values.push_back(value);
+            offset = res.ptr - data;
+            while (offset < length && is_whitespace(data[offset])) {
+                ++offset;
+            }
+            if (offset == length) {
+                return false;
+            }
+            const char c = data[offset++];
+            if (c == ')') {
+                return true;
+            }
+            if (c != ',') {
+                return false;
+            }
+        }
+    }
+
+    // Reads an aggregate of numbers, or an aggregate of aggregates of
+    // numbers, from data at offset, which is just past the opening
+    // parenthesis. Returns false when anything else is encountered, such as
+    // comments, omitted values, empty aggregates or numbers not representable
+    // as T, in which case the aggregate is to be read token by token.
+    template <typename T>
+    bool read_numeric_aggregate(const char* data, size_t length, size_t& offset, IfcParse::numeric_aggregate& aggregate, std::vector<T>& values) {
+        using IfcParse::spf_statement::is_whitespace;
+        if (!aggregate.nested) {
+            return read_numbers(data, length, offset, values);
+        }
+        aggregate.offsets.push_back(0);
+        for (;;) {
+            while (offset < length && is_whitespace(data[offset])) {
+                ++offset;
+            }
+            if (offset == length || data[offset] != '(') {
+                return false;
+            }
+            ++offset;
+            if (!read_numbers(data, length, offset, values)) {
+                return false;
+            }
+            aggregate.offsets.push_back(values.size());
+            while (offset < length && is_whitespace(data[offset])) {
+                ++offset;
+            }
+            if (offset == length) {
+                return false;
+            }
+            const char c = data[offset++];
+            if (c == ')') {
+                return true;
+            }
+            if (c != ',') {
+                return false;
+            }
+        }
+    }
+
+    // Numeric aggregates, such as point coordinates and the coordinates and
+    // indices of tessellated geometry, make up the bulk of many files. When
+    // the schema declares an attribute to be one, it is read directly from the
+    // stream into contiguous storage, rather than as one token and one
+    // nested parse context per number and inner aggregate.
+    bool read_numeric_aggregate(IfcSpfLexer* lexer, const IfcParse::entity* entity, int attribute_index, parse_context& context) {
+        const auto& attributes = entity->all_attributes();
+        if (attribute_index < 0 || (size_t) attribute_index >= attributes.size()) {
+            return false;
+        }
+        bool nested = false;
+        const auto* element_type = numeric_aggregate_element_type(attributes[attribute_index]->type_of_attribute(), nested);
+        if (element_type == nullptr) {
+            return false;
+        }
+
+        std::unique_ptr<numeric_aggregate> aggregate(new numeric_aggregate);
+        aggregate->integers = element_type->declared_type() == IfcParse::simple_type::integer_type;
+        aggregate->nested = nested;
+
+        const char* data = lexer->stream->data();
+        const size_t length = lexer->stream->length();
+        size_t offset = lexer->stream->Tell();
+        const bool read = aggregate->integers
+            ? read_numeric_aggregate(data, length, offset, *aggregate, aggregate->ints)
+            : read_numeric_aggregate(data, length, offset, *aggregate, aggregate->reals);
+        if (!read || offset >= length) {
+            return false;
+        }
+
+        lexer->stream->Seek(offset);
+        context.push(aggregate.release());
+        return true;
+    }
+}
+
+void IfcParse::IfcFile::load_(IfcSpfLexer* lexer, entities_by_ref_t& byref, unresolved_references& references, unsigned entity_instance_name, const IfcParse::entity* entity, parse_context& context, int attribute_index) {
+    Token next = lexer->Next();
 
     /*
     if (TokenFunc::isOperator(next, '(')) {
@@ -706,20 +1087,22 @@ void IfcParse::IfcFile::load(unsigned entity_instance_name, const IfcParse::enti
             break;
         } else if (TokenFunc::isOperator(next, '(')) {
             return_value++;
-            load(entity_instance_name, entity, context.push(), attribute_index == -1 ? (int) attribute_index_within_data : attribute_index);
+            if (attribute_index != -1 || entity == nullptr || !read_numeric_aggregate(lexer, entity, (int) attribute_index_within_data, context)) {
+                load_(lexer, byref, references, entity_instance_name, entity, context.push(), attribute_index == -1 ? (int) attribute_index_within_data : attribute_index);
+            }
         } else {
             return_value++;
             if (TokenFunc::isIdentifier(next) && entity) {
-                register_inverse(entity_instance_name, entity, next, attribute_index == -1 ? attribute_index_within_data : attribute_index);
+                byref.append({next.value_int, entity->index_in_schema(), attribute_index == -1 ? (int) attribute_index_within_data : attribute_index}, entity_instance_name);
             }
 
             if (TokenFunc::isKeyword(next)) {
                 try {
                     const auto* decl = schema_->declaration_by_name(TokenFunc::asStringRef(next));
                     parse_context ps;
-                    tokens->Next();
-                    load(0, nullptr, ps, -1);
-                    auto* simple_type_instance = schema_->instantiate(decl, ps.construct(-1, references_to_resolve, decl, boost::none));
+                    lexer->Next();
+                    load_(lexer, byref, references, 0, nullptr, ps, -1);
+                    auto* simple_type_instance = schema_->instantiate(decl, ps.construct(-1, references, decl, boost::none));
                     //@todo decide addEntity(((IfcUtil::IfcBaseClass*)*entity));
                     context.push(simple_type_instance);
                     simple_type_instance->file_ = this;
@@ -732,7 +1115,7 @@ void IfcParse::IfcFile::load(unsigned entity_instance_name, const IfcParse::enti
                 context.push(next);
             }
         }
-        next = tokens->Next();
+        next = lexer->Next();
     }
 }
 
@@ -752,7 +1135,7 @@ IfcEntityInstanceData IfcParse::read(unsigned int i, IfcFile* f) {
 }
 
 void IfcParse::IfcFile::try_read_semicolon() const {
-    unsigned int old_offset = tokens->stream->Tell();
+    size_t old_offset = tokens->stream->Tell();
     Token semilocon = tokens->Next();
     if (!TokenFunc::isOperator(semilocon, ';')) {
         tokens->stream->Seek(old_offset);
@@ -762,23 +1145,21 @@ void IfcParse::IfcFile::try_read_semicolon() const {
 void IfcParse::IfcFile::register_inverse(unsigned id_from, const IfcParse::entity* from_entity, Token t, int attribute_index) {
     // Assume a check on token type has already been performed
     const auto* e = from_entity;
-    byref_excl_[{t.value_int, e->index_in_schema(), attribute_index}].push_back(id_from);
+    byref_excl_.insert({t.value_int, e->index_in_schema(), attribute_index}, id_from);
+    inverses_changed_((unsigned) t.value_int);
 }
 
 void IfcParse::IfcFile::register_inverse(unsigned id_from, const IfcParse::entity* from_entity, IfcUtil::IfcBaseClass* inst, int attribute_index) {
     const auto* e = from_entity;
-    byref_excl_[{inst->id(), e->index_in_schema(), attribute_index}].push_back(id_from);
+    byref_excl_.insert({(int) inst->id(), e->index_in_schema(), attribute_index}, id_from);
+    inverses_changed_(inst->id());
 }
 
 void IfcParse::IfcFile::unregister_inverse(unsigned id_from, const IfcParse::entity* from_entity, IfcUtil::IfcBaseClass* inst, int attribute_index) {
-    std::vector<int>& ids = byref_excl_[{inst->id(), from_entity->index_in_schema(), attribute_index}];
-    std::vector<int>::iterator iter = std::find(ids.begin(), ids.end(), id_from);
-    if (iter == ids.end()) {
-        // @todo inverses also need to be populated when multiple instances are added to a new file.
-        // throw IfcParse::IfcException("Instance not found among inverses");
-    } else {
-        ids.erase(iter);
-    }
+    // @todo inverses also need to be populated when multiple instances are added to a new file.
+    // Hence, a missing inverse is silently ignored.
+    byref_excl_.erase({(int) inst->id(), from_entity->index_in_schema(), attribute_index}, id_from);
+    inverses_changed_(inst->id());
 }
 
 namespace {
@@ -802,26 +1183,30 @@ namespace {
         // The REAL token definition from the IFC SPF standard does not necessarily match
         // the output of the C++ ostream formatting operation.
         // REAL = [ SIGN ] DIGIT { DIGIT } "." { DIGIT } [ "E" [ SIGN ] DIGIT { DIGIT } ] .
-        static std::string format_double(const double& d) {
+        // Values are written with the least number of digits that reads back as the
+        // same value when std::to_chars() is available.
+        static void format_double(std::ostream& os, const double& d) {
+#ifdef __cpp_lib_to_chars
+            char buffer[32];
+            const char* const begin = buffer;
+            const char* const end = std::to_chars(buffer, buffer + sizeof(buffer), d).ptr;
+#else
             std::ostringstream oss;
             oss.imbue(std::locale::classic());
             oss << std::setprecision(std::numeric_limits<double>::digits10) << d;
             const std::string str = oss.str();
-            oss.str("");
-            std::string::size_type e = str.find('e');
-            if (e == std::string::npos) {
-                e = str.find('E');
-            }
-            const std::string mantissa = str.substr(0, e);
-            oss << mantissa;
-            if (mantissa.find('.') == std::string::npos) {
-                oss << ".";
+            const char* const begin = str.data();
+            const char* const end = begin + str.size();
+#endif
+            const char* const e = std::find_if(begin, end, [](char c) { return c == 'e' || c == 'E'; });
+            os.write(begin, e - begin);
+            if (std::find(begin, e, '.') == e) {
+                os.put('.');
             }
-            if (e != std::string::npos) {
-                oss << "E";
-                oss << str.substr(e + 1);
+            if (e != end) {
+                os.put('E');
+                os.write(e + 1, end - e - 1);
             }
-            return oss.str();
         }
 
         static std::string format_binary(const boost::dynamic_bitset<>& b) {
@@ -856,7 +1241,7 @@ namespace {
         void operator()(const int& i) { data_ << i; }
         void operator()(const bool& i) { data_ << (i ? ".T." : ".F."); }
         void operator()(const boost::logic::tribool& i) { data_ << (i ? ".T." : (boost::logic::indeterminate(i) ? ".U." : ".F.")); }
-        void operator()(const double& i) { data_ << format_double(i); }
+        void operator()(const double& i) { format_double(data_, i); }
         void operator()(const boost::dynamic_bitset<>& i) { data_ << format_binary(i); }
         void operator()(const std::string& i) {
             std::string s = i;
@@ -890,8 +1275,8 @@ namespace {
             }
             data_ << ")";
         }
-        void operator()(const std::vector<std::vector<int>>& i);
-        void operator()(const std::vector<std::vector<double>>& i);
+        void operator()(const flat_aggregate_of_aggregate<int>& i);
+        void operator()(const flat_aggregate_of_aggregate<double>& i);
         void operator()(const aggregate_of_aggregate_of_instance::ptr& i) {
             data_ << "(";
             for (aggregate_of_aggregate_of_instance::outer_it outer_it = i->begin(); outer_it != i->end(); ++outer_it) {
@@ -933,7 +1318,7 @@ namespace {
             if (it != i.begin()) {
                 data_ << ",";
             }
-            data_ << format_double(*it);
+            format_double(data_, *it);
         }
         data_ << ")";
     }
@@ -954,23 +1339,39 @@ namespace {
     void StringBuilderVisitor::operator()(const std::vector<double>& i) { serialize(i); }
     void StringBuilderVisitor::operator()(const std::vector<std::string>& i) { serialize(i); }
     void StringBuilderVisitor::operator()(const std::vector<boost::dynamic_bitset<>>& i) { serialize(i); }
-    void StringBuilderVisitor::operator()(const std::vector<std::vector<int>>& i) {
+    void StringBuilderVisitor::operator()(const flat_aggregate_of_aggregate<int>& i) {
         data_ << "(";
-        for (std::vector<std::vector<int>>::const_iterator it = i.begin(); it != i.end(); ++it) {
-            if (it != i.begin()) {
+        for (size_t j = 0; j < i.size(); ++j) {
+            if (j != 0) {
                 data_ << ",";
             }
-            serialize(*it);
+            data_ << "(";
+            auto inner = i[j];
+            for (const int* it = inner.begin(); it != inner.end(); ++it) {
+                if (it != inner.begin()) {
+                    data_ << ",";
+                }
+                data_ << *it;
+            }
+            data_ << ")";
         }
         data_ << ")";
     }
-    void StringBuilderVisitor::operator()(const std::vector<std::vector<double>>& i) {
+    void StringBuilderVisitor::operator()(const flat_aggregate_of_aggregate<double>& i) {
         data_ << "(";
-        for (std::vector<std::vector<double>>::const_iterator it = i.begin(); it != i.end(); ++it) {
-            if (it != i.begin()) {
+        for (size_t j = 0; j < i.size(); ++j) {
+            if (j != 0) {
                 data_ << ",";
             }
-            serialize(*it);
+            data_ << "(";
+            auto inner = i[j];
+            for (const double* it = inner.begin(); it != inner.end(); ++it) {
+                if (it != inner.begin()) {
+                    data_ << ",";
+                }
+                format_double(data_, *it);
+            }
+            data_ << ")";
         }
         data_ << ")";
     }
@@ -981,7 +1382,11 @@ namespace {
 // Note that this initializes the entity if it is not initialized
 //
 void IfcEntityInstanceData::toString(std::ostream& ss, bool upper, const entity* decl) const {
-    ss.imbue(std::locale::classic());
+    // Imbuing is comparatively expensive, e.g. for every instance written by
+    // IfcSpfWriter, which already uses the classic locale
+    if (ss.getloc() != std::locale::classic()) {
+        ss.imbue(std::locale::classic());
+    }
 
     ss << "(";
 
@@ -1130,15 +1535,15 @@ template <typename T>
 void IfcUtil::IfcBaseClass::set_attribute_value(size_t i, const T& t) {
     auto current_attribute = data_.get_attribute_value(i);
     if (file_ != nullptr) {
+        if (declaration().as_entity() != nullptr) {
+            file_->journal_.record_modified(this);
+        }
 
         // Deregister old attribute guid in file guid map.
         if (i == 0 && (file_->ifcroot_type() != nullptr) && this->declaration().is(*file_->ifcroot_type())) {
             try {
                 auto guid = (std::string) current_attribute;
-                auto it = file_->internal_guid_map().find(guid);
-                if (it != file_->internal_guid_map().end() && it->second == this) {
-                    file_->internal_guid_map().erase(it);
-                }
+                file_->internal_guid_map().erase(guid, this);
             } catch (IfcParse::IfcException& e) {
                 Logger::Error(e);
             }
@@ -1155,6 +1560,8 @@ void IfcUtil::IfcBaseClass::set_attribute_value(size_t i, const T& t) {
         } else {
             data_.storage_.set(i, Blank{});
         }
+    } else if constexpr (std::is_same_v<T, std::vector<std::vector<int>>> || std::is_same_v<T, std::vector<std::vector<double>>>) {
+        data_.storage_.set(i, flat_aggregate_of_aggregate<typename T::value_type::value_type>(t));
     } else {
         data_.storage_.set(i, t);
     }
@@ -1164,16 +1571,16 @@ void IfcUtil::IfcBaseClass::set_attribute_value(size_t i, const T& t) {
         // Register inverse indices in file
         register_inverse_visitor visitor(*file_, this);
         apply_individual_instance_visitor(new_attribute, (int) i).apply(visitor);
+
+        file_->instance_changed_(id());
     
         // Register new attribute guid in guid map
         if (i == 0 && (file_->ifcroot_type() != nullptr) && this->declaration().is(*file_->ifcroot_type())) {
             try {
                 auto guid = (std::string) new_attribute;
-                auto it = file_->internal_guid_map().find(guid);
-                if (it != file_->internal_guid_map().end()) {
+                if (file_->internal_guid_map().insert(guid, file_->instance_by_id(this->id())) != nullptr) {
                     Logger::Warning("Duplicate guid " + guid);
                 }
-                file_->internal_guid_map()[guid] = file_->instance_by_id(this->id());
             } catch (IfcParse::IfcException& e) {
                 Logger::Error(e);
             }
@@ -1191,24 +1598,25 @@ void IfcUtil::IfcBaseClass::set_attribute_value(const std::string& s, const T& t
 // Creates the maps
 //
 #ifdef USE_MMAP
-IfcFile::IfcFile(const std::string& fn, bool mmap) {
-    initialize_(new IfcSpfStream(fn, mmap));
+IfcFile::IfcFile(const std::string& fn, bool mmap)
+    : owned_stream_(new IfcSpfStream(fn, mmap)) {
+    initialize_(owned_stream_.get());
 }
 #else
-IfcFile::IfcFile(const std::string& path) {
-    IfcSpfStream s(path);
-    initialize_(&s);
+IfcFile::IfcFile(const std::string& path)
+    : owned_stream_(new IfcSpfStream(path)) {
+    initialize_(owned_stream_.get());
 }
 #endif
 
-IfcFile::IfcFile(std::istream& stream, int length) {
-    IfcSpfStream s(stream, length);
-    initialize_(&s);
+IfcFile::IfcFile(std::istream& stream, size_t length)
+    : owned_stream_(new IfcSpfStream(stream, length)) {
+    initialize_(owned_stream_.get());
 }
 
-IfcFile::IfcFile(void* data, int length) {
-    IfcSpfStream s(data, length);
-    initialize_(&s);
+IfcFile::IfcFile(void* data, size_t length)
+    : owned_stream_(new IfcSpfStream(data, length)) {
+    initialize_(owned_stream_.get());
 }
 
 IfcFile::IfcFile(IfcParse::IfcSpfStream* s) {
@@ -1273,22 +1681,127 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
 
     ifcroot_type_ = schema_->declaration_by_name("IfcRoot");
 
+    Logger::Status("Scanning file...");
+
+    if (lazy_load_) {
+        // The lexer and stream are retained to parse instances on demand
+        scan_data_section_();
+        Logger::Status("\rDone scanning file   ");
+        return;
+    }
+
+    arena::scope scope(arena_);
+    string_pool::scope strings_scope(intern_strings_ ? &strings_ : nullptr);
+
+    const unsigned num_threads = parse_threads_ == 0 ? std::thread::hardware_concurrency() : parse_threads_;
+
+    if (num_threads <= 1 || !read_data_section_parallel_(num_threads)) {
+        data_section_chunk chunk;
+        chunk.begin = stream->Tell();
+        read_data_section_(tokens, chunk, true);
+        merge_data_section_(chunk);
+    }
+
+    Logger::Status("\rDone scanning file   ");
+
+    byref_excl_.build(num_threads);
+
+    delete tokens;
+    tokens = nullptr;
+
+    resolve_references_(references_to_resolve);
+
+    Logger::Status("Done resolving references");
+
+    if (intern_strings_) {
+        const auto& st = strings_.stats();
+        Logger::Notice("Interned " + std::to_string(st.references) + " string values as " + std::to_string(st.strings) + " distinct strings, saving approximately " + std::to_string(st.bytes_saved / 1024) + " KiB");
+    }
+
+    if (stream == owned_stream_.get()) {
+        owned_stream_.reset();
+        stream = nullptr;
+    }
+}
+
+void IfcFile::resolve_references_(unresolved_references& references) {
+    for (const auto& p : references) {
+        const auto& ref = p.first.name_;
+        const auto& refattr = p.first.index_;
+        if (auto* v = boost::get<reference_or_simple_type>(&p.second)) {
+            if (auto* name = boost::get<int>(v)) {
+                entity_by_id_t::const_iterator it = byid_.find(*name);
+                if (it == byid_.end()) {
+                    Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
+                } else {
+                    byid_[p.first.name_]->data().storage_.set(p.first.index_, it->second);
+                }
+            } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(v)) {
+                byid_[p.first.name_]->data().storage_.set(p.first.index_, *inst);
+            }
+        } else if (auto* v = boost::get<std::vector<reference_or_simple_type>>(&p.second)) {
+            aggregate_of_instance::ptr instances = make_shared_in_arena<aggregate_of_instance>();
+            instances->reserve(v->size());
+            for (const auto& vi : *v) {
+                if (auto* name = boost::get<int>(&vi)) {
+                    entity_by_id_t::const_iterator it = byid_.find(*name);
+                    if (it == byid_.end()) {
+                        Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
+                    } else {
+                        instances->push(it->second);
+                    }
+                } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&vi)) {
+                    instances->push(*inst);
+                }
+            }
+            byid_[p.first.name_]->data().storage_.set(p.first.index_, instances);
+        } else if (auto* v = boost::get<std::vector<std::vector<reference_or_simple_type>>>(&p.second)) {
+            aggregate_of_aggregate_of_instance::ptr instances = make_shared_in_arena<aggregate_of_aggregate_of_instance>();
+            for (const auto& vi : *v) {
+                std::vector<IfcUtil::IfcBaseClass*> inner;
+                for (const auto& vii : vi) {
+                    if (auto* name = boost::get<int>(&vii)) {
+                        entity_by_id_t::const_iterator it = byid_.find(*name);
+                        if (it == byid_.end()) {
+                            Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
+                        } else {
+                            inner.push_back(it->second);
+                        }
+                    } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&vii)) {
+                        inner.push_back(*inst);
+                    }
+                }
+                instances->push(inner);
+            }
+            byid_[p.first.name_]->data().storage_.set(p.first.index_, instances);
+        }
+    }
+
+    references.clear();
+}
+
+void IfcFile::read_data_section_(IfcSpfLexer* lexer, data_section_chunk& chunk, bool report_progress) {
     boost::circular_buffer<Token> token_stream(3, Token());
 
     IfcUtil::IfcBaseClass* instance = nullptr;
 
     unsigned current_id = 0;
     int progress = 0;
-    Logger::Status("Scanning file...");
 
     int paren_stack_depth = 0;
     int attribute_index = -1;
 
-    while (!stream->eof) {
+    while (!lexer->stream->eof) {
         if (token_stream[0].type == IfcParse::Token_IDENTIFIER &&
             token_stream[1].type == IfcParse::Token_OPERATOR &&
             token_stream[1].value_char == '=' &&
             token_stream[2].type == IfcParse::Token_KEYWORD) {
+            if (token_stream[0].startPos >= chunk.end) {
+                // This instance is read as part of the subsequent chunk
+                chunk.next = token_stream[0].startPos;
+                break;
+            }
+
             attribute_index = 0;
 
             current_id = (unsigned)TokenFunc::asIdentifier(token_stream[0]);
@@ -1306,56 +1819,29 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
             }
 
             parse_context ps;
-            tokens->Next();
-            load(current_id, entity_type->as_entity(), ps, -1);
-            instance = schema_->instantiate(entity_type, ps.construct(current_id, references_to_resolve, entity_type, boost::none));
+            lexer->Next();
+            load_(lexer, chunk.byref, chunk.references_to_resolve, current_id, entity_type->as_entity(), ps, -1);
+            instance = schema_->instantiate(entity_type, ps.construct(current_id, chunk.references_to_resolve, entity_type, boost::none));
             instance->file_ = this;
             instance->id_ = current_id;
 
             /// @todo Printing to stdout in a library class feels weird. Maybe move the progress prints to the client code?
             // Update the status after every 1000 instances parsed
-            if (((++progress) % 1000) == 0) {
+            if (report_progress && ((++progress) % 1000) == 0) {
                 std::stringstream ss;
                 ss << "\r#" << current_id;
                 Logger::Status(ss.str(), false);
             }
 
             if (instance->declaration().is(*ifcroot_type_)) {
-                try {
-                    const std::string guid = instance->data().get_attribute_value(0);
-                    if (byguid_.find(guid) != byguid_.end()) {
-                        std::stringstream ss;
-                        ss << "Instance encountered with non-unique GlobalId " << guid;
-                        Logger::Message(Logger::LOG_WARNING, ss.str());
-                    }
-                    byguid_[guid] = instance;
-                } catch (const IfcException& ex) {
-                    Logger::Message(Logger::LOG_ERROR, ex.what());
-                }
                 // this has consumed the instance tokens, set stack depth to 0
                 paren_stack_depth = 0;
                 attribute_index = -1;
             }
 
-            const IfcParse::declaration* ty = &instance->declaration();
-
-            {
-                if (bytype_excl_.find(ty) == bytype_excl_.end()) {
-                    bytype_excl_[ty].reset(new aggregate_of_instance());
-                }
-                bytype_excl_[ty]->push(instance);
-            }
-
-            if (byid_.find(current_id) != byid_.end()) {
-                std::stringstream ss;
-                ss << "Overwriting instance with name #" << current_id;
-                Logger::Message(Logger::LOG_WARNING, ss.str());
-            }
-            byid_[current_id] = instance;
-
-            MaxId = (std::max)(MaxId, current_id);
+            chunk.instances.push_back(instance);
         } else if (token_stream[0].type == IfcParse::Token_IDENTIFIER && (instance != nullptr)) {
-            register_inverse(current_id, instance->declaration().as_entity(), token_stream[0], attribute_index);
+            chunk.byref.append({token_stream[0].value_int, instance->declaration().index_in_schema(), attribute_index}, current_id);
         } else if (token_stream[0].type == IfcParse::Token_OPERATOR && token_stream[0].value_char == '(') {
             paren_stack_depth++;
         } else if (token_stream[0].type == IfcParse::Token_OPERATOR && token_stream[0].value_char == ')') {
@@ -1370,7 +1856,7 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
     advance:
         Token next_token;
         try {
-            next_token = tokens->Next();
+            next_token = lexer->Next();
         } catch (const IfcException& e) {
             Logger::Message(Logger::LOG_ERROR, std::string(e.what()) + ". Parsing terminated");
         } catch (...) {
@@ -1378,72 +1864,388 @@ void IfcFile::initialize_(IfcParse::IfcSpfStream* s) {
         }
 
         if (next_token.type == Token_NONE) {
-            good_ = file_open_status::INVALID_SYNTAX;
+            chunk.syntax_error = true;
             break;
         }
 
         token_stream.push_back(next_token);
     }
+}
 
-    Logger::Status("\rDone scanning file   ");
+namespace {
+    // Minimal amount of bytes in the data section read by a single thread
+    const size_t minimal_chunk_size = 1 << 20;
 
-    delete tokens;
+    bool is_whitespace(char c) {
+        return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+    }
 
-    for (const auto& p : references_to_resolve) {
-        const auto& ref = p.first.name_;
-        const auto& refattr = p.first.index_;
-        if (auto* v = boost::get<reference_or_simple_type>(&p.second)) {
-            if (auto* name = boost::get<int>(v)) {
-                entity_by_id_t::const_iterator it = byid_.find(*name);
-                if (it == byid_.end()) {
-                    Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
-                } else {
-                    byid_[p.first.name_]->data().storage_.set(p.first.index_, it->second);
-                }
-            } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(v)) {
-                byid_[p.first.name_]->data().storage_.set(p.first.index_, *inst);
+    // Returns the offset of the first entity instance name at or after offset that follows
+    // a semicolon, i.e `;` `#123` `=`, or std::numeric_limits<size_t>::max() if none found.
+    // This is a heuristic as the pattern may also occur within a string literal. Such false
+    // positives are detected when merging, in which case the file is read sequentially.
+    size_t find_instance_boundary(IfcSpfStream* stream, size_t offset) {
+        while (!stream->is_eof_at(offset)) {
+            if (stream->Read(offset++) != ';') {
+                continue;
             }
-        } else if (auto* v = boost::get<std::vector<reference_or_simple_type>>(&p.second)) {
-            aggregate_of_instance::ptr instances(new aggregate_of_instance);
-            instances->reserve(v->size());
-            for (const auto& vi : *v) {
-                if (auto* name = boost::get<int>(&vi)) {
-                    entity_by_id_t::const_iterator it = byid_.find(*name);
-                    if (it == byid_.end()) {
-                        Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
-                    } else {
-                        instances->push(it->second);
-                    }
-                } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&vi)) {
-                    instances->push(*inst);
-                }
+            size_t p = offset;
+            while (!stream->is_eof_at(p) && is_whitespace(stream->Read(p))) {
+                ++p;
             }
-            byid_[p.first.name_]->data().storage_.set(p.first.index_, instances);
-        } else if (auto* v = boost::get<std::vector<std::vector<reference_or_simple_type>>>(&p.second)) {
-            aggregate_of_aggregate_of_instance::ptr instances(new aggregate_of_aggregate_of_instance);
-            for (const auto& vi : *v) {
-                std::vector<IfcUtil::IfcBaseClass*> inner;
-                for (const auto& vii : vi) {
-                    if (auto* name = boost::get<int>(&vii)) {
-                        entity_by_id_t::const_iterator it = byid_.find(*name);
-                        if (it == byid_.end()) {
-                            Logger::Error("Instance reference #" + std::to_string(*name) + " used by instance #" + std::to_string(ref) + " at attribute index " + std::to_string(refattr) + " not found");
-                        } else {
-                            inner.push_back(it->second);
-                        }
-                    } else if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&vii)) {
-                        inner.push_back(*inst);
+            if (stream->is_eof_at(p) || stream->Read(p) != '#') {
+                continue;
+            }
+            const size_t name_start = p++;
+            size_t num_digits = 0;
+            while (!stream->is_eof_at(p) && std::isdigit(static_cast<unsigned char>(stream->Read(p)))) {
+                ++p;
+                ++num_digits;
+            }
+            while (!stream->is_eof_at(p) && is_whitespace(stream->Read(p))) {
+                ++p;
+            }
+            if (num_digits > 0 && !stream->is_eof_at(p) && stream->Read(p) == '=') {
+                return name_start;
+            }
+        }
+        return std::numeric_limits<size_t>::max();
+    }
+}
+
+bool IfcFile::read_data_section_parallel_(unsigned num_threads) {
+    const size_t begin = stream->Tell();
+    const size_t length = stream->size;
+    if (length <= begin) {
+        return false;
+    }
+
+    const size_t num_chunks = (std::min)((size_t)num_threads, (length - begin) / minimal_chunk_size);
+
+    std::vector<size_t> boundaries = {begin};
+    for (size_t i = 1; i < num_chunks; ++i) {
+        const size_t b = find_instance_boundary(stream, begin + (length - begin) * i / num_chunks);
+        if (b != std::numeric_limits<size_t>::max() && b > boundaries.back()) {
+            boundaries.push_back(b);
+        }
+    }
+
+    if (boundaries.size() < 2) {
+        return false;
+    }
+
+    std::vector<data_section_chunk> chunks(boundaries.size());
+    std::vector<std::exception_ptr> errors(chunks.size());
+    std::vector<std::thread> threads;
+    threads.reserve(chunks.size());
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        chunks[i].begin = boundaries[i];
+        if (i + 1 < boundaries.size()) {
+            chunks[i].end = boundaries[i + 1];
+        }
+        threads.emplace_back([this, i, &chunks, &errors]() {
+            try {
+                arena::scope scope(chunks[i].storage);
+                string_pool::scope strings_scope(intern_strings_ ? &chunks[i].strings : nullptr);
+                IfcSpfStream view(*stream, chunks[i].begin);
+                IfcSpfLexer lexer(&view, this);
+                read_data_section_(&lexer, chunks[i], false);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    bool consistent = std::none_of(errors.begin(), errors.end(), [](const std::exception_ptr& e) { return !!e; });
+    for (size_t i = 0; consistent && i + 1 < chunks.size(); ++i) {
+        consistent = !chunks[i].syntax_error && chunks[i].next == chunks[i + 1].begin;
+    }
+
+    if (!consistent) {
+        Logger::Notice("Chunk boundaries could not be established, reading file sequentially");
+        for (auto& chunk : chunks) {
+            for (auto* inst : chunk.instances) {
+                delete inst;
+            }
+        }
+        return false;
+    }
+
+    for (auto& chunk : chunks) {
+        merge_data_section_(chunk);
+    }
+
+    return true;
+}
+
+void IfcFile::merge_data_section_(data_section_chunk& chunk) {
+    for (auto* instance : chunk.instances) {
+        register_parsed_instance_(instance);
+    }
+
+    byref_excl_.append(chunk.byref);
+
+    arena_.splice(chunk.storage);
+    strings_.splice(chunk.strings);
+
+    references_to_resolve.splice(references_to_resolve.end(), chunk.references_to_resolve);
+
+    if (chunk.syntax_error) {
+        good_ = file_open_status::INVALID_SYNTAX;
+    }
+}
+
+void IfcFile::register_parsed_instance_(IfcUtil::IfcBaseClass* instance) {
+    const unsigned current_id = instance->id();
+
+    if (instance->declaration().is(*ifcroot_type_)) {
+        try {
+            const std::string guid = instance->data().get_attribute_value(0);
+            if (byguid_.insert(guid, instance) != nullptr) {
+                std::stringstream ss;
+                ss << "Instance encountered with non-unique GlobalId " << guid;
+                Logger::Message(Logger::LOG_WARNING, ss.str());
+            }
+        } catch (const IfcException& ex) {
+            Logger::Message(Logger::LOG_ERROR, ex.what());
+        }
+    }
+
+    const IfcParse::declaration* ty = &instance->declaration();
+
+    {
+        if (bytype_excl_.find(ty) == bytype_excl_.end()) {
+            bytype_excl_[ty].reset(new aggregate_of_instance());
+        }
+        bytype_excl_[ty]->push(instance);
+    }
+
+    if (byid_.find(current_id) != byid_.end()) {
+        std::stringstream ss;
+        ss << "Overwriting instance with name #" << current_id;
+        Logger::Message(Logger::LOG_WARNING, ss.str());
+    }
+    byid_[current_id] = instance;
+
+    MaxId = (std::max)(MaxId, current_id);
+}
+
+namespace {
+    // Advances offset past whitespace and comments
+    void skip_whitespace_and_comments(IfcSpfStream* stream, size_t& offset) {
+        while (!stream->is_eof_at(offset)) {
+            const char c = stream->peek_at(offset);
+            if (is_whitespace(c)) {
+                stream->increment_at(offset);
+            } else if (c == '/' && !stream->is_eof_at(offset + 1) && stream->peek_at(offset + 1) == '*') {
+                stream->increment_at(offset);
+                stream->increment_at(offset);
+                char previous = 0;
+                while (!stream->is_eof_at(offset)) {
+                    const char current = stream->peek_at(offset);
+                    stream->increment_at(offset);
+                    if (previous == '*' && current == '/') {
+                        break;
                     }
+                    previous = current;
                 }
-                instances->push(inner);
+            } else {
+                break;
             }
-            byid_[p.first.name_]->data().storage_.set(p.first.index_, instances);
         }
     }
 
-    Logger::Status("Done resolving references");
+    // Advances offset past the next semicolon that is not part of a string or comment
+    void skip_statement(IfcSpfStream* stream, size_t& offset) {
+        bool in_string = false;
+        while (!stream->is_eof_at(offset)) {
+            const char c = stream->peek_at(offset);
+            if (!in_string && c == '/') {
+                const size_t previous = offset;
+                skip_whitespace_and_comments(stream, offset);
+                if (offset != previous) {
+                    continue;
+                }
+            }
+            stream->increment_at(offset);
+            if (c == '\'') {
+                // A quote within a string is escaped by doubling, which toggles the state twice
+                in_string = !in_string;
+            } else if (!in_string && c == ';') {
+                break;
+            }
+        }
+    }
+}
+
+void IfcFile::scan_data_section_() {
+    size_t offset = stream->Tell();
+    std::string keyword;
+
+    while (true) {
+        skip_whitespace_and_comments(stream, offset);
+        if (stream->is_eof_at(offset)) {
+            break;
+        }
+        if (stream->peek_at(offset) != '#') {
+            // Section delimiters and other non-instance statements
+            skip_statement(stream, offset);
+            continue;
+        }
+
+        const size_t instance_offset = offset;
+        stream->increment_at(offset);
+        unsigned name = 0;
+        size_t num_digits = 0;
+        while (!stream->is_eof_at(offset) && std::isdigit(static_cast<unsigned char>(stream->peek_at(offset)))) {
+            name = name * 10 + (unsigned)(stream->peek_at(offset) - '0');
+            ++num_digits;
+            stream->increment_at(offset);
+        }
+        skip_whitespace_and_comments(stream, offset);
+        if (num_digits == 0 || stream->is_eof_at(offset) || stream->peek_at(offset) != '=') {
+            Logger::Message(Logger::LOG_ERROR, "Unexpected token at offset " + std::to_string(instance_offset));
+            skip_statement(stream, offset);
+            continue;
+        }
+        stream->increment_at(offset);
+        skip_whitespace_and_comments(stream, offset);
 
-    references_to_resolve.clear();
+        const size_t keyword_offset = offset;
+        keyword.clear();
+        while (!stream->is_eof_at(offset)) {
+            const char c = stream->peek_at(offset);
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+                break;
+            }
+            keyword.push_back(c);
+            stream->increment_at(offset);
+        }
+
+        skip_statement(stream, offset);
+
+        if (keyword.empty()) {
+            // Complex entity instances are not supported, as with regular parsing
+            continue;
+        }
+
+        const IfcParse::declaration* decl;
+        try {
+            decl = schema_->declaration_by_name(keyword);
+        } catch (const IfcException& ex) {
+            Logger::Message(Logger::LOG_ERROR, std::string(ex.what()) + " at offset " + std::to_string(keyword_offset));
+            continue;
+        }
+
+        if (decl->as_entity() == nullptr) {
+            Logger::Message(Logger::LOG_ERROR, "Non entity type " + decl->name() + " at offset " + std::to_string(keyword_offset));
+            continue;
+        }
+
+        unloaded_.push_back({name, keyword_offset, decl});
+        unloaded_by_type_[decl].push_back(name);
+        MaxId = (std::max)(MaxId, name);
+    }
+
+    std::stable_sort(unloaded_.begin(), unloaded_.end(), [](const unloaded_instance& a, const unloaded_instance& b) {
+        return a.name < b.name;
+    });
+}
+
+const IfcFile::unloaded_instance* IfcFile::find_unloaded_(unsigned name) const {
+    // In case of duplicate names the last occurrence in the file is used, as with regular parsing
+    auto it = std::upper_bound(unloaded_.begin(), unloaded_.end(), name, [](unsigned n, const unloaded_instance& u) {
+        return n < u.name;
+    });
+    if (it == unloaded_.begin() || (--it)->name != name) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+void IfcFile::materialize_(std::vector<unsigned> names) {
+    arena::scope scope(arena_);
+    string_pool::scope strings_scope(intern_strings_ ? &strings_ : nullptr);
+
+    unresolved_references references;
+
+    auto enqueue = [&names](const reference_or_simple_type& v) {
+        if (auto* name = boost::get<int>(&v)) {
+            names.push_back((unsigned)*name);
+        }
+    };
+
+    while (!names.empty()) {
+        const unsigned name = names.back();
+        names.pop_back();
+
+        if (byid_.find(name) != byid_.end()) {
+            continue;
+        }
+        const unloaded_instance* entry = find_unloaded_(name);
+        if (entry == nullptr) {
+            continue;
+        }
+
+        stream->Seek(entry->offset);
+        tokens->Next();
+        tokens->Next();
+
+        unresolved_references instance_references;
+        parse_context ps;
+        load_(tokens, byref_excl_, instance_references, name, entry->decl->as_entity(), ps, -1);
+        auto* instance = schema_->instantiate(entry->decl, ps.construct(name, instance_references, entry->decl, boost::none));
+        instance->file_ = this;
+        instance->id_ = name;
+        register_parsed_instance_(instance);
+
+        // Instances referred to are parsed as well, so that references can be resolved
+        for (const auto& p : instance_references) {
+            if (auto* v = boost::get<reference_or_simple_type>(&p.second)) {
+                enqueue(*v);
+            } else if (auto* v = boost::get<std::vector<reference_or_simple_type>>(&p.second)) {
+                std::for_each(v->begin(), v->end(), enqueue);
+            } else if (auto* v = boost::get<std::vector<std::vector<reference_or_simple_type>>>(&p.second)) {
+                for (const auto& vi : *v) {
+                    std::for_each(vi.begin(), vi.end(), enqueue);
+                }
+            }
+        }
+        references.splice(references.end(), instance_references);
+    }
+
+    byref_excl_.build();
+    resolve_references_(references);
+}
+
+void IfcFile::materialize_all_() {
+    if (unloaded_.empty()) {
+        return;
+    }
+
+    std::vector<unsigned> names;
+    names.reserve(unloaded_.size());
+    // Reversed, so that instances are parsed in ascending order
+    for (auto it = unloaded_.rbegin(); it != unloaded_.rend(); ++it) {
+        names.push_back(it->name);
+    }
+    materialize_(std::move(names));
+
+    std::vector<unloaded_instance>().swap(unloaded_);
+    unloaded_by_type_.clear();
+
+    delete tokens;
+    tokens = nullptr;
+
+    if (stream == owned_stream_.get()) {
+        owned_stream_.reset();
+        stream = nullptr;
+    }
 }
 
 void IfcFile::recalculate_id_counter() {
@@ -1453,6 +2255,9 @@ void IfcFile::recalculate_id_counter() {
             k = p.first;
         }
     }
+    if (!unloaded_.empty() && unloaded_.back().name > k) {
+        k = unloaded_.back().name;
+    }
     MaxId = (unsigned int)k;
 }
 
@@ -1561,7 +2366,7 @@ void IfcFile::addEntities(aggregate_of_instance::ptr entities) {
 }
 
 IfcUtil::IfcBaseClass* IfcFile::addEntity(IfcUtil::IfcBaseClass* entity, int id) {
-    if (id != -1 && byid_.find((unsigned)id) != byid_.end()) {
+    if (id != -1 && (byid_.find((unsigned)id) != byid_.end() || find_unloaded_((unsigned)id) != nullptr)) {
         throw IfcParse::IfcException("An instance with id " + boost::lexical_cast<std::string>(id) + " is already part of this file");
     }
 
@@ -1696,14 +2501,13 @@ IfcUtil::IfcBaseClass* IfcFile::addEntity(IfcUtil::IfcBaseClass* entity, int id)
                     }
                     new_entity->data().storage_.set(i, v);
                 } else if (attr_type == IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_DOUBLE) {
-                    std::vector<std::vector<double>> v = attr;
-                    for (std::vector<std::vector<double>>::iterator it = v.begin(); it != v.end(); ++it) {
-                        std::vector<double>& v2 = (*it);
-                        for (std::vector<double>::iterator jt = v2.begin(); jt != v2.end(); ++jt) {
-                            (*jt) *= conversion_factor;
-                        }
+                    const auto& flat = attr.as_flat_aggregate_of_aggregate<double>();
+                    std::vector<double> v = flat.values();
+                    for (std::vector<double>::iterator it = v.begin(); it != v.end(); ++it) {
+                        (*it) *= conversion_factor;
                     }
-                    new_entity->data().storage_.set(i, v);
+                    std::vector<size_t> offsets = flat.offsets();
+                    new_entity->data().storage_.set(i, flat_aggregate_of_aggregate<double>(std::move(v), std::move(offsets)));
                 }
             }
         }
@@ -1729,12 +2533,11 @@ IfcUtil::IfcBaseClass* IfcFile::addEntity(IfcUtil::IfcBaseClass* entity, int id)
     if (new_entity->declaration().is(*ifcroot_type_)) {
         try {
             const std::string guid = new_entity->data().get_attribute_value(0);
-            if (byguid_.find(guid) != byguid_.end()) {
+            if (byguid_.insert(guid, new_entity) != nullptr) {
                 std::stringstream ss;
                 ss << "Overwriting entity with guid " << guid;
                 Logger::Message(Logger::LOG_WARNING, ss.str());
             }
-            byguid_[guid] = new_entity;
         } catch (const std::exception& ex) {
             Logger::Message(Logger::LOG_ERROR, ex.what());
         }
@@ -1767,14 +2570,18 @@ IfcUtil::IfcBaseClass* IfcFile::addEntity(IfcUtil::IfcBaseClass* entity, int id)
             new_id = new_entity->id();
         }
 
-        if (byid_.find(new_id) != byid_.end()) {
+        auto existing = byid_.find(new_id);
+        if (existing != byid_.end()) {
             // This should not happen
             std::stringstream ss;
             ss << "Overwriting entity with id " << new_id;
             Logger::Message(Logger::LOG_WARNING, ss.str());
+            journal_.record_modified(existing->second);
         }
         // The mapping by entity instance name is updated.
         byid_[new_id] = new_entity;
+        instance_changed_(new_id);
+        journal_.record_added(new_entity);
     } else if (new_entity->file_ == nullptr) {
         // For non-entity instances, no mappings are updated, but the file
         // pointer has to be set, so that actual copies are created in subsequent
@@ -1787,12 +2594,16 @@ IfcUtil::IfcBaseClass* IfcFile::addEntity(IfcUtil::IfcBaseClass* entity, int id)
 
     if ((ty->as_entity() != nullptr)) {
         build_inverses_(new_entity);
+        byref_excl_.build();
     }
 
     return new_entity;
 }
 
 void IfcFile::removeEntity(IfcUtil::IfcBaseClass* entity) {
+    // Removal needs the complete set of inverse references
+    materialize_all_();
+
     const unsigned id = entity->id();
 
     IfcUtil::IfcBaseClass* file_entity = instance_by_id(id);
@@ -1819,162 +2630,207 @@ void IfcFile::removeEntity(IfcUtil::IfcBaseClass* entity) {
     batch_deletion_ids_.push_back(id);
 
     if (!batch_mode_) {
-        process_deletion_();
+        try {
+            process_deletion_();
+        } catch (...) {
+            batch_deletion_ids_.clear();
+            throw;
+        }
     }
 }
 
+namespace {
+    // Removing at least 1/8th of the instances rebuilds the inverse
+    // index at once, rather than erasing the references of every instance
+    const size_t deletion_fraction_to_rebuild_inverses = 8;
+
+    // The new value of an attribute of an instance that refers to removed
+    // instances. When neither of the lists is set, the attribute is unset.
+    struct attribute_update {
+        IfcUtil::IfcBaseClass* instance;
+        size_t index;
+        aggregate_of_instance::ptr list;
+        aggregate_of_aggregate_of_instance::ptr list_of_lists;
+    };
+}
+
 void IfcFile::process_deletion_() {
+    if (batch_deletion_ids_.empty()) {
+        return;
+    }
 
+    const auto& deleted_ids = batch_deletion_ids_.get<1>();
+    auto is_deleted_id = [&deleted_ids](int id) {
+        return deleted_ids.find(id) != deleted_ids.end();
+    };
+    auto is_deleted = [&is_deleted_id](IfcUtil::IfcBaseClass* instance) {
+        // Simple type instances have id 0 and are never removed
+        return instance->id() != 0 && is_deleted_id(instance->id());
+    };
+
+    // Alter entity instances with INVERSE relations to the entities being
+    // deleted. This is necessary to maintain a valid IFC file, because
+    // dangling references to it's entities name should be removed. At this
+    // moment, inversely related instances affected by the removal of the
+    // entities being deleted are not deleted themselves.
+    //
+    // First, the attributes referring to the deleted instances are collected
+    // from the inverse index and their new values are computed. Nothing is
+    // modified until all of these are known, so that an exception leaves the
+    // file intact.
+
+    std::vector<IfcUtil::IfcBaseClass*> entities;
+    entities.reserve(batch_deletion_ids_.size());
+    std::vector<std::pair<int, short>> referring_attributes;
     for (const auto& id : batch_deletion_ids_.get<0>()) {
-        auto* entity = instance_by_id(id);
+        entities.push_back(instance_by_id(id));
+        byref_excl_.visit(id, [&](const inverse_attr_record& key, const int* begin, const int* end) {
+            for (auto it = begin; it != end; ++it) {
+                if (!is_deleted_id(*it)) {
+                    referring_attributes.emplace_back(*it, std::get<ATTRIBUTE_INDEX>(key));
+                }
+            }
+        });
+    }
 
-        aggregate_of_instance::ptr references = instances_by_reference(id);
+    // An instance referring to multiple deleted instances, possibly from the
+    // same aggregate, is updated once
+    std::sort(referring_attributes.begin(), referring_attributes.end());
+    referring_attributes.erase(std::unique(referring_attributes.begin(), referring_attributes.end()), referring_attributes.end());
 
-        // Alter entity instances with INVERSE relations to the entity being
-        // deleted. This is necessary to maintain a valid IFC file, because
-        // dangling references to it's entities name should be removed. At this
-        // moment, inversely related instances affected by the removal of the
-        // entity being deleted are not deleted themselves.
-        if (references) {
-            for (aggregate_of_instance::it iit = references->begin(); iit != references->end(); ++iit) {
-                IfcUtil::IfcBaseEntity* related_instance = (IfcUtil::IfcBaseEntity*)*iit;
+    std::vector<attribute_update> updates;
+    updates.reserve(referring_attributes.size());
+    for (const auto& ref : referring_attributes) {
+        IfcUtil::IfcBaseClass* related_instance = instance_by_id(ref.first);
+        const size_t i = (size_t) ref.second;
+        if (i >= related_instance->data().size()) {
+            continue;
+        }
+        auto attr = related_instance->data().get_attribute_value(i);
+        if (attr.isNull()) {
+            continue;
+        }
 
-                if (std::find(batch_deletion_ids_.begin(), batch_deletion_ids_.end(), related_instance->id()) != batch_deletion_ids_.end()) {
-                    continue;
+        switch (attr.type()) {
+        case IfcUtil::Argument_ENTITY_INSTANCE: {
+            IfcUtil::IfcBaseClass* instance_attribute = attr;
+            if (is_deleted(instance_attribute)) {
+                updates.push_back({related_instance, i, nullptr, nullptr});
+            }
+        } break;
+        case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE: {
+            aggregate_of_instance::ptr instance_list = attr;
+            aggregate_of_instance::ptr new_list(new aggregate_of_instance);
+            new_list->reserve(instance_list->size());
+            for (auto* instance : *instance_list) {
+                if (!is_deleted(instance)) {
+                    new_list->push(instance);
                 }
-
-                for (size_t i = 0; i < related_instance->data().size(); ++i) {
-                    auto attr = related_instance->data().get_attribute_value(i);
-                    if (attr.isNull()) {
-                        continue;
-                    }
-
-                    IfcUtil::ArgumentType attr_type = attr.type();
-                    switch (attr_type) {
-                    case IfcUtil::Argument_ENTITY_INSTANCE: {
-                        IfcUtil::IfcBaseClass* instance_attribute = attr;
-                        if (instance_attribute == entity) {
-                            related_instance->set_attribute_value(i, Blank{});
-                        }
-                    } break;
-                    case IfcUtil::Argument_AGGREGATE_OF_ENTITY_INSTANCE: {
-                        aggregate_of_instance::ptr instance_list = attr;
-                        if (instance_list->contains(entity)) {
-                            instance_list->remove(entity);
-                            if ((instance_list->size() == 0U) && related_instance->declaration().as_entity()->attribute_by_index(i)->optional()) {
-                                // @todo we can also check the lower bound of the attribute type before setting to null.
-                                related_instance->set_attribute_value(i, Blank{});
-                            } else {
-                                related_instance->set_attribute_value(i, instance_list);
-                            }
-                        }
-                    } break;
-                    case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE: {
-                        aggregate_of_aggregate_of_instance::ptr instance_list_list = attr;
-                        if (instance_list_list->contains(entity)) {
-                            aggregate_of_aggregate_of_instance::ptr new_list(new aggregate_of_aggregate_of_instance);
-                            for (aggregate_of_aggregate_of_instance::outer_it it = instance_list_list->begin(); it != instance_list_list->end(); ++it) {
-                                std::vector<IfcUtil::IfcBaseClass*> instances = *it;
-                                std::vector<IfcUtil::IfcBaseClass*>::iterator jt;
-                                while ((jt = std::find(instances.begin(), instances.end(), entity)) != instances.end()) {
-                                    instances.erase(jt);
-                                }
-                                new_list->push(instances);
-                            }
-                            related_instance->set_attribute_value(i, new_list);
-                        }
-                    } break;
-                    default:
-                        break;
-                    }
+            }
+            if (new_list->size() != instance_list->size()) {
+                if ((new_list->size() == 0U) && related_instance->declaration().as_entity()->attribute_by_index(i)->optional()) {
+                    // @todo we can also check the lower bound of the attribute type before setting to null.
+                    updates.push_back({related_instance, i, nullptr, nullptr});
+                } else {
+                    updates.push_back({related_instance, i, new_list, nullptr});
                 }
             }
+        } break;
+        case IfcUtil::Argument_AGGREGATE_OF_AGGREGATE_OF_ENTITY_INSTANCE: {
+            aggregate_of_aggregate_of_instance::ptr instance_list_list = attr;
+            aggregate_of_aggregate_of_instance::ptr new_list(new aggregate_of_aggregate_of_instance);
+            bool changed = false;
+            for (aggregate_of_aggregate_of_instance::outer_it it = instance_list_list->begin(); it != instance_list_list->end(); ++it) {
+                std::vector<IfcUtil::IfcBaseClass*> instances = *it;
+                const size_t size_before = instances.size();
+                instances.erase(std::remove_if(instances.begin(), instances.end(), is_deleted), instances.end());
+                changed |= instances.size() != size_before;
+                new_list->push(instances);
+            }
+            if (changed) {
+                updates.push_back({related_instance, i, nullptr, new_list});
+            }
+        } break;
+        default:
+            break;
         }
+    }
 
-        if (!batch_mode_) {
-            byref_excl_.erase(
-                byref_excl_.lower_bound({id, -1, -1}),
-                byref_excl_.upper_bound({id, std::numeric_limits<short>::max(), std::numeric_limits<short>::max()}));
-
-            // byref_excl_.erase(id);
-
-            // This is based on traversal which needs instances to still be contained in the map.
-            // another option would be to keep byid intact for the remainder of this loop
-            aggregate_of_instance::ptr entity_attributes = traverse(entity, 1);
-            for (aggregate_of_instance::it it = entity_attributes->begin(); it != entity_attributes->end(); ++it) {
-                IfcUtil::IfcBaseClass* entity_attribute = *it;
-                if (entity_attribute == entity) {
-                    continue;
-                }
-                const unsigned int name = entity_attribute->id();
-                // Do not update inverses for simple types (which have id()==0 in IfcOpenShell).
-                if (name != 0) {
-                    {
-                        auto lower = byref_excl_.lower_bound({name, -1, -1});
-                        auto upper = byref_excl_.upper_bound({name, std::numeric_limits<short>::max(), std::numeric_limits<short>::max()});
-
-                        for (auto byref_it = lower; byref_it != upper; ++byref_it) {
-                            auto& ids = byref_it->second;
-                            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
-                        }
-                    }
-                }
+    for (const auto& update : updates) {
+        if (update.list) {
+            update.instance->set_attribute_value(update.index, update.list);
+        } else if (update.list_of_lists) {
+            update.instance->set_attribute_value(update.index, update.list_of_lists);
+        } else {
+            update.instance->set_attribute_value(update.index, Blank{});
+        }
+    }
+
+    // Remove the references from and to the deleted instances from the
+    // inverse index, either one by one or by rebuilding it in a single pass
+    // when a large part of the file is deleted.
+    const bool rebuild_inverses = batch_deletion_ids_.size() * deletion_fraction_to_rebuild_inverses >= byid_.size();
+    if (rebuild_inverses) {
+        byref_excl_.erase_if(is_deleted_id, is_deleted_id);
+        if (track_changes_) {
+            auto referenced = [this](IfcUtil::IfcBaseClass* inst, int) {
+                inverses_changed_(inst->id());
+            };
+            for (auto* entity : entities) {
+                apply_individual_instance_visitor(&entity->data()).apply(referenced);
             }
         }
+    } else {
+        for (auto* entity : entities) {
+            byref_excl_.erase((int) entity->id());
+            unregister_inverse_visitor visitor(*this, entity);
+            apply_individual_instance_visitor(&entity->data()).apply(visitor);
+        }
+    }
 
+    std::map<const IfcParse::declaration*, std::vector<IfcUtil::IfcBaseClass*>> deleted_by_type;
+    for (auto* entity : entities) {
         if (entity->declaration().is(*ifcroot_type_) && !entity->data().get_attribute_value(0).isNull()) {
             const std::string global_id = entity->data().get_attribute_value(0);
-            auto it = byguid_.find(global_id);
-            if (it != byguid_.end()) {
-                byguid_.erase(it);
-            } else {
+            if (!byguid_.erase(global_id)) {
                 Logger::Warning("GlobalId on rooted instance not encountered in map");
             }
         }
 
-        byid_.erase(byid_.find(id));
-
-        const IfcParse::declaration* ty = &entity->declaration();
-
-        {
-            auto it = bytype_excl_.find(ty);
-            if (it != bytype_excl_.end()) {
-                it->second->remove(entity);
-                if (it->second->size() == 0) {
-                    bytype_excl_.erase(ty);
-                }
+        journal_.record_removed(entity);
+        byid_.erase(entity->id());
+        instance_changed_(entity->id());
+        deleted_by_type[&entity->declaration()].push_back(entity);
+    }
+
+    for (auto& p : deleted_by_type) {
+        auto it = bytype_excl_.find(p.first);
+        if (it != bytype_excl_.end()) {
+            // Compared by address, so that the remaining instances of the
+            // type do not need to be accessed
+            auto& instances = p.second;
+            std::sort(instances.begin(), instances.end());
+            it->second->remove_if([&instances](IfcUtil::IfcBaseClass* instance) {
+                return std::binary_search(instances.begin(), instances.end(), instance);
+            });
+            if (it->second->size() == 0) {
+                bytype_excl_.erase(it);
             }
         }
+    }
 
-        // entity_file_map is in place to prevent duplicate definitions with usage of add().
-        // Upon deletion the pairs need to be erased.
-        for (auto it = entity_file_map_.begin(); it != entity_file_map_.end();) {
-            if (it->second == entity) {
-                it = entity_file_map_.erase(it);
-            } else {
-                ++it;
-            }
+    // entity_file_map is in place to prevent duplicate definitions with usage of add().
+    // Upon deletion the pairs need to be erased.
+    for (auto it = entity_file_map_.begin(); it != entity_file_map_.end();) {
+        if (is_deleted(it->second)) {
+            it = entity_file_map_.erase(it);
+        } else {
+            ++it;
         }
-
-        delete entity;
     }
 
-    if (batch_mode_) {
-        for (auto it = byref_excl_.begin(); it != byref_excl_.end();) {
-            bool do_delete = batch_deletion_ids_.get<1>().find(std::get<INSTANCE_ID>(it->first)) != batch_deletion_ids_.get<1>().end();
-            if (!do_delete) {
-                it->second.erase(std::remove_if(it->second.begin(), it->second.end(), [this](int x) {
-                                     return batch_deletion_ids_.get<1>().find(x) != batch_deletion_ids_.get<1>().end();
-                                 }),
-                                 it->second.end());
-                do_delete = it->second.empty();
-            }
-            if (do_delete) {
-                it = byref_excl_.erase(it);
-            } else {
-                ++it;
-            }
-        }
+    for (auto* entity : entities) {
+        delete entity;
     }
 
     batch_deletion_ids_.clear();
@@ -2001,6 +2857,17 @@ namespace {
 aggregate_of_instance::ptr IfcFile::instances_by_type(const IfcParse::declaration* t) {
     aggregate_of_instance::ptr insts(new aggregate_of_instance);
     if (t->as_entity() != nullptr) {
+        if (!unloaded_.empty()) {
+            std::vector<unsigned> names;
+            visit_subtypes(t->as_entity(), [this, &names](const IfcParse::entity* ent) {
+                auto it = unloaded_by_type_.find(ent);
+                if (it != unloaded_by_type_.end()) {
+                    names.insert(names.end(), it->second.rbegin(), it->second.rend());
+                    unloaded_by_type_.erase(it);
+                }
+            });
+            materialize_(std::move(names));
+        }
         visit_subtypes(t->as_entity(), [this, &insts](const IfcParse::entity* ent) {
             auto it = bytype_excl_.find(ent);
             if (it != bytype_excl_.end()) {
@@ -2012,6 +2879,11 @@ aggregate_of_instance::ptr IfcFile::instances_by_type(const IfcParse::declaratio
 }
 
 aggregate_of_instance::ptr IfcFile::instances_by_type_excl_subtypes(const IfcParse::declaration* t) {
+    auto unloaded = unloaded_by_type_.find(t);
+    if (unloaded != unloaded_by_type_.end()) {
+        materialize_(std::vector<unsigned>(unloaded->second.rbegin(), unloaded->second.rend()));
+        unloaded_by_type_.erase(unloaded);
+    }
     entities_by_type_t::const_iterator it = bytype_excl_.find(t);
     return (it == bytype_excl_.end()) ? aggregate_of_instance::ptr(new aggregate_of_instance) : it->second;
 }
@@ -2025,19 +2897,23 @@ aggregate_of_instance::ptr IfcFile::instances_by_type_excl_subtypes(const std::s
 }
 
 aggregate_of_instance::ptr IfcFile::instances_by_reference(int t) {
-    auto lower = byref_excl_.lower_bound({ t, -1, -1 });
-    auto upper = byref_excl_.upper_bound({ t, std::numeric_limits<short>::max(), std::numeric_limits<short>::max() });
+    materialize_all_();
+
     aggregate_of_instance::ptr ret(new aggregate_of_instance);
-    for (auto it = lower; it != upper; ++it) {
-        for (auto& i : it->second) {
-            ret->push(instance_by_id(i));
+    byref_excl_.visit(t, [this, &ret](const inverse_attr_record&, const int* begin, const int* end) {
+        for (auto it = begin; it != end; ++it) {
+            ret->push(instance_by_id(*it));
         }
-    }
+    });
     return ret;
 }
 
 IfcUtil::IfcBaseClass* IfcFile::instance_by_id(int id) {
     entity_by_id_t::const_iterator it = byid_.find(id);
+    if (it == byid_.end() && !unloaded_.empty()) {
+        materialize_({(unsigned)id});
+        it = byid_.find(id);
+    }
     if (it == byid_.end()) {
         throw IfcException("Instance #" + boost::lexical_cast<std::string>(id) + " not found");
     }
@@ -2045,11 +2921,25 @@ IfcUtil::IfcBaseClass* IfcFile::instance_by_id(int id) {
 }
 
 IfcUtil::IfcBaseClass* IfcFile::instance_by_guid(const std::string& guid) {
-    entity_by_guid_t::const_iterator it = byguid_.find(guid);
-    if (it == byguid_.end()) {
+    if (!unloaded_.empty()) {
+        // Populates the GlobalId map
+        instances_by_type(ifcroot_type_);
+    }
+    auto* instance = byguid_.find(guid);
+    if (instance == nullptr) {
         throw IfcException("Instance with GlobalId '" + guid + "' not found");
     }
-    return it->second;
+    return instance;
+}
+
+std::vector<IfcUtil::IfcBaseClass*> IfcFile::instances_by_guid(const std::vector<std::string>& guids) {
+    if (!unloaded_.empty()) {
+        // Populates the GlobalId map
+        instances_by_type(ifcroot_type_);
+    }
+    std::vector<IfcUtil::IfcBaseClass*> instances;
+    byguid_.find(guids, instances);
+    return instances;
 }
 
 // FIXME: Test destructor to delete entity and arg allocations
@@ -2064,50 +2954,34 @@ IfcFile::~IfcFile() {
     for (auto* entity : entities_to_delete) {
         delete entity;
     }
+    delete tokens;
 }
 
+// Iteration covers all instances, so any instances not yet parsed in lazy mode are
+// read first. This does not change the logical contents of the file.
+
 IfcFile::entity_by_id_t::const_iterator IfcFile::begin() const {
+    const_cast<IfcFile*>(this)->materialize_all_();
     return byid_.begin();
 }
 
 IfcFile::entity_by_id_t::const_iterator IfcFile::end() const {
+    const_cast<IfcFile*>(this)->materialize_all_();
     return byid_.end();
 }
 
 IfcFile::type_iterator IfcFile::types_begin() const {
+    const_cast<IfcFile*>(this)->materialize_all_();
     return bytype_excl_.begin();
 }
 
 IfcFile::type_iterator IfcFile::types_end() const {
+    const_cast<IfcFile*>(this)->materialize_all_();
     return bytype_excl_.end();
 }
 
-namespace {
-struct id_instance_pair_sorter {
-    bool operator()(const IfcParse::IfcFile::entity_by_id_t::value_type& a, const IfcParse::IfcFile::entity_by_id_t::value_type& b) const {
-        return a.first < b.first;
-    }
-};
-} // namespace
-
 std::ostream& operator<<(std::ostream& out, const IfcParse::IfcFile& file) {
-    file.header().write(out);
-
-    typedef std::vector<std::pair<unsigned int, IfcUtil::IfcBaseClass*>> vector_t;
-    vector_t sorted(file.begin(), file.end());
-    std::sort(sorted.begin(), sorted.end(), id_instance_pair_sorter());
-
-    for (vector_t::const_iterator it = sorted.begin(); it != sorted.end(); ++it) {
-        const IfcUtil::IfcBaseClass* e = it->second;
-        if (e->declaration().as_entity() != nullptr) {
-            e->toString(out, true);
-            out << ";" << std::endl;
-        }
-    }
-
-    out << "ENDSEC;" << std::endl;
-    out << "END-ISO-10303-21;" << std::endl;
-
+    IfcParse::IfcSpfWriter(file).write(out);
     return out;
 }
 
@@ -2128,23 +3002,22 @@ std::string IfcFile::createTimestamp() {
 }
 
 std::vector<int> IfcFile::get_inverse_indices(int instance_id) {
-    std::vector<int> return_value;
+    materialize_all_();
 
-    auto lower = byref_excl_.lower_bound({instance_id, -1, -1});
-    auto upper = byref_excl_.upper_bound({instance_id, std::numeric_limits<short>::max(), std::numeric_limits<short>::max()});
+    std::vector<int> return_value;
 
     // Mapping of instance id to attribute offset.
     std::map<int, std::vector<int>> mapping;
 
-    for (auto it = lower; it != upper; ++it) {
-        for (auto& i : it->second) {
+    byref_excl_.visit(instance_id, [this, &mapping](const inverse_attr_record& key, const int* begin, const int* end) {
+        for (auto it = begin; it != end; ++it) {
             // We only take the tuple for the type that id=i actually is, in order not
             // to count double. Because byref contains mappings for every supertype of id=i.
-            if (instance_by_id(i)->declaration().index_in_schema() == std::get<1>(it->first)) {
-                mapping[i].push_back(std::get<2>(it->first));
+            if (instance_by_id(*it)->declaration().index_in_schema() == std::get<INSTANCE_TYPE>(key)) {
+                mapping[*it].push_back(std::get<ATTRIBUTE_INDEX>(key));
             }
         }
-    }
+    });
 
     auto refs = instances_by_reference(instance_id);
 
@@ -2173,25 +3046,22 @@ aggregate_of_instance::ptr IfcFile::getInverse(int instance_id, const IfcParse::
         return instances_by_reference(instance_id);
     }
 
+    materialize_all_();
+
     aggregate_of_instance::ptr return_value(new aggregate_of_instance);
 
     visit_subtypes(type->as_entity(), [this, attribute_index, instance_id, &return_value](const IfcParse::declaration* ent) {
-        if (attribute_index == -1) {
-            auto lower = byref_excl_.lower_bound({ instance_id, ent->index_in_schema(), -1 });
-            auto upper = byref_excl_.upper_bound({ instance_id, ent->index_in_schema(), std::numeric_limits<short>::max() });
-
-            for (auto it = lower; it != upper; ++it) {
-                for (auto& i : it->second) {
-                    return_value->push(instance_by_id(i));
-                }
+        auto push = [this, &return_value](const inverse_attr_record&, const int* begin, const int* end) {
+            for (auto it = begin; it != end; ++it) {
+                return_value->push(instance_by_id(*it));
             }
+        };
+        const short type_index = (short) ent->index_in_schema();
+        if (attribute_index == -1) {
+            byref_excl_.visit({ instance_id, type_index, std::numeric_limits<short>::min() }, { instance_id, type_index, std::numeric_limits<short>::max() }, push);
         } else {
-            auto it = byref_excl_.find({ instance_id, ent->index_in_schema(), attribute_index });
-            if (it != byref_excl_.end()) {
-                for (auto& i : it->second) {
-                    return_value->push(instance_by_id(i));
-                }
-            }
+            const inverse_attr_record key{ instance_id, type_index, (short) attribute_index };
+            byref_excl_.visit(key, key, push);
         }
     });
 
@@ -2199,13 +3069,9 @@ aggregate_of_instance::ptr IfcFile::getInverse(int instance_id, const IfcParse::
 }
 
 size_t IfcFile::getTotalInverses(int instance_id) {
-    size_t n = 0;
-    auto lower = byref_excl_.lower_bound({ instance_id, -1, -1 });
-    auto upper = byref_excl_.upper_bound({ instance_id, std::numeric_limits<short>::max(), std::numeric_limits<short>::max() });
-    for (auto it = lower; it != upper; ++it) {
-        n += it->second.size();
-    }
-    return n;
+    materialize_all_();
+
+    return byref_excl_.count(instance_id);
 }
 
 void IfcFile::setDefaultHeaderValues() {
@@ -2300,29 +3166,87 @@ std::pair<IfcUtil::IfcBaseClass*, double> IfcFile::getUnit(const std::string& un
     return return_value;
 }
 
-void IfcParse::IfcFile::build_inverses_(IfcUtil::IfcBaseClass* inst) {
-    std::function<void(IfcUtil::IfcBaseClass*, int)> fn = [this, inst](IfcUtil::IfcBaseClass* attr, int idx) {
-        if (attr->declaration().as_entity() != nullptr) {
-            unsigned entity_attribute_id = attr->id();
-            const auto* decl = inst->declaration().as_entity();
-            byref_excl_[{entity_attribute_id, decl->index_in_schema(), idx}].push_back(inst->id());
-        }
-    };
+namespace {
+    // Calls fn(key, name) for every reference to an entity instance in the
+    // attributes of inst
+    template <typename Fn>
+    void visit_references(IfcUtil::IfcBaseClass* inst, Fn fn) {
+        const short type = (short) inst->declaration().as_entity()->index_in_schema();
+        auto visit = [&fn, inst, type](IfcUtil::IfcBaseClass* attr, int idx) {
+            if (attr->declaration().as_entity() != nullptr) {
+                fn(IfcParse::IfcFile::inverse_attr_record{(int) attr->id(), type, (short) idx}, (int) inst->id());
+            }
+        };
+        apply_individual_instance_visitor(&inst->data()).apply(visit);
+    }
 
-    apply_individual_instance_visitor(&inst->data()).apply(fn);
+    // Instances are not scanned on more threads than leave each of them at
+    // least this many instances
+    const size_t minimal_instances_per_thread = 4096;
+}
+
+void IfcParse::IfcFile::build_inverses_(IfcUtil::IfcBaseClass* inst) {
+    visit_references(inst, [this](const inverse_attr_record& key, int name) {
+        byref_excl_.append(key, name);
+        inverses_changed_(std::get<0>(key));
+    });
 }
 
 void IfcParse::IfcFile::build_inverses() {
+    materialize_all_();
+
+    std::vector<IfcUtil::IfcBaseClass*> instances;
+    instances.reserve(byid_.size());
     for (const auto& pair : *this) {
-        build_inverses_(pair.second);
+        instances.push_back(pair.second);
     }
+
+    const unsigned num_threads = parse_threads_ == 0 ? std::thread::hardware_concurrency() : parse_threads_;
+    const size_t num_ranges = (std::max)((size_t) 1, (std::min)((size_t) num_threads, instances.size() / minimal_instances_per_thread));
+
+    // Every thread scans a contiguous range of instances into its own buffer.
+    // The buffers are appended in the order of the ranges, so that the index
+    // is identical to the one built by scanning the instances sequentially.
+    std::vector<std::vector<std::pair<inverse_attr_record, int>>> references(num_ranges);
+    auto scan = [&instances, &references, num_ranges](size_t i) {
+        const size_t begin = instances.size() * i / num_ranges;
+        const size_t end = instances.size() * (i + 1) / num_ranges;
+        for (size_t j = begin; j < end; ++j) {
+            visit_references(instances[j], [&references, i](const inverse_attr_record& key, int name) {
+                references[i].emplace_back(key, name);
+            });
+        }
+    };
+
+    run_in_threads(num_ranges, scan);
+
+    for (auto& rs : references) {
+        if (track_changes_) {
+            for (const auto& r : rs) {
+                inverses_changed_(std::get<0>(r.first));
+            }
+        }
+        byref_excl_.append(rs);
+    }
+    byref_excl_.build(num_threads);
 }
 
 std::atomic_uint32_t IfcUtil::IfcBaseClass::counter_(0);
 
 bool IfcParse::IfcFile::guid_map_ = true;
 
+unsigned IfcParse::IfcFile::parse_threads_ = 1;
+
+unsigned IfcParse::IfcFile::write_threads_ = 1;
+
+bool IfcParse::IfcFile::lazy_load_ = false;
+
+bool IfcParse::IfcFile::intern_strings_ = false;
+
 void IfcUtil::IfcBaseClass::unset_attribute_value(size_t index) {
+    if (file_ != nullptr && declaration().as_entity() != nullptr) {
+        file_->journal_.record_modified(this);
+    }
     data_.storage_.set(index, Blank{});
 }
 
@@ -37,6 +37,7 @@
 
 #include <boost/dynamic_bitset.hpp>
 #include <boost/shared_ptr.hpp>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -68,8 +69,10 @@ enum TokenType {
 
 struct Token {
     IfcSpfLexer* lexer; //TODO: remove it from here
-    unsigned startPos;
-    TokenType type;
+    // The file offset and type share a single 64-bit word, which allows
+    // for files of up to 2^56 bytes without growing the token.
+    std::uint64_t startPos : 56;
+    TokenType type : 8;
     union {
         char value_char;     //types: OPERATOR
         int value_int;       //types: INT, IDENTIFIER
@@ -79,12 +82,17 @@ struct Token {
     Token() : lexer(0),
               startPos(0),
               type(Token_NONE) {}
-    Token(IfcSpfLexer* _lexer, unsigned _startPos, unsigned /*_endPos*/, TokenType _type)
+    Token(IfcSpfLexer* _lexer, size_t _startPos, size_t /*_endPos*/, TokenType _type)
         : lexer(_lexer),
           startPos(_startPos),
           type(_type) {}
 };
 
+#ifndef _MSC_VER
+// MSVC does not pack bit fields of differing types
+static_assert(sizeof(Token) <= 3 * sizeof(std::uint64_t), "Token is expected to fit in three words");
+#endif
+
 /// Provides functions to convert Tokens to binary data
 /// Tokens are merely offsets to where they can be read in the file
 class IFC_PARSE_API TokenFunc {
@@ -140,16 +148,16 @@ class IFC_PARSE_API TokenFunc {
 // Functions for creating Tokens from an arbitary file offset
 // The first 4 bits are reserved for Tokens of type ()=,;$*
 //
-Token OperatorTokenPtr(IfcSpfLexer* tokens, unsigned start, unsigned end);
-Token GeneralTokenPtr(IfcSpfLexer* tokens, unsigned start, unsigned end);
+Token OperatorTokenPtr(IfcSpfLexer* tokens, size_t start, size_t end);
+Token GeneralTokenPtr(IfcSpfLexer* tokens, size_t start, size_t end);
 Token NoneTokenPtr();
 
 /// A stream of tokens to be read from a IfcSpfStream.
 class IFC_PARSE_API IfcSpfLexer {
   private:
     IfcCharacterDecoder* decoder_;
-    unsigned int skipWhitespace() const;
-    unsigned int skipComment() const;
+    size_t skipWhitespace() const;
+    size_t skipComment() const;
 
   public:
     std::string& GetTempString() const {
@@ -161,7 +169,7 @@ class IFC_PARSE_API IfcSpfLexer {
     IfcSpfLexer(IfcSpfStream* stream, IfcFile* file);
     Token Next();
     ~IfcSpfLexer();
-    void TokenString(unsigned int offset, std::string& result);
+    void TokenString(size_t offset, std::string& result);
 };
 
 IFC_PARSE_API IfcEntityInstanceData read(unsigned int index, IfcFile* file);
@@ -85,7 +85,7 @@ bool IfcParse::declaration::is(const std::string& name) const {
     return false;
 }
 
-bool IfcParse::declaration::is(const IfcParse::declaration& decl) const {
+bool IfcParse::declaration::is_(const IfcParse::declaration& decl) const {
     if (this == &decl) {
         return true;
     }
@@ -119,6 +119,52 @@ IfcParse::entity::~entity() {
         delete inverse_attribute;
     }
 }
+
+void IfcParse::entity::index_attributes_() {
+    std::vector<const entity*> lineage;
+    for (const entity* current = this; current != nullptr; current = current->supertype_) {
+        lineage.push_back(current);
+    }
+
+    all_attributes_.clear();
+    all_inverse_attributes_.clear();
+    for (auto it = lineage.rbegin(); it != lineage.rend(); ++it) {
+        all_attributes_.insert(all_attributes_.end(), (*it)->attributes_.begin(), (*it)->attributes_.end());
+        all_inverse_attributes_.insert(all_inverse_attributes_.end(), (*it)->inverse_attributes_.begin(), (*it)->inverse_attributes_.end());
+    }
+
+    attribute_index_by_name_.clear();
+    attribute_index_by_name_.reserve(all_attributes_.size());
+    for (size_t i = 0; i < all_attributes_.size(); ++i) {
+        attribute_index_by_name_.emplace_back(&all_attributes_[i]->name(), i);
+    }
+    // In case of duplicate names, the attribute of the most specific entity,
+    // i.e. the one at the highest position, is found first.
+    std::sort(attribute_index_by_name_.begin(), attribute_index_by_name_.end(), [](const std::pair<const std::string*, size_t>& a, const std::pair<const std::string*, size_t>& b) {
+        const int c = a.first->compare(*b.first);
+        return c < 0 || (c == 0 && a.second > b.second);
+    });
+}
+
+const std::pair<const std::string*, size_t>* IfcParse::entity::find_attribute_(const std::string& name) const {
+    auto it = std::lower_bound(attribute_index_by_name_.begin(), attribute_index_by_name_.end(), name, [](const std::pair<const std::string*, size_t>& a, const std::string& b) {
+        return *a.first < b;
+    });
+    if (it == attribute_index_by_name_.end() || *it->first != name) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+const IfcParse::inverse_attribute* IfcParse::entity::inverse_attribute_by_name(const std::string& attr_name) const {
+    for (const auto* attr : all_inverse_attributes_) {
+        if (attr->name() == attr_name) {
+            return attr;
+        }
+    }
+    return nullptr;
+}
+
 static std::map<std::string, const IfcParse::schema_definition*> schemas;
 
 IfcParse::schema_definition::schema_definition(const std::string& name, const std::vector<const declaration*>& declarations, instance_factory* factory)
@@ -140,6 +186,44 @@ IfcParse::schema_definition::schema_definition(const std::string& name, const st
         }
         if ((**it).as_entity() != nullptr) {
             entities_.push_back((**it).as_entity());
+            // The declarations are owned by the schema, the attributes of all
+            // entities have been set by now
+            const_cast<entity*>((**it).as_entity())->index_attributes_();
+        }
+    }
+
+    // Number the entities in a depth-first traversal of the subtype trees, see
+    // declaration::is()
+    std::map<const entity*, std::vector<const entity*>> subtypes;
+    std::vector<const entity*> roots;
+    for (const auto* e : entities_) {
+        if (e->supertype() != nullptr) {
+            subtypes[e->supertype()].push_back(e);
+        } else {
+            roots.push_back(e);
+        }
+    }
+    unsigned preorder_rank = 0, postorder_rank = 0;
+    // Entities to visit, and whether their subtypes have been visited
+    std::vector<std::pair<const entity*, bool>> stack;
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+        stack.emplace_back(*it, false);
+    }
+    while (!stack.empty()) {
+        const entity* e = stack.back().first;
+        const bool subtypes_visited = stack.back().second;
+        stack.pop_back();
+        if (subtypes_visited) {
+            e->postorder_rank_ = ++postorder_rank;
+            continue;
+        }
+        e->preorder_rank_ = ++preorder_rank;
+        stack.emplace_back(e, true);
+        auto it = subtypes.find(e);
+        if (it != subtypes.end()) {
+            for (auto jt = it->second.rbegin(); jt != it->second.rend(); ++jt) {
+                stack.emplace_back(*jt, false);
+            }
         }
     }
     schemas[name_] = this;
@@ -146,17 +146,27 @@ class IFC_PARSE_API declaration {
     int index_in_schema_;
     mutable const schema_definition* schema_;
 
+    // Ranks of an entity in a pre-order and post-order traversal of the
+    // subtype trees of its schema, assigned by the schema_definition. An
+    // entity is a subtype of another if it comes after it in pre-order and
+    // before it in post-order. 0 for other declarations.
+    mutable unsigned preorder_rank_, postorder_rank_;
+
     std::string& temp_string_() const {
         static my_thread_local std::string string;
         return string;
     }
 
+    bool is_(const IfcParse::declaration& decl) const;
+
   public:
     declaration(const std::string& name, int index_in_schema)
         : name_(name),
           name_upper_(boost::to_upper_copy(name)),
           index_in_schema_(index_in_schema),
-          schema_(0) {}
+          schema_(0),
+          preorder_rank_(0),
+          postorder_rank_(0) {}
 
     virtual ~declaration() {}
 
@@ -169,7 +179,13 @@ class IFC_PARSE_API declaration {
     virtual const entity* as_entity() const { return static_cast<entity*>(0); }
 
     bool is(const std::string& name) const;
-    bool is(const IfcParse::declaration& decl) const;
+
+    bool is(const IfcParse::declaration& decl) const {
+        if (preorder_rank_ != 0 && decl.preorder_rank_ != 0 && schema_ == decl.schema_) {
+            return decl.preorder_rank_ <= preorder_rank_ && postorder_rank_ <= decl.postorder_rank_;
+        }
+        return is_(decl);
+    }
 
     int index_in_schema() const { return index_in_schema_; }
 
@@ -296,7 +312,36 @@ class IFC_PARSE_API inverse_attribute {
     const attribute* attribute_reference() const { return attribute_reference_; }
 };
 
+/// Position of an attribute in the instances of an entity and its subtypes,
+/// as returned by entity::attribute_handle_by_name(). Attributes of subtypes
+/// follow the attributes of their supertypes, so the position is the same for
+/// instances of all subtypes. Obtaining a handle once avoids looking up the
+/// attribute name for every instance that is read.
+class IFC_PARSE_API attribute_handle {
+  private:
+    const entity* entity_;
+    size_t index_;
+
+  public:
+    attribute_handle()
+        : entity_(nullptr),
+          index_(0) {}
+
+    attribute_handle(const entity* entity, size_t index)
+        : entity_(entity),
+          index_(index) {}
+
+    /// The entity the handle was obtained from
+    const entity* entity_declaration() const { return entity_; }
+    size_t index() const { return index_; }
+
+    /// Whether the handle refers to an attribute, i.e. the name was found
+    explicit operator bool() const { return entity_ != nullptr; }
+};
+
 class IFC_PARSE_API entity : public declaration {
+    friend class schema_definition;
+
   protected:
     bool is_abstract_;
     const entity* supertype_; /* NB: IFC explicitly allows only single inheritance */
@@ -307,31 +352,17 @@ class IFC_PARSE_API entity : public declaration {
 
     std::vector<const inverse_attribute*> inverse_attributes_;
 
-    class attribute_by_name_cmp {
-      private:
-        std::string name_;
+    // Attributes including the ones of the supertypes, built by index_attributes_()
+    std::vector<const attribute*> all_attributes_;
+    std::vector<const inverse_attribute*> all_inverse_attributes_;
 
-      public:
-        attribute_by_name_cmp(const std::string name)
-            : name_(name) {}
-        bool operator()(const attribute* attr) {
-            return attr->name() == name_;
-        }
-    };
+    // Positions in all_attributes_ sorted by attribute name
+    std::vector<std::pair<const std::string*, size_t>> attribute_index_by_name_;
 
-    const attribute* attribute_by_index_(size_t& index) const {
-        const attribute* attr = 0;
-        if (supertype_ != nullptr) {
-            attr = supertype_->attribute_by_index_(index);
-        }
-        if (attr == 0) {
-            if (index < attributes_.size()) {
-                attr = attributes_[index];
-            }
-            index -= attributes_.size();
-        }
-        return attr;
-    }
+    // Called by the schema_definition once the attributes of all entities are set
+    void index_attributes_();
+
+    const std::pair<const std::string*, size_t>* find_attribute_(const std::string& name) const;
 
   public:
     entity(const std::string& name, bool is_abstract, int index_in_schema, entity* supertype)
@@ -360,78 +391,47 @@ class IFC_PARSE_API entity : public declaration {
     const std::vector<const attribute*>& attributes() const { return attributes_; }
     const std::vector<bool>& derived() const { return derived_; }
 
-    const std::vector<const attribute*> all_attributes() const {
-        std::vector<const attribute*> attrs;
-        attrs.reserve(derived_.size());
-        if (supertype_ != nullptr) {
-            const std::vector<const attribute*> supertype_attrs = supertype_->all_attributes();
-            std::copy(supertype_attrs.begin(), supertype_attrs.end(), std::back_inserter(attrs));
-        }
-        std::copy(attributes_.begin(), attributes_.end(), std::back_inserter(attrs));
-        return attrs;
-    }
-
-    const std::vector<const inverse_attribute*> all_inverse_attributes() const {
-        std::vector<const inverse_attribute*> attrs;
-        if (supertype_ != nullptr) {
-            const std::vector<const inverse_attribute*> supertype_inv_attrs = supertype_->all_inverse_attributes();
-            std::copy(supertype_inv_attrs.begin(), supertype_inv_attrs.end(), std::back_inserter(attrs));
-        }
-        std::copy(inverse_attributes_.begin(), inverse_attributes_.end(), std::back_inserter(attrs));
-        return attrs;
-    }
+    /// The attributes of the entity and its supertypes, in the order of the
+    /// attribute values of instances. Available once the entity is part of a
+    /// schema_definition.
+    const std::vector<const attribute*>& all_attributes() const { return all_attributes_; }
+    const std::vector<const inverse_attribute*>& all_inverse_attributes() const { return all_inverse_attributes_; }
 
     const attribute* attribute_by_index(size_t index) const {
-        const attribute* attr = attribute_by_index_(index);
-        if (attr == 0) {
+        if (index >= all_attributes_.size()) {
             throw IfcParse::IfcException("Attribute index out of bounds");
         }
-        return attr;
+        return all_attributes_[index];
     }
 
     size_t attribute_count() const {
-        size_t super_count = 0;
-        if (supertype_ != nullptr) {
-            super_count = supertype_->attribute_count();
-        }
-        return super_count + attributes_.size();
+        return all_attributes_.size();
     }
 
     ptrdiff_t attribute_index(const attribute* attr) const {
-        const entity* current = this;
-        ptrdiff_t index = -1;
-        do {
-            if (index > -1) {
-                index += current->attributes().size();
-            } else {
-                std::vector<const attribute*>::const_iterator iter;
-                iter = std::find(current->attributes().begin(), current->attributes().end(), attr);
-                if (iter != current->attributes().end()) {
-                    index = std::distance(current->attributes().begin(), iter);
-                }
-            }
-        } while ((current = current->supertype_) != 0);
-        return index;
+        auto iter = std::find(all_attributes_.begin(), all_attributes_.end(), attr);
+        if (iter == all_attributes_.end()) {
+            return -1;
+        }
+        return std::distance(all_attributes_.begin(), iter);
     }
 
+    /// Returns the position of the attribute named attr_name, or -1
     ptrdiff_t attribute_index(const std::string& attr_name) const {
-        const entity* current = this;
-        ptrdiff_t index = -1;
-        attribute_by_name_cmp cmp(attr_name);
-        do {
-            if (index > -1) {
-                index += current->attributes().size();
-            } else {
-                std::vector<const attribute*>::const_iterator iter;
-                iter = std::find_if(current->attributes().begin(), current->attributes().end(), cmp);
-                if (iter != current->attributes().end()) {
-                    index = std::distance(current->attributes().begin(), iter);
-                }
-            }
-        } while ((current = current->supertype_) != 0);
-        return index;
+        const auto* p = find_attribute_(attr_name);
+        return p != nullptr ? (ptrdiff_t)p->second : -1;
+    }
+
+    /// Returns a handle to the attribute named attr_name, which evaluates to
+    /// false when there is no such attribute
+    attribute_handle attribute_handle_by_name(const std::string& attr_name) const {
+        const auto* p = find_attribute_(attr_name);
+        return p != nullptr ? attribute_handle(this, p->second) : attribute_handle();
     }
 
+    /// Returns the inverse attribute named attr_name, or nullptr
+    const inverse_attribute* inverse_attribute_by_name(const std::string& attr_name) const;
+
     const entity* supertype() const { return supertype_; }
 
     virtual const entity* as_entity() const { return this; }
@@ -0,0 +1,804 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+// Binary snapshots of parsed files. A snapshot consists of, in order:
+//
+//  - magic, format version, byte order mark, the size, modification time,
+//    sampled hash and full hash of the SPF source file and the highest
+//    instance name
+//  - the schema identifier
+//  - the string table, attribute values refer to strings by index
+//  - the attributes of the SPF header entities
+//  - the instance table: the total number of instances, then grouped by type
+//    the declaration index and number of instances, followed by the name and
+//    attribute count of every instance
+//  - the attribute values of every instance, each prefixed by the index of
+//    the storage_t alternative it holds
+//  - the GlobalId index, in key order
+//  - the inverse index, one record per reference in key order
+//
+// Values are stored in native byte order. Instance references are stored as
+// positions in the instance table so that no name lookups are necessary when
+// reading. SNAPSHOT_VERSION needs to be incremented whenever storage_t or the
+// layout above changes.
+
+#include "IfcFile.h"
+#include "IfcLogger.h"
+#include "IfcSpfStream.h"
+#include "utils.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace IfcParse;
+
+namespace {
+    const char SNAPSHOT_MAGIC[8] = {'I', 'F', 'C', 'S', 'N', 'A', 'P', '\0'};
+    const uint32_t SNAPSHOT_VERSION = 3;
+    const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+    // Marks an instance reference in an attribute value as either an entity
+    // instance in the file or an inline simple type instance, e.g. IFCLABEL('')
+    const uint8_t REFERENCE_ENTITY_INSTANCE = 0;
+    const uint8_t REFERENCE_SIMPLE_TYPE = 1;
+    const uint8_t REFERENCE_NULL = 2;
+
+    template <typename T, typename Array>
+    struct storage_tag;
+
+    template <typename T, typename... Ts>
+    struct storage_tag<T, VariantArray<Ts...>> : std::integral_constant<uint8_t, (uint8_t) ::impl::TypeIndex_v<T, Ts...>> {};
+
+    template <typename T>
+    constexpr uint8_t storage_tag_v = storage_tag<T, storage_t>::value;
+
+    FILE* open_file(const std::string& path, bool write) {
+#ifdef _MSC_VER
+        return _wfopen(IfcUtil::path::from_utf8(path).c_str(), write ? L"wb" : L"rb");
+#else
+        return fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+    }
+
+    // A non-cryptographic hash, four 64-bit lanes are mixed independently so
+    // that hashing runs at close to memory bandwidth.
+    class content_hash {
+      private:
+        static const uint64_t prime = 0x9E3779B97F4A7C15ULL;
+        uint64_t lanes_[4] = {prime, prime ^ 1, prime ^ 2, prime ^ 3};
+
+      public:
+        // The buffer is padded with zeros in place to a multiple of the lane
+        // width, so it needs to hold at least n rounded up to 32 bytes
+        void update(std::vector<char>& buffer, size_t n) {
+            const size_t padded = (n + 31) & ~(size_t)31;
+            std::fill(buffer.begin() + n, buffer.begin() + padded, 0);
+            for (size_t i = 0; i < padded; i += 32) {
+                for (size_t j = 0; j < 4; ++j) {
+                    uint64_t w;
+                    memcpy(&w, buffer.data() + i + j * 8, sizeof(w));
+                    lanes_[j] = (lanes_[j] ^ w) * prime;
+                    lanes_[j] ^= lanes_[j] >> 29;
+                }
+            }
+        }
+
+        uint64_t digest(uint64_t size) const {
+            uint64_t hash = size;
+            for (auto& l : lanes_) {
+                hash = (hash ^ l) * 0xBF58476D1CE4E5B9ULL;
+                hash ^= hash >> 31;
+            }
+            return hash;
+        }
+    };
+
+    // Hash over the entire file contents
+    bool hash_file(const std::string& path, uint64_t& size, uint64_t& hash) {
+        FILE* f = open_file(path, false);
+        if (f == nullptr) {
+            return false;
+        }
+
+        content_hash h;
+        std::vector<char> buffer(1 << 20);
+        size = 0;
+
+        size_t n;
+        while ((n = fread(buffer.data(), 1, buffer.size(), f)) > 0) {
+            h.update(buffer, n);
+            size += n;
+        }
+
+        const bool ok = !ferror(f);
+        fclose(f);
+
+        hash = h.digest(size);
+        return ok;
+    }
+
+    // Size, modification time and a hash over evenly spaced blocks of the
+    // file, which is cheap to obtain for large files. Changes that keep both
+    // the size and modification time, and that fall outside the sampled
+    // blocks, go unnoticed. Files smaller than the samples combined are hashed
+    // in full.
+    bool sample_file(const std::string& path, uint64_t& size, int64_t& mtime, uint64_t& hash) {
+        const size_t num_samples = 64;
+        const size_t sample_size = 1 << 14;
+
+        std::error_code ec;
+        const auto p = std::filesystem::u8path(path);
+        const auto last_write = std::filesystem::last_write_time(p, ec);
+        if (ec) {
+            return false;
+        }
+        mtime = (int64_t)last_write.time_since_epoch().count();
+
+        FILE* f = open_file(path, false);
+        if (f == nullptr) {
+            return false;
+        }
+
+        content_hash h;
+        std::vector<char> buffer(sample_size);
+        bool ok = true;
+
+        const uint64_t file_size = std::filesystem::file_size(p, ec);
+        if (ec) {
+            ok = false;
+        } else if (file_size <= num_samples * sample_size) {
+            size_t n;
+            while ((n = fread(buffer.data(), 1, buffer.size(), f)) > 0) {
+                h.update(buffer, n);
+            }
+        } else {
+            // The first and last block are always included, as headers and
+            // trailing instances are the most likely to be edited
+            const uint64_t stride = (file_size - sample_size) / (num_samples - 1);
+            for (size_t i = 0; i < num_samples && ok; ++i) {
+                const uint64_t offset = i == num_samples - 1 ? file_size - sample_size : i * stride;
+#ifdef _MSC_VER
+                ok = _fseeki64(f, (int64_t)offset, SEEK_SET) == 0;
+#else
+                ok = fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+                ok = ok && fread(buffer.data(), 1, sample_size, f) == sample_size;
+                if (ok) {
+                    h.update(buffer, sample_size);
+                }
+            }
+        }
+
+        ok = ok && !ferror(f);
+        fclose(f);
+
+        size = file_size;
+        hash = h.digest(size);
+        return ok;
+    }
+
+    class snapshot_writer {
+      private:
+        std::string& out_;
+        boost::unordered_map<std::string, uint32_t>& strings_;
+        const boost::unordered_map<const IfcUtil::IfcBaseClass*, uint32_t>& positions_;
+
+      public:
+        snapshot_writer(std::string& out, boost::unordered_map<std::string, uint32_t>& strings, const boost::unordered_map<const IfcUtil::IfcBaseClass*, uint32_t>& positions)
+            : out_(out)
+            , strings_(strings)
+            , positions_(positions)
+        {}
+
+        template <typename T>
+        void write(const T& t) {
+            out_.append((const char*)&t, sizeof(T));
+        }
+
+        template <typename T>
+        void write_array(const std::vector<T>& ts) {
+            write((uint32_t)ts.size());
+            out_.append((const char*)ts.data(), ts.size() * sizeof(T));
+        }
+
+        void write_string(const std::string& s) {
+            auto it = strings_.find(s);
+            if (it == strings_.end()) {
+                it = strings_.insert({s, (uint32_t)strings_.size()}).first;
+            }
+            write(it->second);
+        }
+
+        void write_bitset(const boost::dynamic_bitset<>& b) {
+            write((uint32_t)b.size());
+            std::string bytes((b.size() + 7) / 8, '\0');
+            for (size_t i = 0; i < b.size(); ++i) {
+                if (b[i]) {
+                    bytes[i / 8] |= (char)(1 << (i % 8));
+                }
+            }
+            out_ += bytes;
+        }
+
+        void write_instance(const IfcUtil::IfcBaseClass* inst) {
+            if (inst != nullptr && inst->declaration().as_entity() == nullptr) {
+                write(REFERENCE_SIMPLE_TYPE);
+                write((uint32_t)inst->declaration().index_in_schema());
+                write_attributes(inst->data().storage_);
+                return;
+            }
+            auto it = positions_.find(inst);
+            if (it == positions_.end()) {
+                write(REFERENCE_NULL);
+            } else {
+                write(REFERENCE_ENTITY_INSTANCE);
+                write(it->second);
+            }
+        }
+
+        template <typename It>
+        void write_instances(It begin, It end) {
+            write((uint32_t)std::distance(begin, end));
+            for (It it = begin; it != end; ++it) {
+                write_instance(*it);
+            }
+        }
+
+        void write_attributes(const storage_t& storage) {
+            write((uint8_t)storage.size());
+            const size_t count = storage.size();
+            for (size_t i = 0; i < count; ++i) {
+                write((uint8_t)storage.index(i));
+                storage.apply_visitor([this](const auto& v) {
+                    using U = std::decay_t<decltype(v)>;
+                    if constexpr (std::is_same_v<U, int> || std::is_same_v<U, double>) {
+                        write(v);
+                    } else if constexpr (std::is_same_v<U, bool>) {
+                        write((uint8_t)v);
+                    } else if constexpr (std::is_same_v<U, boost::logic::tribool>) {
+                        write((uint8_t)(boost::logic::indeterminate(v) ? 2 : (v ? 1 : 0)));
+                    } else if constexpr (std::is_same_v<U, std::string>) {
+                        write_string(v);
+                    } else if constexpr (std::is_same_v<U, boost::dynamic_bitset<>>) {
+                        write_bitset(v);
+                    } else if constexpr (std::is_same_v<U, EnumerationReference>) {
+                        write((uint32_t)v.enumeration()->index_in_schema());
+                        write((uint32_t)v.index());
+                    } else if constexpr (std::is_same_v<U, IfcUtil::IfcBaseClass*>) {
+                        write_instance(v);
+                    } else if constexpr (std::is_same_v<U, std::vector<int>> || std::is_same_v<U, std::vector<double>>) {
+                        write_array(v);
+                    } else if constexpr (std::is_same_v<U, std::vector<std::string>>) {
+                        write((uint32_t)v.size());
+                        for (const auto& s : v) {
+                            write_string(s);
+                        }
+                    } else if constexpr (std::is_same_v<U, std::vector<boost::dynamic_bitset<>>>) {
+                        write((uint32_t)v.size());
+                        for (const auto& b : v) {
+                            write_bitset(b);
+                        }
+                    } else if constexpr (std::is_same_v<U, aggregate_of_instance::ptr>) {
+                        if (v) {
+                            write_instances(v->begin(), v->end());
+                        } else {
+                            write((uint32_t)0);
+                        }
+                    } else if constexpr (std::is_same_v<U, flat_aggregate_of_aggregate<int>> || std::is_same_v<U, flat_aggregate_of_aggregate<double>>) {
+                        // Written as a list of arrays, the same as a vector of vectors
+                        write((uint32_t)v.size());
+                        for (size_t j = 0; j < v.size(); ++j) {
+                            auto w = v[j];
+                            write((uint32_t)w.size());
+                            out_.append((const char*)w.data(), w.size() * sizeof(typename U::value_type));
+                        }
+                    } else if constexpr (std::is_same_v<U, aggregate_of_aggregate_of_instance::ptr>) {
+                        write((uint32_t)(v ? v->size() : 0));
+                        if (v) {
+                            for (auto it = v->begin(); it != v->end(); ++it) {
+                                write_instances(it->begin(), it->end());
+                            }
+                        }
+                    }
+                    // Blank, Derived and the empty aggregates are fully described by their tag
+                }, i);
+            }
+        }
+    };
+
+    class snapshot_reader {
+      private:
+        const char* ptr_;
+        const char* end_;
+        IfcFile* file_;
+        // Strings refer to the snapshot buffer and are only copied into attribute values
+        std::vector<std::pair<const char*, uint32_t>> strings_;
+        const std::vector<IfcUtil::IfcBaseClass*>* instances_;
+
+      public:
+        snapshot_reader(const char* data, size_t length)
+            : ptr_(data)
+            , end_(data + length)
+            , file_(nullptr)
+            , instances_(nullptr)
+        {}
+
+        void context(IfcFile* file, const std::vector<IfcUtil::IfcBaseClass*>* instances) {
+            file_ = file;
+            instances_ = instances;
+        }
+
+        const char* bytes(size_t n) {
+            if ((size_t)(end_ - ptr_) < n) {
+                throw IfcException("Unexpected end of snapshot");
+            }
+            const char* p = ptr_;
+            ptr_ += n;
+            return p;
+        }
+
+        template <typename T>
+        T read() {
+            T t;
+            memcpy(&t, bytes(sizeof(T)), sizeof(T));
+            return t;
+        }
+
+        template <typename T>
+        std::vector<T> read_array() {
+            const uint32_t n = read<uint32_t>();
+            std::vector<T> ts(n);
+            if (n) {
+                memcpy(ts.data(), bytes(n * sizeof(T)), n * sizeof(T));
+            }
+            return ts;
+        }
+
+        std::string read_raw_string() {
+            const uint32_t n = read<uint32_t>();
+            return std::string(bytes(n), n);
+        }
+
+        void read_string_table() {
+            strings_.resize(read<uint32_t>());
+            for (auto& s : strings_) {
+                s.second = read<uint32_t>();
+                s.first = bytes(s.second);
+            }
+        }
+
+        std::string read_string() {
+            const auto& s = strings_.at(read<uint32_t>());
+            return std::string(s.first, s.second);
+        }
+
+        boost::dynamic_bitset<> read_bitset() {
+            boost::dynamic_bitset<> b(read<uint32_t>());
+            const char* bits = bytes((b.size() + 7) / 8);
+            for (size_t i = 0; i < b.size(); ++i) {
+                b[i] = (bits[i / 8] >> (i % 8)) & 1;
+            }
+            return b;
+        }
+
+        IfcUtil::IfcBaseClass* read_instance() {
+            const uint8_t kind = read<uint8_t>();
+            if (kind == REFERENCE_ENTITY_INSTANCE) {
+                return instances_->at(read<uint32_t>());
+            } else if (kind == REFERENCE_SIMPLE_TYPE) {
+                const auto* decl = file_->schema()->declarations().at(read<uint32_t>());
+                storage_t storage = read_attributes();
+                auto* inst = file_->schema()->instantiate(decl, IfcEntityInstanceData(std::move(storage)));
+                inst->file_ = file_;
+                return inst;
+            } else if (kind == REFERENCE_NULL) {
+                return nullptr;
+            }
+            throw IfcException("Invalid instance reference in snapshot");
+        }
+
+        std::vector<IfcUtil::IfcBaseClass*> read_instances() {
+            std::vector<IfcUtil::IfcBaseClass*> insts(read<uint32_t>());
+            for (auto& inst : insts) {
+                inst = read_instance();
+            }
+            return insts;
+        }
+
+        storage_t read_attributes() {
+            storage_t storage(read<uint8_t>());
+            read_attributes(storage);
+            return storage;
+        }
+
+        void read_attributes(storage_t& storage) {
+            const size_t count = storage.size();
+            for (size_t i = 0; i < count; ++i) {
+                const uint8_t tag = read<uint8_t>();
+                switch (tag) {
+                case storage_tag_v<Blank>:
+                    break;
+                case storage_tag_v<Derived>:
+                    storage.set(i, Derived{});
+                    break;
+                case storage_tag_v<int>:
+                    storage.set(i, read<int>());
+                    break;
+                case storage_tag_v<bool>:
+                    storage.set(i, read<uint8_t>() != 0);
+                    break;
+                case storage_tag_v<boost::logic::tribool>: {
+                    const uint8_t v = read<uint8_t>();
+                    storage.set(i, v == 2 ? boost::logic::tribool(boost::logic::indeterminate) : boost::logic::tribool(v == 1));
+                    break;
+                }
+                case storage_tag_v<double>:
+                    storage.set(i, read<double>());
+                    break;
+                case storage_tag_v<std::string>:
+                    storage.set(i, read_string());
+                    break;
+                case storage_tag_v<boost::dynamic_bitset<>>:
+                    storage.set(i, read_bitset());
+                    break;
+                case storage_tag_v<EnumerationReference>: {
+                    const auto* decl = file_->schema()->declarations().at(read<uint32_t>())->as_enumeration_type();
+                    const uint32_t index = read<uint32_t>();
+                    if (decl == nullptr) {
+                        throw IfcException("Invalid enumeration in snapshot");
+                    }
+                    storage.set(i, EnumerationReference(decl, index));
+                    break;
+                }
+                case storage_tag_v<IfcUtil::IfcBaseClass*>:
+                    if (auto* inst = read_instance()) {
+                        storage.set(i, inst);
+                    }
+                    break;
+                case storage_tag_v<empty_aggregate_t>:
+                    storage.set(i, empty_aggregate_t{});
+                    break;
+                case storage_tag_v<std::vector<int>>:
+                    storage.set(i, read_array<int>());
+                    break;
+                case storage_tag_v<std::vector<double>>:
+                    storage.set(i, read_array<double>());
+                    break;
+                case storage_tag_v<std::vector<std::string>>: {
+                    std::vector<std::string> v(read<uint32_t>());
+                    for (auto& s : v) {
+                        s = read_string();
+                    }
+                    storage.set(i, std::move(v));
+                    break;
+                }
+                case storage_tag_v<std::vector<boost::dynamic_bitset<>>>: {
+                    std::vector<boost::dynamic_bitset<>> v(read<uint32_t>());
+                    for (auto& b : v) {
+                        b = read_bitset();
+                    }
+                    storage.set(i, std::move(v));
+                    break;
+                }
+                case storage_tag_v<aggregate_of_instance::ptr>: {
+                    aggregate_of_instance::ptr v = IfcParse::make_shared_in_arena<aggregate_of_instance>();
+                    const uint32_t n = read<uint32_t>();
+                    v->reserve(n);
+                    for (uint32_t j = 0; j < n; ++j) {
+                        if (auto* inst = read_instance()) {
+                            v->push(inst);
+                        }
+                    }
+                    storage.set(i, std::move(v));
+                    break;
+                }
+                case storage_tag_v<empty_aggregate_of_aggregate_t>:
+                    storage.set(i, empty_aggregate_of_aggregate_t{});
+                    break;
+                case storage_tag_v<flat_aggregate_of_aggregate<int>>: {
+                    const uint32_t n = read<uint32_t>();
+                    std::vector<int> values;
+                    std::vector<size_t> offsets;
+                    offsets.reserve(n + 1);
+                    offsets.push_back(0);
+                    for (uint32_t j = 0; j < n; ++j) {
+                        const uint32_t m = read<uint32_t>();
+                        const size_t k = values.size();
+                        values.resize(k + m);
+                        if (m) {
+                            memcpy(values.data() + k, bytes(m * sizeof(int)), m * sizeof(int));
+                        }
+                        offsets.push_back(values.size());
+                    }
+                    storage.set(i, flat_aggregate_of_aggregate<int>(std::move(values), std::move(offsets)));
+                    break;
+                }
+                case storage_tag_v<flat_aggregate_of_aggregate<double>>: {
+                    const uint32_t n = read<uint32_t>();
+                    std::vector<double> values;
+                    std::vector<size_t> offsets;
+                    offsets.reserve(n + 1);
+                    offsets.push_back(0);
+                    for (uint32_t j = 0; j < n; ++j) {
+                        const uint32_t m = read<uint32_t>();
+                        const size_t k = values.size();
+                        values.resize(k + m);
+                        if (m) {
+                            memcpy(values.data() + k, bytes(m * sizeof(double)), m * sizeof(double));
+                        }
+                        offsets.push_back(values.size());
+                    }
+                    storage.set(i, flat_aggregate_of_aggregate<double>(std::move(values), std::move(offsets)));
+                    break;
+                }
+                case storage_tag_v<aggregate_of_aggregate_of_instance::ptr>: {
+                    aggregate_of_aggregate_of_instance::ptr v = IfcParse::make_shared_in_arena<aggregate_of_aggregate_of_instance>();
+                    const uint32_t n = read<uint32_t>();
+                    for (uint32_t j = 0; j < n; ++j) {
+                        std::vector<IfcUtil::IfcBaseClass*> inner = read_instances();
+                        inner.erase(std::remove(inner.begin(), inner.end(), nullptr), inner.end());
+                        v->push(inner);
+                    }
+                    storage.set(i, std::move(v));
+                    break;
+                }
+                default:
+                    throw IfcException("Invalid attribute type in snapshot");
+                }
+            }
+        }
+    };
+}
+
+bool IfcFile::write_snapshot(const std::string& path, const std::string& source_path) {
+    materialize_all_();
+
+    uint64_t source_size, source_hash, sampled_size, sampled_hash;
+    int64_t source_mtime;
+    if (!sample_file(source_path, sampled_size, source_mtime, sampled_hash) || !hash_file(source_path, source_size, source_hash) || sampled_size != source_size) {
+        Logger::Error("Unable to read snapshot source " + source_path);
+        return false;
+    }
+
+    // Instances are grouped by type so that the order of instances_by_type()
+    // is retained when reading the snapshot
+    std::vector<IfcUtil::IfcBaseClass*> instances;
+    instances.reserve(byid_.size());
+    for (const auto& p : bytype_excl_) {
+        instances.insert(instances.end(), p.second->begin(), p.second->end());
+    }
+
+    boost::unordered_map<const IfcUtil::IfcBaseClass*, uint32_t> positions;
+    positions.reserve(instances.size());
+    for (uint32_t i = 0; i < instances.size(); ++i) {
+        positions[instances[i]] = i;
+    }
+
+    boost::unordered_map<std::string, uint32_t> strings;
+    std::string body;
+    snapshot_writer w(body, strings, positions);
+
+    w.write_attributes(_header.file_description().data_.storage_);
+    w.write_attributes(_header.file_name().data_.storage_);
+    w.write_attributes(_header.file_schema().data_.storage_);
+
+    w.write((uint32_t)instances.size());
+    w.write((uint32_t)bytype_excl_.size());
+    for (const auto& p : bytype_excl_) {
+        w.write((uint32_t)p.first->index_in_schema());
+        w.write((uint32_t)p.second->size());
+        for (const auto* inst : *p.second) {
+            w.write((uint32_t)inst->id());
+            w.write((uint8_t)inst->data().size());
+        }
+    }
+    for (const auto* inst : instances) {
+        w.write_attributes(inst->data().storage_);
+    }
+
+    // Entries are written in instance order, as the order of the GlobalId
+    // index itself depends on the sequence of insertions
+    std::vector<std::pair<uint32_t, std::string>> guids;
+    guids.reserve(byguid_.size());
+    byguid_.visit([&positions, &guids](const std::string& guid, IfcUtil::IfcBaseClass* inst) {
+        auto it = positions.find(inst);
+        if (it != positions.end()) {
+            guids.push_back({it->second, guid});
+        }
+    });
+    std::sort(guids.begin(), guids.end());
+    w.write((uint32_t)guids.size());
+    for (const auto& p : guids) {
+        w.write_string(p.second);
+        w.write(p.first);
+    }
+
+    uint64_t num_references = 0;
+    byref_excl_.visit([&num_references](const inverse_attr_record&, const int* begin, const int* end) {
+        num_references += end - begin;
+    });
+    w.write(num_references);
+    byref_excl_.visit([&w](const inverse_attr_record& key, const int* begin, const int* end) {
+        for (auto it = begin; it != end; ++it) {
+            w.write((int32_t)std::get<INSTANCE_ID>(key));
+            w.write((int16_t)std::get<INSTANCE_TYPE>(key));
+            w.write((int16_t)std::get<ATTRIBUTE_INDEX>(key));
+            w.write((int32_t)*it);
+        }
+    });
+
+    std::string head;
+    snapshot_writer h(head, strings, positions);
+    head.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    h.write(SNAPSHOT_VERSION);
+    h.write(SNAPSHOT_BYTE_ORDER);
+    h.write(source_size);
+    h.write(source_mtime);
+    h.write(sampled_hash);
+    h.write(source_hash);
+    h.write((uint32_t)MaxId);
+    h.write((uint32_t)schema_->name().size());
+    head += schema_->name();
+
+    std::vector<const std::string*> string_table(strings.size());
+    for (const auto& p : strings) {
+        string_table[p.second] = &p.first;
+    }
+    h.write((uint32_t)string_table.size());
+    for (const auto* s : string_table) {
+        h.write((uint32_t)s->size());
+        head += *s;
+    }
+
+    // Written to a temporary file first so that readers never observe a partial snapshot
+    const std::string temp_path = path + ".tmp";
+    FILE* f = open_file(temp_path, true);
+    if (f == nullptr) {
+        Logger::Error("Unable to write snapshot " + path);
+        return false;
+    }
+    const bool written = fwrite(head.data(), 1, head.size(), f) == head.size() && fwrite(body.data(), 1, body.size(), f) == body.size();
+    const bool closed = fclose(f) == 0;
+    if (!written || !closed || !IfcUtil::path::rename_file(temp_path, path)) {
+        IfcUtil::path::delete_file(temp_path);
+        Logger::Error("Unable to write snapshot " + path);
+        return false;
+    }
+    return true;
+}
+
+IfcFile* IfcFile::read_snapshot(const std::string& path, const std::string& source_path, bool verify_contents) {
+#ifdef USE_MMAP
+    IfcSpfStream stream(path, true);
+#else
+    IfcSpfStream stream(path);
+#endif
+    if (!stream.valid) {
+        return nullptr;
+    }
+
+    std::unique_ptr<IfcFile> file;
+
+    try {
+        snapshot_reader r(stream.data(), stream.length());
+
+        if (memcmp(r.bytes(sizeof(SNAPSHOT_MAGIC)), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+            r.read<uint32_t>() != SNAPSHOT_VERSION ||
+            r.read<uint32_t>() != SNAPSHOT_BYTE_ORDER)
+        {
+            Logger::Notice("Snapshot " + path + " has an incompatible format");
+            return nullptr;
+        }
+
+        const uint64_t recorded_size = r.read<uint64_t>();
+        const int64_t recorded_mtime = r.read<int64_t>();
+        const uint64_t recorded_sampled_hash = r.read<uint64_t>();
+        const uint64_t recorded_hash = r.read<uint64_t>();
+        uint64_t source_size, source_hash;
+        int64_t source_mtime;
+        bool outdated = !sample_file(source_path, source_size, source_mtime, source_hash) ||
+            source_size != recorded_size || source_mtime != recorded_mtime || source_hash != recorded_sampled_hash;
+        if (!outdated && verify_contents) {
+            outdated = !hash_file(source_path, source_size, source_hash) || source_size != recorded_size || source_hash != recorded_hash;
+        }
+        if (outdated) {
+            Logger::Notice("Snapshot " + path + " is outdated");
+            return nullptr;
+        }
+
+        const uint32_t max_id = r.read<uint32_t>();
+        file.reset(new IfcFile(schema_by_name(r.read_raw_string())));
+        arena::scope scope(file->arena_);
+
+        r.read_string_table();
+
+        std::vector<IfcUtil::IfcBaseClass*> instances;
+        r.context(file.get(), &instances);
+
+        auto& header = file->_header;
+        header.file_description().data_.storage_ = r.read_attributes();
+        header.file_name().data_.storage_ = r.read_attributes();
+        header.file_schema().data_.storage_ = r.read_attributes();
+
+        // Instances are allocated and indexed before reading attribute values,
+        // so that references, including forward references, can be assigned directly
+        const auto& declarations = file->schema_->declarations();
+        const uint32_t total_instances = r.read<uint32_t>();
+        instances.reserve(total_instances);
+        file->byid_.reserve(total_instances);
+        const uint32_t num_types = r.read<uint32_t>();
+        for (uint32_t i = 0; i < num_types; ++i) {
+            const auto* decl = declarations.at(r.read<uint32_t>());
+            const uint32_t num_instances = r.read<uint32_t>();
+            aggregate_of_instance::ptr& of_type = file->bytype_excl_[decl];
+            of_type.reset(new aggregate_of_instance);
+            of_type->reserve(num_instances);
+            for (uint32_t j = 0; j < num_instances; ++j) {
+                const uint32_t name = r.read<uint32_t>();
+                auto* inst = file->schema_->instantiate(decl, IfcEntityInstanceData(storage_t(r.read<uint8_t>())));
+                inst->file_ = file.get();
+                inst->id_ = name;
+                instances.push_back(inst);
+                of_type->push(inst);
+                file->byid_[name] = inst;
+                file->MaxId = (std::max)(file->MaxId, name);
+            }
+        }
+
+        for (auto* inst : instances) {
+            if (r.read<uint8_t>() != inst->data().size()) {
+                throw IfcException("Attribute count mismatch in snapshot");
+            }
+            r.read_attributes(inst->data().storage_);
+        }
+
+        const uint32_t num_guids = r.read<uint32_t>();
+        file->byguid_.reserve(num_guids);
+        for (uint32_t i = 0; i < num_guids; ++i) {
+            const std::string guid = r.read_string();
+            file->byguid_.insert(guid, instances.at(r.read<uint32_t>()));
+        }
+
+        const uint64_t num_references = r.read<uint64_t>();
+        for (uint64_t i = 0; i < num_references; ++i) {
+            const int32_t id = r.read<int32_t>();
+            const int16_t type = r.read<int16_t>();
+            const int16_t attribute_index = r.read<int16_t>();
+            file->byref_excl_.append({id, type, attribute_index}, r.read<int32_t>());
+        }
+        // References are written in key order, so they do not need to be sorted
+        file->byref_excl_.build();
+
+        file->MaxId = (std::max)(file->MaxId, max_id);
+    } catch (const std::exception& e) {
+        Logger::Error("Unable to read snapshot " + path + ": " + e.what());
+        return nullptr;
+    }
+
+    return file.release();
+}
@@ -33,6 +33,8 @@ class IFC_PARSE_API HeaderEntity {
     
     HeaderEntity(const HeaderEntity&);            //N/A
     HeaderEntity& operator=(const HeaderEntity&); //N/A
+
+    friend class IfcFile;
   protected:
       IfcEntityInstanceData data_;
 
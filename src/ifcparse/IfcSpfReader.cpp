@@ -0,0 +1,454 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "IfcSpfReader.h"
+
+#include "IfcLogger.h"
+#include "spf_statement.h"
+#include "utils.h"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+using namespace IfcParse;
+using namespace IfcParse::spf_statement;
+
+// Defined in IfcParse.cpp, initializes the locale for parsing real numbers
+void init_locale();
+
+namespace {
+    // Size of the part of the file held in memory. The window grows when a
+    // single statement does not fit.
+    const size_t window_size = 4 * 1024 * 1024;
+
+    // The simple type instances created for values in select attributes are
+    // owned by the instance in which they occur
+    void collect_inline_instances(const parse_context& context, std::vector<IfcUtil::IfcBaseClass*>& instances) {
+        for (const auto& t : context.tokens_) {
+            if (auto* inst = boost::get<IfcUtil::IfcBaseClass*>(&t)) {
+                instances.push_back(*inst);
+            } else if (auto* nested = boost::get<parse_context*>(&t)) {
+                collect_inline_instances(**nested, instances);
+            }
+        }
+    }
+}
+
+IfcSpfReader::instance::~instance() {
+    clear_();
+}
+
+void IfcSpfReader::instance::clear_() {
+    delete parsed_;
+    parsed_ = nullptr;
+    for (auto* inst : inline_instances_) {
+        delete inst;
+    }
+    inline_instances_.clear();
+    references_.clear();
+}
+
+IfcUtil::IfcBaseClass* IfcSpfReader::instance::get() {
+    if (parsed_ == nullptr && !parsing_) {
+        reader_->parse_(*this);
+    }
+    return parsed_;
+}
+
+AttributeValue IfcSpfReader::instance::get_attribute_value(size_t index) {
+    auto* inst = get();
+    if (inst == nullptr) {
+        throw IfcException("Instance #" + std::to_string(id_) + " could not be decoded");
+    }
+    return inst->data().get_attribute_value(index);
+}
+
+const std::vector<std::pair<size_t, unsigned>>& IfcSpfReader::instance::references() {
+    get();
+    return references_;
+}
+
+IfcSpfReader::IfcSpfReader(const std::string& path)
+    : owned_input_(new std::ifstream(IfcUtil::path::from_utf8(path).c_str(), std::ios::binary))
+    , input_(owned_input_.get())
+{
+    initialize_();
+}
+
+IfcSpfReader::IfcSpfReader(std::istream& stream)
+    : input_(&stream)
+{
+    initialize_();
+}
+
+IfcSpfReader::~IfcSpfReader() {
+    // Decoded instances are deleted without following references between them
+    current_.reset();
+    cache_.clear();
+}
+
+void IfcSpfReader::initialize_() {
+    init_locale();
+
+    context_.reset(new IfcFile());
+
+    if (!*input_ || !fill_(0)) {
+        good_ = file_open_status::READ_ERROR;
+        return;
+    }
+
+    read_header_();
+}
+
+bool IfcSpfReader::fill_(size_t keep_from) {
+    const size_t keep = window_ ? window_->length() - keep_from : 0;
+    // Leaves room for at least as much new data as is retained
+    const size_t capacity = (std::max)(window_size, 2 * keep);
+    char* buffer = new char[capacity];
+    if (keep != 0) {
+        memcpy(buffer, window_->data() + keep_from, keep);
+    }
+    input_->read(buffer + keep, capacity - keep);
+    const size_t num_read = (size_t)input_->gcount();
+    if (num_read < capacity - keep) {
+        input_exhausted_ = true;
+    }
+    if (window_) {
+        window_begin_ += keep_from;
+        cursor_ -= keep_from;
+    }
+    // The stream takes ownership of the buffer
+    window_.reset(new IfcSpfStream(buffer, keep + num_read));
+    return num_read != 0;
+}
+
+void IfcSpfReader::read_header_() {
+    // The header is read by the lexer of the context file and needs to fit in
+    // the initial window
+    IfcSpfLexer lexer(window_.get(), context_.get());
+    context_->tokens = &lexer;
+    context_->stream = window_.get();
+    context_->header().file(context_.get());
+    const bool header_read = context_->header().tryRead();
+    cursor_ = window_->Tell();
+    context_->tokens = nullptr;
+    context_->stream = nullptr;
+
+    if (!header_read) {
+        good_ = file_open_status::NO_HEADER;
+        return;
+    }
+
+    std::vector<std::string> schemas;
+    try {
+        schemas = context_->header().file_schema().schema_identifiers();
+    } catch (...) {
+        // Purposely empty catch block
+    }
+
+    const IfcParse::schema_definition* schema = nullptr;
+    if (schemas.size() == 1) {
+        try {
+            schema = IfcParse::schema_by_name(schemas.front());
+        } catch (const IfcParse::IfcException& e) {
+            Logger::Error(e);
+        }
+    }
+
+    if (schema == nullptr) {
+        Logger::Message(Logger::LOG_ERROR, "No support for file schema encountered (" + boost::algorithm::join(schemas, ", ") + ")");
+        good_ = file_open_status::UNSUPPORTED_SCHEMA;
+        return;
+    }
+
+    context_->schema_ = schema;
+    context_->ifcroot_type_ = schema->declaration_by_name("IfcRoot");
+}
+
+size_t IfcSpfReader::read(const callback& fn) {
+    size_t num_visited = 0;
+    stopped_ = false;
+
+    if (!good_) {
+        return num_visited;
+    }
+
+    std::string keyword;
+
+    while (!stopped_) {
+        const char* data = window_->data();
+        const size_t length = window_->length();
+
+        size_t begin = cursor_;
+        size_t end = npos;
+        const bool skipped = skip_whitespace_and_comments(data, length, begin);
+        if (skipped && begin < length) {
+            end = find_statement_end(data, length, begin);
+        }
+
+        if (end == npos) {
+            if (!input_exhausted_) {
+                fill_(cursor_);
+                continue;
+            }
+            if (!skipped || begin < length) {
+                Logger::Message(Logger::LOG_ERROR, "Unexpected end of file at offset " + std::to_string(window_begin_ + begin));
+            }
+            break;
+        }
+
+        cursor_ = end;
+
+        if (data[begin] != '#') {
+            // Section delimiters and other non-instance statements
+            continue;
+        }
+
+        size_t offset = begin + 1;
+        unsigned name = 0;
+        size_t num_digits = 0;
+        while (offset < end && std::isdigit(static_cast<unsigned char>(data[offset]))) {
+            name = name * 10 + (unsigned)(data[offset] - '0');
+            ++num_digits;
+            ++offset;
+        }
+        while (offset < end && is_whitespace(data[offset])) {
+            ++offset;
+        }
+        if (num_digits == 0 || offset >= end || data[offset] != '=') {
+            Logger::Message(Logger::LOG_ERROR, "Unexpected token at offset " + std::to_string(window_begin_ + begin));
+            continue;
+        }
+        ++offset;
+        while (offset < end && is_whitespace(data[offset])) {
+            ++offset;
+        }
+
+        const size_t keyword_offset = offset;
+        keyword.clear();
+        while (offset < end && (std::isalnum(static_cast<unsigned char>(data[offset])) || data[offset] == '_')) {
+            keyword.push_back(data[offset++]);
+        }
+
+        if (keyword.empty()) {
+            // Complex entity instances are not supported, as with regular parsing
+            continue;
+        }
+
+        const IfcParse::declaration* decl;
+        try {
+            decl = schema()->declaration_by_name(keyword);
+        } catch (const IfcException& ex) {
+            Logger::Message(Logger::LOG_ERROR, std::string(ex.what()) + " at offset " + std::to_string(window_begin_ + keyword_offset));
+            continue;
+        }
+
+        if (decl->as_entity() == nullptr) {
+            Logger::Message(Logger::LOG_ERROR, "Non entity type " + decl->name() + " at offset " + std::to_string(window_begin_ + keyword_offset));
+            continue;
+        }
+
+        current_.reset(new instance(this, name, decl->as_entity(), keyword_offset));
+        fn(*current_);
+        ++num_visited;
+
+        if (cache_size_ == 0) {
+            discard_(*current_);
+            current_.reset();
+            continue;
+        }
+
+        // The statement is copied, as the window moves on
+        const size_t statement_length = end - begin;
+        char* statement = new char[statement_length];
+        memcpy(statement, data + begin, statement_length);
+        current_->stream_.reset(new IfcSpfStream(statement, statement_length));
+        current_->offset_ -= begin;
+
+        // A later instance with the same name replaces the earlier one
+        auto it = cache_by_id_.find(name);
+        if (it != cache_by_id_.end()) {
+            evict_(it->second);
+        }
+
+        cache_.push_front(std::move(current_));
+        cache_.front()->position_ = cache_.begin();
+        cache_by_id_[name] = cache_.begin();
+
+        while (cache_.size() > cache_size_) {
+            evict_(std::prev(cache_.end()));
+        }
+    }
+
+    return num_visited;
+}
+
+void IfcSpfReader::cache_size(size_t n) {
+    cache_size_ = n;
+    while (cache_.size() > cache_size_) {
+        evict_(std::prev(cache_.end()));
+    }
+}
+
+IfcUtil::IfcBaseClass* IfcSpfReader::instance_by_id(unsigned id) {
+    auto* inst = find_(id);
+    return inst == nullptr ? nullptr : inst->get();
+}
+
+IfcSpfReader::instance* IfcSpfReader::find_(unsigned id) {
+    if (current_ && current_->id_ == id) {
+        return current_.get();
+    }
+    auto it = cache_by_id_.find(id);
+    if (it == cache_by_id_.end()) {
+        return nullptr;
+    }
+    // Marks the instance as most recently used
+    cache_.splice(cache_.begin(), cache_, it->second);
+    return cache_.front().get();
+}
+
+IfcUtil::IfcBaseClass* IfcSpfReader::parse_(instance& inst) {
+    IfcSpfStream* stream = inst.stream_ ? inst.stream_.get() : window_.get();
+    IfcSpfLexer lexer(stream, context_.get());
+    parse_context context;
+    unresolved_references references;
+
+    inst.parsing_ = true;
+
+    try {
+        stream->Seek(inst.offset_);
+        // Entity type keyword and opening parenthesis
+        lexer.Next();
+        lexer.Next();
+        context_->load_(&lexer, byref_, references, inst.id_, inst.declaration_, context, -1);
+        inst.parsed_ = schema()->instantiate(inst.declaration_, context.construct((int)inst.id_, references, inst.declaration_, boost::none));
+        inst.parsed_->id_ = inst.id_;
+    } catch (const IfcException& e) {
+        Logger::Message(Logger::LOG_ERROR, std::string(e.what()) + " in instance #" + std::to_string(inst.id_));
+    }
+
+    byref_.clear();
+    collect_inline_instances(context, inst.inline_instances_);
+
+    if (inst.parsed_ != nullptr) {
+        resolve_(inst, references);
+    }
+
+    inst.parsing_ = false;
+    return inst.parsed_;
+}
+
+void IfcSpfReader::resolve_(instance& inst, unresolved_references& references) {
+    std::vector<instance*> targets;
+
+    for (const auto& p : references) {
+        const size_t index = p.first.index_;
+        bool resolved = true;
+        targets.clear();
+
+        auto lookup = [this, &inst, &targets, &resolved, index](const reference_or_simple_type& v) -> IfcUtil::IfcBaseClass* {
+            if (auto* simple_type_instance = boost::get<IfcUtil::IfcBaseClass*>(&v)) {
+                return *simple_type_instance;
+            }
+            const unsigned name = (unsigned)boost::get<int>(v);
+            inst.references_.emplace_back(index, name);
+            instance* target = find_(name);
+            IfcUtil::IfcBaseClass* result = nullptr;
+            if (target != nullptr && target != &inst) {
+                result = target->get();
+            }
+            if (result == nullptr) {
+                resolved = false;
+            } else {
+                targets.push_back(target);
+            }
+            return result;
+        };
+
+        auto& storage = inst.parsed_->data().storage_;
+
+        // Attributes are only assigned when all references in them are resolved
+        if (auto* v = boost::get<reference_or_simple_type>(&p.second)) {
+            auto* referenced = lookup(*v);
+            if (resolved) {
+                storage.set(index, referenced);
+            }
+        } else if (auto* v = boost::get<std::vector<reference_or_simple_type>>(&p.second)) {
+            auto instances = boost::make_shared<aggregate_of_instance>();
+            instances->reserve(v->size());
+            for (const auto& vi : *v) {
+                instances->push(lookup(vi));
+            }
+            if (resolved) {
+                storage.set(index, instances);
+            }
+        } else if (auto* v = boost::get<std::vector<std::vector<reference_or_simple_type>>>(&p.second)) {
+            auto instances = boost::make_shared<aggregate_of_aggregate_of_instance>();
+            for (const auto& vi : *v) {
+                std::vector<IfcUtil::IfcBaseClass*> inner;
+                inner.reserve(vi.size());
+                for (const auto& vii : vi) {
+                    inner.push_back(lookup(vii));
+                }
+                instances->push(inner);
+            }
+            if (resolved) {
+                storage.set(index, instances);
+            }
+        }
+
+        if (resolved) {
+            for (auto* target : targets) {
+                inst.targets_.push_back(target);
+                target->sources_.push_back(&inst);
+            }
+        }
+    }
+}
+
+void IfcSpfReader::unparse_(instance& inst) {
+    for (auto* target : inst.targets_) {
+        auto& sources = target->sources_;
+        sources.erase(std::remove(sources.begin(), sources.end(), &inst), sources.end());
+    }
+    inst.targets_.clear();
+    inst.clear_();
+}
+
+void IfcSpfReader::discard_(instance& inst) {
+    // Instances referring to this instance are decoded again when needed
+    std::vector<instance*> sources;
+    sources.swap(inst.sources_);
+    for (auto* source : sources) {
+        unparse_(*source);
+    }
+    unparse_(inst);
+}
+
+void IfcSpfReader::evict_(cache_t::iterator it) {
+    discard_(**it);
+    cache_by_id_.erase((*it)->id_);
+    cache_.erase(it);
+}
@@ -0,0 +1,197 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Reads the instances of an IFC-SPF file one by one, in file order, without    *
+ * building an IfcFile and with memory use independent of the file size         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef IFCSPFREADER_H
+#define IFCSPFREADER_H
+
+#include "ifc_parse_api.h"
+#include "IfcFile.h"
+
+#include <functional>
+#include <istream>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace IfcParse {
+
+/// Streaming reader for the data section of IFC-SPF files, for applications
+/// that visit every instance once, such as property extraction or quantity
+/// take-off on files that do not fit in memory.
+///
+/// The file is read through a window of a few megabytes. For every entity
+/// instance a callback is invoked with its name and declaration, which are
+/// known without decoding the attributes. The attributes are only decoded
+/// when requested with instance::get().
+///
+/// References can only be resolved to instances that are still in memory.
+/// When cache_size() is non-zero, the reader retains that many recently
+/// visited instances, so that references to instances defined shortly before
+/// the referring instance, which is how most applications write files, are
+/// resolved. References to other instances, such as forward references, are
+/// left unset and are available by name from instance::references().
+///
+/// Instances obtained from the reader do not belong to a file, so inverse
+/// attributes are not available and the instances should not be modified.
+class IFC_PARSE_API IfcSpfReader {
+  public:
+    /// An entity instance in the data section of the file being read
+    class IFC_PARSE_API instance {
+      private:
+        friend class IfcSpfReader;
+
+        IfcSpfReader* reader_;
+        unsigned id_;
+        const IfcParse::entity* declaration_;
+
+        // The statement is read from the window of the reader, until the
+        // instance is retained in the cache and a copy is stored in stream_
+        std::unique_ptr<IfcSpfStream> stream_;
+        // Offset of the entity type keyword in the statement
+        size_t offset_;
+
+        IfcUtil::IfcBaseClass* parsed_ = nullptr;
+        bool parsing_ = false;
+        // Simple type instances created for values in select attributes
+        std::vector<IfcUtil::IfcBaseClass*> inline_instances_;
+        std::vector<std::pair<size_t, unsigned>> references_;
+
+        // Cached instances that the parsed attributes of this instance refer
+        // to, and the instances that refer to this instance in turn
+        std::vector<instance*> targets_;
+        std::vector<instance*> sources_;
+
+        std::list<std::unique_ptr<instance>>::iterator position_;
+
+        instance(IfcSpfReader* reader, unsigned id, const IfcParse::entity* declaration, size_t offset)
+            : reader_(reader), id_(id), declaration_(declaration), offset_(offset) {}
+
+        // Deletes the decoded instance, but not the references to it
+        void clear_();
+
+      public:
+        instance(const instance&) = delete;
+        instance& operator=(const instance&) = delete;
+        ~instance();
+
+        /// Returns the entity instance name, i.e. #id
+        unsigned id() const { return id_; }
+
+        /// Returns the entity type of the instance
+        const IfcParse::entity& declaration() const { return *declaration_; }
+
+        /// Returns the instance with its attribute values, which are decoded
+        /// when this is first called, or nullptr when the instance cannot be
+        /// decoded. The instance remains valid until the callback returns, or
+        /// while it is retained in the cache.
+        IfcUtil::IfcBaseClass* get();
+
+        /// Returns the value of the attribute at index, see get()
+        AttributeValue get_attribute_value(size_t index);
+
+        /// Returns the attribute index and name of every reference in the
+        /// attribute values, including the ones that could not be resolved
+        const std::vector<std::pair<size_t, unsigned>>& references();
+    };
+
+    typedef std::function<void(instance&)> callback;
+
+  private:
+    typedef std::list<std::unique_ptr<instance>> cache_t;
+
+    file_open_status good_ = file_open_status::SUCCESS;
+
+    std::unique_ptr<std::istream> owned_input_;
+    std::istream* input_;
+    bool input_exhausted_ = false;
+
+    // Provides the schema and header, and the routines to parse instances
+    std::unique_ptr<IfcFile> context_;
+
+    // The part of the file currently in memory, starting at window_begin_
+    std::unique_ptr<IfcSpfStream> window_;
+    size_t window_begin_ = 0;
+    size_t cursor_ = 0;
+
+    std::unique_ptr<instance> current_;
+    bool stopped_ = false;
+
+    size_t cache_size_ = 0;
+    // Most recently used instances first
+    cache_t cache_;
+    std::unordered_map<unsigned, cache_t::iterator> cache_by_id_;
+
+    // Populated by IfcFile::load_(), but not used by the reader
+    IfcFile::entities_by_ref_t byref_;
+
+    void initialize_();
+    bool fill_(size_t keep_from);
+    void read_header_();
+    IfcUtil::IfcBaseClass* parse_(instance& inst);
+    void resolve_(instance& inst, unresolved_references& references);
+    instance* find_(unsigned id);
+    void unparse_(instance& inst);
+    void discard_(instance& inst);
+    void evict_(cache_t::iterator it);
+
+  public:
+    /// Opens the file at path and reads its header
+    explicit IfcSpfReader(const std::string& path);
+    /// Reads from stream, which needs to remain valid for the lifetime of the reader
+    explicit IfcSpfReader(std::istream& stream);
+    ~IfcSpfReader();
+
+    IfcSpfReader(const IfcSpfReader&) = delete;
+    IfcSpfReader& operator=(const IfcSpfReader&) = delete;
+
+    file_open_status good() const { return good_; }
+
+    const IfcParse::schema_definition* schema() const { return context_->schema(); }
+    const IfcSpfHeader& header() const { return context_->header(); }
+
+    /// Number of recently visited instances retained to resolve references, 0 by default
+    size_t cache_size() const { return cache_size_; }
+    void cache_size(size_t n);
+
+    /// Calls fn for every entity instance in the remainder of the data
+    /// section, in file order, until the end of the file is reached or stop()
+    /// is called. Returns the number of instances visited.
+    size_t read(const callback& fn);
+
+    /// Makes read() return after the current callback
+    void stop() { stopped_ = true; }
+
+    /// Returns the instance with the specified name if it is the instance
+    /// currently visited or in the cache, otherwise nullptr
+    IfcUtil::IfcBaseClass* instance_by_id(unsigned id);
+};
+
+} // namespace IfcParse
+
+#endif
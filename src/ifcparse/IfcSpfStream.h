@@ -29,6 +29,7 @@
 
 #include "ifc_parse_api.h"
 
+#include <cstddef>
 #include <string>
 
 #ifdef USE_MMAP
@@ -46,36 +47,53 @@ class IFC_PARSE_API IfcSpfStream {
 #endif
     FILE* stream_;
     const char* buffer_;
-    unsigned int ptr_;
-    unsigned int len_;
+    size_t ptr_;
+    size_t len_;
+    bool owns_buffer_;
 
   public:
     bool valid;
     bool eof;
-    unsigned int size;
+    size_t size;
 #ifdef USE_MMAP
     IfcSpfStream(const std::string& path, bool mmap = false);
 #else
     IfcSpfStream(const std::string& path);
 #endif
-    IfcSpfStream(std::istream& stream, int length);
-    IfcSpfStream(void* data, int length);
+    IfcSpfStream(std::istream& stream, size_t length);
+    IfcSpfStream(void* data, size_t length);
+    /// Creates a view on the buffer of another stream with an independent
+    /// cursor at offset. The buffer is not released when the view is closed.
+    IfcSpfStream(const IfcSpfStream& other, size_t offset);
     ~IfcSpfStream();
     /// Returns the character at the cursor
     char Peek();
     /// Returns the character at specified offset
-    char Read(unsigned int offset);
+    char Read(size_t offset);
     /// Increment the file cursor and reads new page if necessary
     void Inc();
     void Close();
     /// Moves the file cursor to an arbitrary offset in the file
-    void Seek(unsigned int offset);
+    void Seek(size_t offset);
     /// Returns the cursor position
-    unsigned int Tell() const;
+    size_t Tell() const;
 
-    bool is_eof_at(unsigned int) const;
-    void increment_at(unsigned int&);
-    char peek_at(unsigned int);
+    /// Returns the offset of the first character at or after offset that
+    /// delimits an unquoted token, i.e. one of ()=,;/, or that is a quote or
+    /// line break. Returns the stream length if there is no such character.
+    size_t find_token_boundary(size_t offset) const;
+
+    /// Returns the contents of the stream, which are length bytes long
+    const char* data() const { return buffer_; }
+    size_t length() const { return len_; }
+
+    /// Returns the number of bytes of the file held in memory by this stream,
+    /// which is 0 when the buffer is owned by another stream
+    size_t memory_usage() const { return owns_buffer_ && buffer_ ? len_ : 0; }
+
+    bool is_eof_at(size_t) const;
+    void increment_at(size_t&);
+    char peek_at(size_t);
 };
 } // namespace IfcParse
 
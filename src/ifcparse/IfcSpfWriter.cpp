@@ -0,0 +1,336 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "IfcSpfWriter.h"
+
+#include "IfcException.h"
+#include "spf_statement.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <locale>
+#include <mutex>
+#include <set>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace IfcParse;
+
+namespace {
+    const size_t maximal_instances_per_chunk = 4096;
+
+    // Number of formatted chunks per thread that may wait to be written
+    const size_t chunks_per_thread = 4;
+
+    // Appends the characters written to a stream to a string. Unlike
+    // std::ostringstream the string can be written out and reused for the
+    // next chunk without copying.
+    class string_buffer : public std::streambuf {
+      private:
+        std::string& str_;
+
+      protected:
+        int_type overflow(int_type c) override {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                str_.push_back(traits_type::to_char_type(c));
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override {
+            str_.append(s, (size_t)n);
+            return n;
+        }
+
+      public:
+        explicit string_buffer(std::string& str)
+            : str_(str) {}
+    };
+
+    typedef std::vector<std::pair<unsigned, IfcUtil::IfcBaseClass*>> instances_t;
+
+    void format_instances(instances_t::const_iterator begin, instances_t::const_iterator end, std::string& buffer) {
+        string_buffer sb(buffer);
+        std::ostream out(&sb);
+        out.imbue(std::locale::classic());
+        for (auto it = begin; it != end; ++it) {
+            it->second->toString(out, true);
+            out << ";\n";
+        }
+    }
+
+    // Returns whether the statement in [begin, end) consists of keyword
+    bool is_keyword_statement(const char* data, size_t begin, size_t end, const char* keyword) {
+        const size_t length = strlen(keyword);
+        size_t offset = begin + length;
+        if (offset > end || memcmp(data + begin, keyword, length) != 0) {
+            return false;
+        }
+        spf_statement::skip_whitespace_and_comments(data, end, offset);
+        return offset + 1 == end && data[offset] == ';';
+    }
+} // namespace
+
+std::string IfcParse::format_instance(const IfcUtil::IfcBaseClass* instance) {
+    std::string buffer;
+    string_buffer sb(buffer);
+    std::ostream out(&sb);
+    out.imbue(std::locale::classic());
+    instance->toString(out, true);
+    return buffer;
+}
+
+IfcSpfWriter::IfcSpfWriter(const IfcFile& file)
+    : file_(file),
+      threads_(IfcFile::write_threads()) {}
+
+void IfcSpfWriter::write(std::ostream& out) const {
+    file_.header().write(out);
+
+    instances_t instances;
+    for (auto it = file_.begin(); it != file_.end(); ++it) {
+        if (it->second->declaration().as_entity() != nullptr) {
+            instances.push_back(*it);
+        }
+    }
+    std::sort(instances.begin(), instances.end(), [](const instances_t::value_type& a, const instances_t::value_type& b) {
+        return a.first < b.first;
+    });
+
+    size_t num_threads = threads_ == 0 ? std::thread::hardware_concurrency() : threads_;
+    num_threads = (std::max)(num_threads, (size_t)1);
+
+    // Files with few, large, instances, such as point lists, are still
+    // split into enough chunks to keep the threads occupied
+    const size_t min_chunks = num_threads * chunks_per_thread * 4;
+    const size_t instances_per_chunk = (std::max)((size_t)1, (std::min)(maximal_instances_per_chunk, instances.size() / min_chunks));
+    const size_t num_chunks = (instances.size() + instances_per_chunk - 1) / instances_per_chunk;
+    num_threads = (std::min)(num_threads, num_chunks);
+
+    auto chunk_begin = [&instances, instances_per_chunk](size_t i) {
+        return instances.cbegin() + i * instances_per_chunk;
+    };
+    auto chunk_end = [&instances, instances_per_chunk](size_t i) {
+        return instances.cbegin() + (std::min)((i + 1) * instances_per_chunk, instances.size());
+    };
+
+    if (num_threads <= 1) {
+        std::string buffer;
+        for (size_t i = 0; i < num_chunks; ++i) {
+            buffer.clear();
+            format_instances(chunk_begin(i), chunk_end(i), buffer);
+            out.write(buffer.data(), (std::streamsize)buffer.size());
+        }
+    } else {
+        // Chunk i is formatted into buffers[i % window], which is only reused
+        // after the chunk has been written.
+        const size_t window = num_threads * chunks_per_thread;
+        std::vector<std::string> buffers(window);
+        std::vector<char> formatted(window, 0);
+        size_t next_chunk = 0, num_written = 0;
+        bool cancelled = false;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable chunk_formatted, chunk_written;
+
+        auto format = [&]() {
+            for (;;) {
+                size_t i;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    chunk_written.wait(lock, [&]() {
+                        return cancelled || next_chunk == num_chunks || next_chunk < num_written + window;
+                    });
+                    if (cancelled || next_chunk == num_chunks) {
+                        return;
+                    }
+                    i = next_chunk++;
+                }
+                try {
+                    format_instances(chunk_begin(i), chunk_end(i), buffers[i % window]);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    cancelled = true;
+                    chunk_formatted.notify_all();
+                    chunk_written.notify_all();
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                formatted[i % window] = 1;
+                chunk_formatted.notify_all();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            threads.emplace_back(format);
+        }
+
+        for (size_t i = 0; i < num_chunks; ++i) {
+            std::string& buffer = buffers[i % window];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                chunk_formatted.wait(lock, [&]() {
+                    return cancelled || formatted[i % window] != 0;
+                });
+                if (cancelled) {
+                    break;
+                }
+            }
+            out.write(buffer.data(), (std::streamsize)buffer.size());
+            buffer.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            formatted[i % window] = 0;
+            num_written = i + 1;
+            chunk_written.notify_all();
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    out << "ENDSEC;\n";
+    out << "END-ISO-10303-21;" << std::endl;
+}
+
+void IfcSpfWriter::write_incremental(std::ostream& out, const IfcSpfStream& original) const {
+    using namespace spf_statement;
+
+    const change_journal& journal = file_.journal();
+    if (!journal.complete()) {
+        throw IfcException("Changes to the file have not been recorded since it was read");
+    }
+
+    const char* data = original.data();
+    const size_t length = original.length();
+
+    // The data section starts after the DATA statement and its line break
+    size_t offset = 0;
+    size_t data_section = npos;
+    while (data_section == npos) {
+        skip_whitespace_and_comments(data, length, offset);
+        const size_t end = offset < length ? find_statement_end(data, length, offset) : npos;
+        if (end == npos) {
+            throw IfcException("No data section in original file");
+        }
+        if (is_keyword_statement(data, offset, end, "DATA")) {
+            data_section = end;
+            if (data_section < length && data[data_section] == '\r') {
+                ++data_section;
+            }
+            if (data_section < length && data[data_section] == '\n') {
+                ++data_section;
+            }
+        }
+        offset = end;
+    }
+
+    file_.header().write(out);
+
+    // Instances in the original file are only located, not parsed. The ranges
+    // in between changed instances are copied at once.
+    std::set<unsigned> written;
+    size_t copy_from = data_section;
+    auto copy_until = [&](size_t until) {
+        out.write(data + copy_from, (std::streamsize)(until - copy_from));
+    };
+
+    bool data_section_ended = false;
+    while (!data_section_ended) {
+        skip_whitespace_and_comments(data, length, offset);
+        size_t end = offset < length ? find_statement_end(data, length, offset) : npos;
+        if (end == npos) {
+            throw IfcException("Data section of original file is not terminated");
+        }
+
+        if (data[offset] != '#') {
+            if (is_keyword_statement(data, offset, end, "ENDSEC")) {
+                copy_until(offset);
+                copy_from = offset;
+                data_section_ended = true;
+            }
+            offset = end;
+            continue;
+        }
+
+        unsigned name = 0;
+        for (size_t i = offset + 1; i < end && std::isdigit(static_cast<unsigned char>(data[i])); ++i) {
+            name = name * 10 + (unsigned)(data[i] - '0');
+        }
+
+        if (const change_journal::entry* entry = journal.find(name)) {
+            copy_until(offset);
+            if (entry->op == change_journal::removed) {
+                // Also omit the line break, so that no empty line remains
+                if (end < length && data[end] == '\r') {
+                    ++end;
+                }
+                if (end < length && data[end] == '\n') {
+                    ++end;
+                }
+            } else {
+                out << format_instance(entry->instance) << ";";
+                written.insert(name);
+            }
+            copy_from = end;
+        }
+        offset = end;
+    }
+
+    // Added instances, and modified instances that did not occur in the
+    // original file, are written at the end of the data section
+    for (const auto& p : journal) {
+        if (p.second.op != change_journal::removed && written.find(p.first) == written.end()) {
+            out << format_instance(p.second.instance) << ";\n";
+        }
+    }
+
+    copy_until(length);
+}
+
+void IfcSpfWriter::write_diff(std::ostream& out) const {
+    for (const auto& p : file_.journal()) {
+        const change_journal::entry& entry = p.second;
+        const std::string current = entry.instance != nullptr ? format_instance(entry.instance) : std::string();
+        if (entry.op == change_journal::modified && current == entry.original) {
+            continue;
+        }
+        if (entry.op != change_journal::added) {
+            out << "-" << entry.original << ";\n";
+        }
+        if (entry.op != change_journal::removed) {
+            out << "+" << current << ";\n";
+        }
+    }
+}
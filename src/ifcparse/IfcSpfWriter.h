@@ -0,0 +1,88 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+/********************************************************************************
+ *                                                                              *
+ * Writes the contents of an IfcFile in the IFC-SPF format, formatting the      *
+ * instances concurrently                                                       *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef IFCSPFWRITER_H
+#define IFCSPFWRITER_H
+
+#include "ifc_parse_api.h"
+#include "IfcFile.h"
+#include "IfcSpfStream.h"
+
+#include <ostream>
+#include <string>
+
+namespace IfcParse {
+
+/// Returns the SPF representation of the instance without a trailing
+/// semicolon, formatted independently of the global locale
+IFC_PARSE_API std::string format_instance(const IfcUtil::IfcBaseClass* instance);
+
+/// Writes the header and data section of a file to a stream. The instances
+/// are sorted by name and split into chunks that are formatted into separate
+/// buffers, on a number of threads when threads() is not 1. The buffers are
+/// written to the stream in order, so that the output does not depend on the
+/// number of threads. Only a bounded number of formatted chunks is held in
+/// memory at any time.
+///
+/// The file must not be modified while it is being written.
+class IFC_PARSE_API IfcSpfWriter {
+  private:
+    const IfcFile& file_;
+    unsigned threads_;
+
+  public:
+    explicit IfcSpfWriter(const IfcFile& file);
+
+    /// Number of threads used to format instances. 0 uses the hardware
+    /// concurrency. Defaults to IfcFile::write_threads().
+    unsigned threads() const { return threads_; }
+    void threads(unsigned n) { threads_ = n; }
+
+    void write(std::ostream& out) const;
+
+    /// Writes the file by copying the SPF file it was read from, only
+    /// replacing the instances that were modified and removed according to the
+    /// journal of the file, and appending the instances that were added at the
+    /// end of the data section. Everything else, including comments and
+    /// formatting, is copied verbatim. The header is written as by write().
+    ///
+    /// The journal needs to be complete, i.e. started before the file was
+    /// modified, and original needs to hold the file as it was read, or as
+    /// it was saved when the journal was last cleared. Throws IfcException
+    /// otherwise, when detected.
+    void write_incremental(std::ostream& out, const IfcSpfStream& original) const;
+
+    /// Writes the changes recorded in the journal of the file, ordered by
+    /// instance name. Every removed or modified instance is written as it was
+    /// before the change on a line prefixed by '-', every added or modified
+    /// instance as it is now on a line prefixed by '+'. Instances that were
+    /// modified and then restored are omitted.
+    void write_diff(std::ostream& out) const;
+};
+
+} // namespace IfcParse
+
+#endif
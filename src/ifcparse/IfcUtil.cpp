@@ -219,29 +219,30 @@ void IfcUtil::IfcBaseEntity::populate_derived() {
 
 AttributeValue IfcUtil::IfcBaseEntity::get(const std::string& name) const
 {
-    auto attrs = declaration().as_entity()->all_attributes();
-    auto iter = attrs.begin();
-    size_t idx = 0;
-    for (; iter != attrs.end(); ++iter, ++idx) {
-        if ((*iter)->name() == name) {
-            return data().get_attribute_value(idx);
-        }
+    const ptrdiff_t idx = declaration().attribute_index(name);
+    if (idx == -1) {
+        throw IfcParse::IfcException(name + " not found on " + declaration().name());
+    }
+    return data().get_attribute_value(idx);
+}
+
+AttributeValue IfcUtil::IfcBaseEntity::get(const IfcParse::attribute_handle& handle) const
+{
+    if (!handle || !declaration().is(*handle.entity_declaration())) {
+        throw IfcParse::IfcException("Attribute handle does not apply to " + declaration().name());
     }
-    throw IfcParse::IfcException(name + " not found on " + declaration().name());
+    return data().get_attribute_value(handle.index());
 }
 
 aggregate_of_instance::ptr IfcUtil::IfcBaseEntity::get_inverse(const std::string& name) const {
-    const std::vector<const IfcParse::inverse_attribute*> attrs = declaration().as_entity()->all_inverse_attributes();
-    std::vector<const IfcParse::inverse_attribute*>::const_iterator iter = attrs.begin();
-    for (; iter != attrs.end(); ++iter) {
-        if ((*iter)->name() == name) {
-            return file_->getInverse(
-                id_,
-                (*iter)->entity_reference(),
-                (int)(*iter)->entity_reference()->attribute_index((*iter)->attribute_reference()));
-        }
+    const auto* attr = declaration().inverse_attribute_by_name(name);
+    if (attr == nullptr) {
+        throw IfcParse::IfcException(name + " not found on " + declaration().name());
     }
-    throw IfcParse::IfcException(name + " not found on " + declaration().name());
+    return file_->getInverse(
+        id_,
+        attr->entity_reference(),
+        (int)attr->entity_reference()->attribute_index(attr->attribute_reference()));
 }
 
 /*
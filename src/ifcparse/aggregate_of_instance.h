@@ -24,6 +24,7 @@
 #include "ifc_parse_api.h"
 
 #include <boost/shared_ptr.hpp>
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -56,6 +57,13 @@ class IFC_PARSE_API aggregate_of_instance {
     typename U::list::ptr as();
 
     void remove(IfcUtil::IfcBaseClass*);
+
+    /// Removes the instances for which fn returns true in a single pass
+    template <typename Fn>
+    void remove_if(Fn fn) {
+        list_.erase(std::remove_if(list_.begin(), list_.end(), fn), list_.end());
+    }
+
     aggregate_of_instance::ptr filtered(const std::set<const IfcParse::declaration*>& entities);
     aggregate_of_instance::ptr unique();
 };
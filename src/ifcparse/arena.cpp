@@ -0,0 +1,125 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "arena.h"
+
+#include <algorithm>
+#include <new>
+
+using namespace IfcParse;
+
+namespace {
+    const size_t initial_block_size = 64 * 1024;
+    const size_t maximal_block_size = 4 * 1024 * 1024;
+
+    // Every allocation is preceded by a header that records whether it is
+    // allocated in an arena or on the heap
+    struct alignas(16) header {
+        size_t size;
+        bool in_arena;
+    };
+
+    size_t round_up(size_t n) {
+        return (n + alignof(header) - 1) & ~(alignof(header) - 1);
+    }
+
+    thread_local arena* current_arena = nullptr;
+}
+
+arena::scope::scope(arena& a)
+    : previous_(current_arena)
+{
+    current_arena = &a;
+}
+
+arena::scope::~scope() {
+    current_arena = previous_;
+}
+
+arena::block_list::~block_list() {
+    for (auto* b : blocks) {
+        ::operator delete(b);
+    }
+}
+
+arena::arena()
+    : blocks_(std::make_shared<block_list>())
+    , next_block_size_(initial_block_size)
+{}
+
+// Blocks still referenced by allocations made with make_shared_in_arena() are
+// released when the last of these is.
+arena::~arena() = default;
+
+void arena::splice(arena& other) {
+    // Allocations in other may hold on to its block list, so it is kept whole
+    blocks_->spliced.push_back(std::move(other.blocks_));
+    stats_.allocations += other.stats_.allocations;
+    stats_.bytes += other.stats_.bytes;
+    stats_.blocks += other.stats_.blocks;
+    stats_.bytes_reserved += other.stats_.bytes_reserved;
+
+    other.blocks_ = std::make_shared<block_list>();
+    other.cursor_ = other.end_ = nullptr;
+    other.next_block_size_ = initial_block_size;
+    other.stats_ = {0, 0, 0, 0};
+}
+
+void* arena::allocate_(size_t n) {
+    const size_t total = sizeof(header) + round_up(n);
+    if (cursor_ == nullptr || (size_t)(end_ - cursor_) < total) {
+        const size_t block_size = (std::max)(next_block_size_, total);
+        next_block_size_ = (std::min)(next_block_size_ * 2, maximal_block_size);
+        blocks_->blocks.push_back(static_cast<char*>(::operator new(block_size)));
+        cursor_ = blocks_->blocks.back();
+        end_ = cursor_ + block_size;
+        stats_.blocks += 1;
+        stats_.bytes_reserved += block_size;
+    }
+    auto* h = new (cursor_) header{n, true};
+    cursor_ += total;
+    stats_.allocations += 1;
+    stats_.bytes += n;
+    return h + 1;
+}
+
+void* arena::allocate(size_t n) {
+    if (current_arena != nullptr) {
+        return current_arena->allocate_(n);
+    }
+    auto* h = new (::operator new(sizeof(header) + n)) header{n, false};
+    return h + 1;
+}
+
+void arena::deallocate(void* p) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    auto* h = static_cast<header*>(p) - 1;
+    if (!h->in_arena) {
+        ::operator delete(h);
+    }
+}
+
+std::shared_ptr<void> arena::current_memory() {
+    if (current_arena == nullptr) {
+        return nullptr;
+    }
+    return current_arena->blocks_;
+}
@@ -0,0 +1,160 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "ifc_parse_api.h"
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace IfcParse {
+
+/// Bump allocator for the entity instances, attribute storage and aggregates
+/// created while reading a file. Memory is obtained from the system allocator
+/// in large blocks, which are released at once when the arena is destroyed.
+///
+/// The arena is selected for the calling thread by creating an arena::scope.
+/// arena::allocate() serves requests from the arena in scope, or from the
+/// heap if there is none, and arena::deallocate() accepts memory from either.
+/// Deallocating memory in an arena is a no-op, it is only reclaimed when the
+/// arena is destroyed. Hence, objects allocated in an arena must be destroyed
+/// before the arena is, with the exception of objects created by
+/// make_shared_in_arena(), which keep the memory of the arena alive.
+class IFC_PARSE_API arena {
+  public:
+    struct statistics {
+        /// Number of allocations served by the arena
+        size_t allocations;
+        /// Number of bytes requested by these allocations
+        size_t bytes;
+        /// Number of blocks obtained from the system allocator
+        size_t blocks;
+        /// Total size of these blocks
+        size_t bytes_reserved;
+    };
+
+    /// Makes the arena the target of arena::allocate() on the calling thread
+    /// for the lifetime of the scope
+    class IFC_PARSE_API scope {
+      private:
+        arena* previous_;
+
+      public:
+        explicit scope(arena& a);
+        ~scope();
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+    };
+
+  private:
+    // Shared with the allocations that keep the arena's memory alive
+    struct block_list {
+        std::vector<char*> blocks;
+        // Memory of arenas that were spliced into this one
+        std::vector<std::shared_ptr<block_list>> spliced;
+
+        block_list() = default;
+        block_list(const block_list&) = delete;
+        block_list& operator=(const block_list&) = delete;
+        ~block_list();
+    };
+
+    std::shared_ptr<block_list> blocks_;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+    size_t next_block_size_;
+    statistics stats_ = {0, 0, 0, 0};
+
+    void* allocate_(size_t n);
+
+  public:
+    arena();
+    ~arena();
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    /// Takes over the memory allocated in other, e.g. by a different thread
+    void splice(arena& other);
+
+    const statistics& stats() const { return stats_; }
+
+    /// Allocates n bytes, aligned for any fundamental type, from the arena in
+    /// scope on the calling thread or from the heap
+    static void* allocate(size_t n);
+
+    /// Deallocates memory obtained from arena::allocate()
+    static void deallocate(void* p) noexcept;
+
+    /// Returns a handle that keeps the memory of the arena in scope on the
+    /// calling thread alive, or an empty handle if there is none
+    static std::shared_ptr<void> current_memory();
+};
+
+/// Standard allocator on top of arena::allocate(), e.g. for boost::allocate_shared().
+/// Copies of the allocator keep the memory of the arena that was in scope at
+/// construction alive, so that shared pointers may outlive the arena.
+template <typename T>
+struct arena_allocator {
+    typedef T value_type;
+
+    std::shared_ptr<void> memory;
+
+    arena_allocator()
+        : memory(arena::current_memory()) {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other)
+        : memory(other.memory) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        arena::deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U>& other) const { return memory == other.memory; }
+
+    template <typename U>
+    bool operator!=(const arena_allocator<U>& other) const { return memory != other.memory; }
+};
+
+/// Creates an instance of T and its reference count in a single allocation
+/// using arena::allocate(). The reference count holds on to the arena's memory,
+/// so the instance remains valid after the arena is destroyed, e.g. when an
+/// aggregate is handed out by a file that is closed before it is released.
+template <typename T, typename... Args>
+boost::shared_ptr<T> make_shared_in_arena(Args&&... args) {
+    return boost::allocate_shared<T>(arena_allocator<T>(), std::forward<Args>(args)...);
+}
+
+} // namespace IfcParse
+
+#endif
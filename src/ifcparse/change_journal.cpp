@@ -0,0 +1,84 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "change_journal.h"
+#include "IfcBaseClass.h"
+#include "IfcSpfWriter.h"
+
+using namespace IfcParse;
+
+void change_journal::stop() {
+    enabled_ = false;
+    if (!entries_.empty()) {
+        complete_ = false;
+        entries_.clear();
+    }
+}
+
+void change_journal::record_added(IfcUtil::IfcBaseClass* instance) {
+    if (!enabled_) {
+        complete_ = false;
+        return;
+    }
+    auto it = entries_.find(instance->id());
+    if (it == entries_.end()) {
+        entries_.insert({instance->id(), {added, instance, {}}});
+    } else {
+        // A removed instance replaced by one with the same name
+        if (it->second.op == removed) {
+            it->second.op = modified;
+        }
+        it->second.instance = instance;
+    }
+}
+
+void change_journal::record_modified(IfcUtil::IfcBaseClass* instance) {
+    if (!enabled_) {
+        complete_ = false;
+        return;
+    }
+    if (entries_.find(instance->id()) == entries_.end()) {
+        entries_.insert({instance->id(), {modified, instance, format_instance(instance)}});
+    }
+}
+
+void change_journal::record_removed(IfcUtil::IfcBaseClass* instance) {
+    if (!enabled_) {
+        complete_ = false;
+        return;
+    }
+    auto it = entries_.find(instance->id());
+    if (it == entries_.end()) {
+        entries_.insert({instance->id(), {removed, nullptr, format_instance(instance)}});
+    } else if (it->second.op == added) {
+        entries_.erase(it);
+    } else {
+        it->second.op = removed;
+        it->second.instance = nullptr;
+    }
+}
+
+size_t change_journal::memory_usage() const {
+    size_t n = 0;
+    // A tree node holds three pointers and a color besides the value
+    for (const auto& p : entries_) {
+        n += sizeof(p) + 4 * sizeof(void*) + p.second.original.capacity() + 1;
+    }
+    return n;
+}
@@ -0,0 +1,113 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef CHANGE_JOURNAL_H
+#define CHANGE_JOURNAL_H
+
+#include "ifc_parse_api.h"
+
+#include <map>
+#include <string>
+
+namespace IfcUtil {
+class IfcBaseClass;
+}
+
+namespace IfcParse {
+
+/// Records which entity instances of a file were added, modified or removed
+/// since the journal was started or last cleared, together with the SPF
+/// representation of the instances before they were first modified or
+/// removed. The entries are ordered by instance name.
+///
+/// The journal is complete when it was started before any instance of the
+/// file was modified, in which case the changes relative to the file that
+/// was read are exactly the entries of the journal.
+class IFC_PARSE_API change_journal {
+  public:
+    enum operation {
+        added,
+        modified,
+        removed
+    };
+
+    struct entry {
+        operation op;
+        // The instance in the file, nullptr when removed
+        IfcUtil::IfcBaseClass* instance;
+        // The instance before it was first changed, without a trailing
+        // semicolon, empty when added
+        std::string original;
+    };
+
+    typedef std::map<unsigned, entry> entries_t;
+    typedef entries_t::const_iterator const_iterator;
+
+  private:
+    entries_t entries_;
+    bool enabled_ = false;
+    bool complete_ = true;
+
+  public:
+    bool enabled() const { return enabled_; }
+    bool complete() const { return complete_; }
+
+    /// Starts recording changes. The journal is complete when no instance was
+    /// changed before, otherwise it remains incomplete until clear() is called.
+    void start() { enabled_ = true; }
+
+    /// Stops recording changes and discards the entries
+    void stop();
+
+    /// Discards the entries, after which the journal is considered complete
+    /// relative to the current state of the file, for example after it has
+    /// been saved.
+    void clear() {
+        entries_.clear();
+        complete_ = true;
+    }
+
+    // The following are called by the file for every change, also when the
+    // journal is not enabled, in which case it is marked incomplete.
+
+    /// To be called after an instance is added to the file
+    void record_added(IfcUtil::IfcBaseClass* instance);
+    /// To be called before an instance of the file is modified
+    void record_modified(IfcUtil::IfcBaseClass* instance);
+    /// To be called before an instance is removed from the file
+    void record_removed(IfcUtil::IfcBaseClass* instance);
+
+    const_iterator begin() const { return entries_.begin(); }
+    const_iterator end() const { return entries_.end(); }
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+    /// Returns an estimate of the number of bytes held by the journal
+    size_t memory_usage() const;
+
+    /// Returns the entry of the instance, or nullptr when it is unchanged
+    const entry* find(unsigned name) const {
+        auto it = entries_.find(name);
+        return it == entries_.end() ? nullptr : &it->second;
+    }
+};
+
+} // namespace IfcParse
+
+#endif
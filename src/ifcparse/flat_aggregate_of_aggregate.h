@@ -0,0 +1,151 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef FLAT_AGGREGATE_OF_AGGREGATE_H
+#define FLAT_AGGREGATE_OF_AGGREGATE_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// An aggregate of aggregates of ints or floats, e.g. ((1, 2), (3)), stored
+/// as the concatenation of the inner aggregates and the offsets at which each
+/// of them starts, rather than as a vector of vectors. This avoids an
+/// allocation per inner aggregate, which for the large coordinate and index
+/// lists in tessellated geometry dominates the memory usage and load time.
+///
+/// offsets() holds size() + 1 entries, the inner aggregate i spans
+/// values()[offsets()[i]] up to values()[offsets()[i + 1]].
+template <typename T>
+class flat_aggregate_of_aggregate {
+  public:
+    typedef T value_type;
+
+    /// A view on one of the inner aggregates, valid as long as the
+    /// flat_aggregate_of_aggregate it was obtained from is not modified
+    class span {
+      private:
+        const T* begin_;
+        const T* end_;
+
+      public:
+        typedef T value_type;
+        typedef const T* const_iterator;
+
+        span(const T* begin, const T* end)
+            : begin_(begin)
+            , end_(end)
+        {}
+
+        const T* begin() const { return begin_; }
+        const T* end() const { return end_; }
+        const T* data() const { return begin_; }
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+        const T& operator[](size_t i) const { return begin_[i]; }
+        const T& front() const { return *begin_; }
+        const T& back() const { return *(end_ - 1); }
+
+        operator std::vector<T>() const {
+            return std::vector<T>(begin_, end_);
+        }
+    };
+
+    class const_iterator {
+      private:
+        const flat_aggregate_of_aggregate* aggregate_;
+        size_t index_;
+
+      public:
+        const_iterator(const flat_aggregate_of_aggregate* aggregate, size_t index)
+            : aggregate_(aggregate)
+            , index_(index)
+        {}
+
+        span operator*() const { return (*aggregate_)[index_]; }
+        const_iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+    };
+
+  private:
+    std::vector<T> values_;
+    std::vector<size_t> offsets_;
+
+  public:
+    flat_aggregate_of_aggregate()
+        : offsets_(1, 0)
+    {}
+
+    /// Takes over values and offsets as they are, offsets needs to start
+    /// with 0 and end with values.size()
+    flat_aggregate_of_aggregate(std::vector<T>&& values, std::vector<size_t>&& offsets)
+        : values_(std::move(values))
+        , offsets_(std::move(offsets))
+    {}
+
+    explicit flat_aggregate_of_aggregate(const std::vector<std::vector<T>>& nested) {
+        size_t n = 0;
+        for (const auto& inner : nested) {
+            n += inner.size();
+        }
+        values_.reserve(n);
+        offsets_.reserve(nested.size() + 1);
+        offsets_.push_back(0);
+        for (const auto& inner : nested) {
+            values_.insert(values_.end(), inner.begin(), inner.end());
+            offsets_.push_back(values_.size());
+        }
+    }
+
+    size_t size() const { return offsets_.size() - 1; }
+    bool empty() const { return size() == 0; }
+
+    span operator[](size_t i) const {
+        return span(values_.data() + offsets_[i], values_.data() + offsets_[i + 1]);
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    /// All values of the inner aggregates, concatenated
+    const std::vector<T>& values() const { return values_; }
+    const std::vector<size_t>& offsets() const { return offsets_; }
+
+    std::vector<std::vector<T>> as_vector_of_vector() const {
+        std::vector<std::vector<T>> nested;
+        nested.reserve(size());
+        for (size_t i = 0; i < size(); ++i) {
+            nested.emplace_back(values_.begin() + offsets_[i], values_.begin() + offsets_[i + 1]);
+        }
+        return nested;
+    }
+
+    bool operator==(const flat_aggregate_of_aggregate& other) const {
+        return values_ == other.values_ && offsets_ == other.offsets_;
+    }
+    bool operator!=(const flat_aggregate_of_aggregate& other) const {
+        return !(*this == other);
+    }
+};
+
+#endif
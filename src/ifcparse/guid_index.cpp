@@ -0,0 +1,252 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "guid_index.h"
+
+#include <algorithm>
+#include <array>
+
+using namespace IfcParse;
+
+namespace {
+    const char* const chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_$";
+
+    const size_t guid_length = 22;
+    const size_t minimal_capacity = 16;
+    // Number of lookups that are in flight at the same time in the batch find()
+    const size_t batch_size = 16;
+
+    // Maps characters to their value in the GlobalId alphabet, or -1
+    const std::array<signed char, 256> digits = [] {
+        std::array<signed char, 256> d;
+        d.fill(-1);
+        for (int i = 0; i < 64; ++i) {
+            d[(unsigned char)chars[i]] = (signed char)i;
+        }
+        return d;
+    }();
+
+    bool equal(const guid_index::key_type& a, const guid_index::key_type& b) {
+        return a.high == b.high && a.low == b.low;
+    }
+
+    void prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(p);
+#else
+        (void)p;
+#endif
+    }
+}
+
+bool guid_index::decode(const std::string& guid, key_type& key) {
+    if (guid.size() != guid_length) {
+        return false;
+    }
+    // The first character only encodes the two most significant bits
+    const int first = digits[(unsigned char)guid[0]];
+    if (first < 0 || first > 3) {
+        return false;
+    }
+    uint64_t high = 0, low = (uint64_t)first;
+    for (size_t i = 1; i < guid_length; ++i) {
+        const int d = digits[(unsigned char)guid[i]];
+        if (d < 0) {
+            return false;
+        }
+        high = (high << 6) | (low >> 58);
+        low = (low << 6) | (uint64_t)d;
+    }
+    key = {high, low};
+    return true;
+}
+
+std::string guid_index::encode(const key_type& key) {
+    std::string guid(guid_length, '0');
+    uint64_t high = key.high, low = key.low;
+    for (size_t i = guid_length; i-- > 0;) {
+        guid[i] = chars[low & 63];
+        low = (low >> 6) | (high << 58);
+        high >>= 6;
+    }
+    return guid;
+}
+
+size_t guid_index::home_(const key_type& key) const {
+    // GlobalIds are mostly random, but not all applications generate them
+    // that way, so the halves are mixed before taking the upper bits.
+    uint64_t h = key.high ^ (key.low + 0x9e3779b97f4a7c15ULL + (key.high << 6) + (key.high >> 2));
+    h *= 0x9e3779b97f4a7c15ULL;
+    return (size_t)(h >> (64 - bits_));
+}
+
+size_t guid_index::probe_(const key_type& key) const {
+    const size_t mask = slots_.size() - 1;
+    size_t i = home_(key);
+    while (slots_[i].instance != nullptr && !equal(slots_[i].key, key)) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void guid_index::rehash_(size_t capacity) {
+    std::vector<slot> old(capacity, slot{{0, 0}, nullptr});
+    old.swap(slots_);
+    bits_ = 0;
+    while (((size_t)1 << bits_) < capacity) {
+        ++bits_;
+    }
+    for (const auto& s : old) {
+        if (s.instance != nullptr) {
+            slots_[probe_(s.key)] = s;
+        }
+    }
+}
+
+IfcUtil::IfcBaseClass* guid_index::find(const std::string& guid) const {
+    key_type key;
+    if (!decode(guid, key)) {
+        auto it = other_.find(guid);
+        return it == other_.end() ? nullptr : it->second;
+    }
+    if (slots_.empty()) {
+        return nullptr;
+    }
+    return slots_[probe_(key)].instance;
+}
+
+void guid_index::find(const std::vector<std::string>& guids, std::vector<IfcUtil::IfcBaseClass*>& instances) const {
+    instances.assign(guids.size(), nullptr);
+
+    std::array<key_type, batch_size> keys;
+    std::array<bool, batch_size> valid;
+
+    for (size_t begin = 0; begin < guids.size(); begin += batch_size) {
+        const size_t n = (std::min)(batch_size, guids.size() - begin);
+
+        // Decode the batch first and request the home slots, so that the
+        // cache misses of the probes below overlap.
+        for (size_t i = 0; i < n; ++i) {
+            valid[i] = decode(guids[begin + i], keys[i]);
+            if (valid[i] && !slots_.empty()) {
+                prefetch(&slots_[home_(keys[i])]);
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            if (valid[i]) {
+                if (!slots_.empty()) {
+                    instances[begin + i] = slots_[probe_(keys[i])].instance;
+                }
+            } else {
+                auto it = other_.find(guids[begin + i]);
+                if (it != other_.end()) {
+                    instances[begin + i] = it->second;
+                }
+            }
+        }
+    }
+}
+
+IfcUtil::IfcBaseClass* guid_index::insert(const std::string& guid, IfcUtil::IfcBaseClass* instance) {
+    key_type key;
+    if (!decode(guid, key)) {
+        auto& entry = other_[guid];
+        auto* previous = entry;
+        entry = instance;
+        return previous;
+    }
+    if ((size_ + 1) * 4 > slots_.size() * 3) {
+        rehash_((std::max)(minimal_capacity, slots_.size() * 2));
+    }
+    auto& s = slots_[probe_(key)];
+    auto* previous = s.instance;
+    if (previous == nullptr) {
+        s.key = key;
+        ++size_;
+    }
+    s.instance = instance;
+    return previous;
+}
+
+bool guid_index::erase(const std::string& guid, const IfcUtil::IfcBaseClass* instance) {
+    key_type key;
+    if (!decode(guid, key)) {
+        auto it = other_.find(guid);
+        if (it == other_.end() || (instance != nullptr && it->second != instance)) {
+            return false;
+        }
+        other_.erase(it);
+        return true;
+    }
+    if (slots_.empty()) {
+        return false;
+    }
+
+    size_t i = probe_(key);
+    if (slots_[i].instance == nullptr || (instance != nullptr && slots_[i].instance != instance)) {
+        return false;
+    }
+
+    // Entries following the removed one in the same run are shifted back, so
+    // that no tombstones are needed to keep their probe sequences intact.
+    const size_t mask = slots_.size() - 1;
+    for (size_t j = (i + 1) & mask; slots_[j].instance != nullptr; j = (j + 1) & mask) {
+        const size_t k = home_(slots_[j].key);
+        const bool in_place = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+        if (!in_place) {
+            slots_[i] = slots_[j];
+            i = j;
+        }
+    }
+    slots_[i].instance = nullptr;
+    --size_;
+    return true;
+}
+
+void guid_index::reserve(size_t n) {
+    size_t capacity = minimal_capacity;
+    while (n * 4 > capacity * 3) {
+        capacity *= 2;
+    }
+    if (capacity > slots_.size()) {
+        rehash_(capacity);
+    }
+}
+
+size_t guid_index::memory_usage() const {
+    size_t n = slots_.capacity() * sizeof(slot);
+    // A tree node holds three pointers and a color besides the value
+    for (const auto& p : other_) {
+        n += sizeof(p) + 4 * sizeof(void*);
+        // Short strings are stored within the object
+        const char* object = reinterpret_cast<const char*>(&p.first);
+        if (p.first.data() < object || p.first.data() >= object + sizeof(std::string)) {
+            n += p.first.capacity() + 1;
+        }
+    }
+    return n;
+}
+
+void guid_index::clear() {
+    slots_.clear();
+    size_ = 0;
+    bits_ = 0;
+    other_.clear();
+}
@@ -0,0 +1,123 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef GUID_INDEX_H
+#define GUID_INDEX_H
+
+#include "ifc_parse_api.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace IfcUtil {
+class IfcBaseClass;
+}
+
+namespace IfcParse {
+
+/// Maps GlobalId values to the rooted instances carrying them.
+///
+/// GlobalIds are keyed on the 128-bit value they encode, in an open-addressing
+/// hash table with linear probing. A slot holds the two halves of the key and
+/// the instance, so a lookup decodes the 22 characters once and then compares
+/// integers in a single contiguous array. Values that are not valid encoded
+/// GlobalIds, which some exporters write, are kept in a separate map keyed on
+/// the string.
+class IFC_PARSE_API guid_index {
+  public:
+    struct key_type {
+        uint64_t high;
+        uint64_t low;
+    };
+
+    /// Decodes a 22-character GlobalId into its 128-bit value. Returns false
+    /// when guid is not a valid encoding.
+    static bool decode(const std::string& guid, key_type& key);
+
+    /// Encodes a 128-bit value as a 22-character GlobalId
+    static std::string encode(const key_type& key);
+
+  private:
+    struct slot {
+        key_type key;
+        // nullptr for an unoccupied slot
+        IfcUtil::IfcBaseClass* instance;
+    };
+
+    std::vector<slot> slots_;
+    size_t size_ = 0;
+    // Number of bits in the hash used to address slots_
+    unsigned bits_ = 0;
+
+    std::map<std::string, IfcUtil::IfcBaseClass*> other_;
+
+    size_t home_(const key_type& key) const;
+    size_t probe_(const key_type& key) const;
+    void rehash_(size_t capacity);
+
+  public:
+    /// Returns the instance with the GlobalId, or nullptr
+    IfcUtil::IfcBaseClass* find(const std::string& guid) const;
+
+    /// Looks up every GlobalId in guids and stores the instances, or nullptr
+    /// for those not found, at the same positions in instances. Lookups are
+    /// interleaved so that the memory accesses of consecutive GlobalIds
+    /// overlap.
+    void find(const std::vector<std::string>& guids, std::vector<IfcUtil::IfcBaseClass*>& instances) const;
+
+    /// Associates the GlobalId with instance and returns the instance it was
+    /// previously associated with, or nullptr
+    IfcUtil::IfcBaseClass* insert(const std::string& guid, IfcUtil::IfcBaseClass* instance);
+
+    /// Removes the GlobalId, but only if it is associated with instance when
+    /// that is not nullptr. Returns whether an entry was removed.
+    bool erase(const std::string& guid, const IfcUtil::IfcBaseClass* instance = nullptr);
+
+    /// Makes room for n entries without rehashing
+    void reserve(size_t n);
+
+    void clear();
+
+    /// Returns an estimate of the number of bytes held by the index
+    size_t memory_usage() const;
+
+    size_t size() const { return size_ + other_.size(); }
+    bool empty() const { return size() == 0; }
+
+    /// Calls fn(const std::string& guid, IfcUtil::IfcBaseClass* instance) for
+    /// every entry, in unspecified order
+    template <typename Fn>
+    void visit(Fn fn) const {
+        for (const auto& s : slots_) {
+            if (s.instance != nullptr) {
+                fn(encode(s.key), s.instance);
+            }
+        }
+        for (const auto& p : other_) {
+            fn(p.first, p.second);
+        }
+    }
+};
+
+} // namespace IfcParse
+
+#endif
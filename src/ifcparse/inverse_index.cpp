@@ -0,0 +1,252 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "inverse_index.h"
+#include "thread_utils.h"
+
+using namespace IfcParse;
+
+namespace {
+    // The overlay is merged into the arrays once it holds this many keys and
+    // at least a quarter of the amount of keys in the arrays
+    const size_t minimal_overlay_size_to_compact = 4096;
+
+    // Appended references are added to the overlay rather than rebuilding
+    // the arrays when there are fewer than 1/8th of the references in the arrays
+    const size_t pending_fraction_to_rebuild = 8;
+
+    // Sorting is not split over more threads than leave each of them at
+    // least this many references
+    const size_t minimal_references_per_thread = 1 << 16;
+
+    // Stable sorts contiguous runs of the range on separate threads and then
+    // merges adjacent runs pairwise. A merge keeps the elements of the left
+    // run before equivalent elements of the right run, so the outcome is
+    // identical to std::stable_sort() on the whole range.
+    template <typename It, typename Less>
+    void parallel_stable_sort(It begin, It end, unsigned num_threads, Less less) {
+        const size_t n = std::distance(begin, end);
+        const size_t num_runs = (std::min)((size_t) num_threads, n / minimal_references_per_thread);
+        if (num_runs <= 1) {
+            std::stable_sort(begin, end, less);
+            return;
+        }
+
+        std::vector<It> bounds;
+        for (size_t i = 0; i < num_runs; ++i) {
+            bounds.push_back(begin + n * i / num_runs);
+        }
+        bounds.push_back(end);
+
+        run_in_threads(num_runs, [&](size_t i) {
+            std::stable_sort(bounds[i], bounds[i + 1], less);
+        });
+
+        while (bounds.size() > 2) {
+            std::vector<It> merged;
+            for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+                merged.push_back(bounds[i]);
+            }
+            merged.push_back(bounds.back());
+            run_in_threads((bounds.size() - 1) / 2, [&](size_t i) {
+                std::inplace_merge(bounds[2 * i], bounds[2 * i + 1], bounds[2 * i + 2], less);
+            });
+            bounds.swap(merged);
+        }
+    }
+}
+
+void inverse_index::append(inverse_index& other) {
+    if (pending_.empty()) {
+        pending_.swap(other.pending_);
+    } else {
+        pending_.insert(pending_.end(), other.pending_.begin(), other.pending_.end());
+    }
+    other.pending_.clear();
+}
+
+void inverse_index::append(std::vector<std::pair<key_type, int>>& references) {
+    if (pending_.empty()) {
+        pending_.swap(references);
+    } else {
+        pending_.insert(pending_.end(), references.begin(), references.end());
+    }
+    references.clear();
+}
+
+void inverse_index::build(unsigned num_threads) {
+    const size_t num_names = names_.size() + overlay_.size();
+    if (!pending_.empty() && pending_.size() * pending_fraction_to_rebuild < num_names) {
+        for (const auto& p : pending_) {
+            overlay_entry_(p.first).push_back(p.second);
+        }
+        std::vector<std::pair<key_type, int>>().swap(pending_);
+        maybe_compact_();
+        return;
+    }
+
+    if (pending_.empty() && overlay_.empty()) {
+        return;
+    }
+
+    auto by_key = [](const std::pair<key_type, int>& a, const std::pair<key_type, int>& b) {
+        return a.first < b.first;
+    };
+    // Stable, so that names are kept in the order in which they were appended
+    if (!std::is_sorted(pending_.begin(), pending_.end(), by_key)) {
+        parallel_stable_sort(pending_.begin(), pending_.end(), num_threads, by_key);
+    }
+
+    std::vector<key_type> keys;
+    std::vector<size_t> offsets = {0};
+    std::vector<int> names;
+    keys.reserve(keys_.size() + overlay_.size());
+    offsets.reserve(keys_.size() + overlay_.size() + 1);
+    names.reserve(names_.size() + pending_.size());
+
+    auto p = pending_.cbegin();
+    auto add_pending = [&](const key_type& key) {
+        for (; p != pending_.cend() && p->first == key; ++p) {
+            names.push_back(p->second);
+        }
+    };
+    auto add_pending_before = [&](const key_type* key) {
+        while (p != pending_.cend() && (key == nullptr || p->first < *key)) {
+            keys.push_back(p->first);
+            add_pending(p->first);
+            offsets.push_back(names.size());
+        }
+    };
+
+    visit([&](const key_type& key, const int* begin, const int* end) {
+        add_pending_before(&key);
+        keys.push_back(key);
+        names.insert(names.end(), begin, end);
+        add_pending(key);
+        offsets.push_back(names.size());
+    });
+    add_pending_before(nullptr);
+
+    keys_.swap(keys);
+    offsets_.swap(offsets);
+    names_.swap(names);
+    overlay_.clear();
+    std::vector<std::pair<key_type, int>>().swap(pending_);
+}
+
+std::vector<int>& inverse_index::overlay_entry_(const key_type& key) {
+    auto it = overlay_.lower_bound(key);
+    if (it != overlay_.end() && it->first == key) {
+        return it->second;
+    }
+    std::vector<int> names;
+    auto jt = std::lower_bound(keys_.begin(), keys_.end(), key);
+    if (jt != keys_.end() && *jt == key) {
+        const size_t i = jt - keys_.begin();
+        names.assign(names_.begin() + offsets_[i], names_.begin() + offsets_[i + 1]);
+    }
+    return overlay_.emplace_hint(it, key, std::move(names))->second;
+}
+
+void inverse_index::maybe_compact_() {
+    if (overlay_.size() >= minimal_overlay_size_to_compact && overlay_.size() * 4 >= keys_.size()) {
+        build();
+    }
+}
+
+void inverse_index::insert(const key_type& key, int name) {
+    overlay_entry_(key).push_back(name);
+    maybe_compact_();
+}
+
+void inverse_index::build_pending_() {
+    // Removal applies to the appended references as well, which would
+    // otherwise reappear on the next build()
+    if (!pending_.empty()) {
+        build();
+    }
+}
+
+void inverse_index::erase(const key_type& key, int name) {
+    build_pending_();
+    bool found = false;
+    visit(key, key, [&found, name](const key_type&, const int* begin, const int* end) {
+        found = std::find(begin, end, name) != end;
+    });
+    if (found) {
+        auto& names = overlay_entry_(key);
+        names.erase(std::find(names.begin(), names.end(), name));
+        maybe_compact_();
+    }
+}
+
+void inverse_index::erase(int referenced) {
+    build_pending_();
+    const key_type lower = lower_(referenced), upper = upper_(referenced);
+    overlay_.erase(overlay_.lower_bound(lower), overlay_.upper_bound(upper));
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), lower);
+    for (; it != keys_.end() && !(upper < *it); ++it) {
+        // Mark the key as removed
+        overlay_[*it];
+    }
+    maybe_compact_();
+}
+
+void inverse_index::erase_references(int referenced, int name) {
+    build_pending_();
+    std::vector<key_type> keys;
+    visit(referenced, [&keys, name](const key_type& key, const int* begin, const int* end) {
+        if (std::find(begin, end, name) != end) {
+            keys.push_back(key);
+        }
+    });
+    for (const auto& key : keys) {
+        auto& names = overlay_entry_(key);
+        names.erase(std::remove(names.begin(), names.end(), name), names.end());
+    }
+    maybe_compact_();
+}
+
+size_t inverse_index::count(int referenced) const {
+    size_t n = 0;
+    visit(referenced, [&n](const key_type&, const int* begin, const int* end) {
+        n += end - begin;
+    });
+    return n;
+}
+
+size_t inverse_index::memory_usage() const {
+    size_t n = keys_.capacity() * sizeof(key_type) +
+               offsets_.capacity() * sizeof(size_t) +
+               names_.capacity() * sizeof(int) +
+               pending_.capacity() * sizeof(std::pair<key_type, int>);
+    // A tree node holds three pointers and a color besides the value
+    for (const auto& p : overlay_) {
+        n += sizeof(*overlay_.begin()) + 4 * sizeof(void*) + p.second.capacity() * sizeof(int);
+    }
+    return n;
+}
+
+void inverse_index::clear() {
+    keys_.clear();
+    offsets_.clear();
+    names_.clear();
+    overlay_.clear();
+    pending_.clear();
+}
@@ -0,0 +1,192 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef INVERSE_INDEX_H
+#define INVERSE_INDEX_H
+
+#include "ifc_parse_api.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace IfcParse {
+
+/// Maps the name of a referenced instance, the entity type of the referencing
+/// instance and the attribute index holding the reference to the names of the
+/// referencing instances.
+///
+/// The bulk of the references is stored in compressed sparse row form: a
+/// sorted array of keys with offsets into a single array of instance names.
+/// References gathered while parsing are appended and sorted into these arrays
+/// at once by build(). Incremental updates after that are recorded in an
+/// overlay of modified keys, which is merged back into the arrays when it
+/// grows large relative to them.
+class IFC_PARSE_API inverse_index {
+  public:
+    /// Instance name, entity type index, attribute index
+    typedef std::tuple<int, short, short> key_type;
+
+  private:
+    std::vector<key_type> keys_;
+    // offsets_[i] to offsets_[i + 1] delimits the names referring to keys_[i]
+    std::vector<size_t> offsets_;
+    std::vector<int> names_;
+
+    // Keys modified after build(), these supersede the entries in the arrays
+    // above. An empty vector marks a key as removed.
+    std::map<key_type, std::vector<int>> overlay_;
+
+    // References appended, but not yet built
+    std::vector<std::pair<key_type, int>> pending_;
+
+    std::vector<int>& overlay_entry_(const key_type& key);
+    void maybe_compact_();
+    void build_pending_();
+
+    static key_type lower_(int name) {
+        return key_type{name, std::numeric_limits<short>::min(), std::numeric_limits<short>::min()};
+    }
+
+    static key_type upper_(int name) {
+        return key_type{name, std::numeric_limits<short>::max(), std::numeric_limits<short>::max()};
+    }
+
+  public:
+    /// Appends a reference. Appended references are not visible in lookups
+    /// until build() is called.
+    void append(const key_type& key, int name) {
+        pending_.emplace_back(key, name);
+    }
+
+    /// Moves the appended references of other to this index
+    void append(inverse_index& other);
+
+    /// Moves the references to this index, as if appended one by one
+    void append(std::vector<std::pair<key_type, int>>& references);
+
+    /// Makes the appended references visible in lookups. For every key, the
+    /// names are retained in the order they were added. Sorting a large amount
+    /// of appended references is split over up to num_threads threads.
+    void build(unsigned num_threads = 1);
+
+    /// Adds a reference, immediately visible in lookups
+    void insert(const key_type& key, int name);
+
+    /// Removes the first occurrence of name from the references to key. As
+    /// for the other erase functions, appended references are built first.
+    void erase(const key_type& key, int name);
+
+    /// Removes all references to the instance
+    void erase(int referenced);
+
+    /// Removes all occurrences of name from the references to the instance
+    void erase_references(int referenced, int name);
+
+    /// Removes the references to instances for which remove_key returns
+    /// true and the names for which remove_name returns true.
+    template <typename KeyPredicate, typename NamePredicate>
+    void erase_if(KeyPredicate remove_key, NamePredicate remove_name) {
+        build();
+        std::vector<key_type> keys;
+        std::vector<size_t> offsets = {0};
+        std::vector<int> names;
+        keys.reserve(keys_.size());
+        offsets.reserve(keys_.size() + 1);
+        names.reserve(names_.size());
+        visit([&](const key_type& key, const int* begin, const int* end) {
+            if (remove_key(std::get<0>(key))) {
+                return;
+            }
+            const size_t size_before = names.size();
+            std::remove_copy_if(begin, end, std::back_inserter(names), remove_name);
+            if (names.size() != size_before) {
+                keys.push_back(key);
+                offsets.push_back(names.size());
+            }
+        });
+        keys_.swap(keys);
+        offsets_.swap(offsets);
+        names_.swap(names);
+        overlay_.clear();
+    }
+
+    /// Calls fn(key, begin, end) in key order for every key in the closed
+    /// range [lower, upper] that has references, with begin and end
+    /// delimiting the names of the referencing instances.
+    template <typename Fn>
+    void visit(const key_type& lower, const key_type& upper, Fn fn) const {
+        auto it = std::lower_bound(keys_.begin(), keys_.end(), lower);
+        auto overlay_it = overlay_.lower_bound(lower);
+        for (;;) {
+            const bool in_arrays = it != keys_.end() && !(upper < *it);
+            const bool in_overlay = overlay_it != overlay_.end() && !(upper < overlay_it->first);
+            if (!in_arrays && !in_overlay) {
+                break;
+            }
+            if (in_overlay && (!in_arrays || !(*it < overlay_it->first))) {
+                if (in_arrays && *it == overlay_it->first) {
+                    ++it;
+                }
+                const auto& names = overlay_it->second;
+                if (!names.empty()) {
+                    fn(overlay_it->first, names.data(), names.data() + names.size());
+                }
+                ++overlay_it;
+            } else {
+                const size_t i = it - keys_.begin();
+                fn(*it, names_.data() + offsets_[i], names_.data() + offsets_[i + 1]);
+                ++it;
+            }
+        }
+    }
+
+    /// Calls fn(key, begin, end) for all references to the instance
+    template <typename Fn>
+    void visit(int referenced, Fn fn) const {
+        visit(lower_(referenced), upper_(referenced), fn);
+    }
+
+    /// Calls fn(key, begin, end) for all keys
+    template <typename Fn>
+    void visit(Fn fn) const {
+        visit(lower_(std::numeric_limits<int>::min()), upper_(std::numeric_limits<int>::max()), fn);
+    }
+
+    /// Returns the number of references to the instance
+    size_t count(int referenced) const;
+
+    bool empty() const {
+        return keys_.empty() && overlay_.empty() && pending_.empty();
+    }
+
+    void clear();
+
+    /// Returns an estimate of the number of bytes held by the index
+    size_t memory_usage() const;
+};
+
+} // namespace IfcParse
+
+#endif
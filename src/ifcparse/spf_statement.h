@@ -0,0 +1,103 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef SPF_STATEMENT_H
+#define SPF_STATEMENT_H
+
+#include <cstring>
+#include <string>
+
+namespace IfcParse {
+
+/// Routines to delimit the statements of an SPF file held in a buffer,
+/// without tokenizing them.
+namespace spf_statement {
+    constexpr size_t npos = std::string::npos;
+
+    inline bool is_whitespace(char c) {
+        return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+    }
+
+    // Returns the offset past the end of the comment starting at offset, or
+    // npos if the comment does not end within length
+    inline size_t skip_comment(const char* data, size_t length, size_t offset) {
+        for (offset += 2; offset + 1 < length; ++offset) {
+            if (data[offset] == '*' && data[offset + 1] == '/') {
+                return offset + 2;
+            }
+        }
+        return npos;
+    }
+
+    // Advances offset past whitespace and comments. Returns false if the
+    // data ends within a comment, or before it can be told whether a comment
+    // starts.
+    inline bool skip_whitespace_and_comments(const char* data, size_t length, size_t& offset) {
+        while (offset < length) {
+            if (is_whitespace(data[offset])) {
+                ++offset;
+            } else if (data[offset] == '/') {
+                if (offset + 1 == length) {
+                    return false;
+                }
+                if (data[offset + 1] != '*') {
+                    return true;
+                }
+                offset = skip_comment(data, length, offset);
+                if (offset == npos) {
+                    return false;
+                }
+            } else {
+                break;
+            }
+        }
+        return true;
+    }
+
+    // Returns the offset past the semicolon that ends the statement starting
+    // at offset, or npos if the statement does not end within length
+    inline size_t find_statement_end(const char* data, size_t length, size_t offset) {
+        while (offset < length) {
+            const char c = data[offset];
+            if (c == '\'') {
+                // A quote within a string is escaped by doubling, which is
+                // treated as the end of one string and the start of another
+                const void* quote = memchr(data + offset + 1, '\'', length - offset - 1);
+                if (quote == nullptr) {
+                    return npos;
+                }
+                offset = static_cast<const char*>(quote) - data + 1;
+            } else if (c == ';') {
+                return offset + 1;
+            } else if (c == '/' && offset + 1 < length && data[offset + 1] == '*') {
+                offset = skip_comment(data, length, offset);
+                if (offset == npos) {
+                    return npos;
+                }
+            } else {
+                ++offset;
+            }
+        }
+        return npos;
+    }
+} // namespace spf_statement
+
+} // namespace IfcParse
+
+#endif
@@ -0,0 +1,80 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#include "string_pool.h"
+
+using namespace IfcParse;
+
+namespace {
+    thread_local string_pool* current_pool = nullptr;
+
+    // The size of a separately stored copy of s, including the characters
+    // when these do not fit in the string object itself
+    size_t storage_size(const std::string& s) {
+        static const size_t small_string_capacity = std::string().capacity();
+        return sizeof(std::string) + (s.size() > small_string_capacity ? s.size() + 1 : 0);
+    }
+}
+
+string_pool::scope::scope(string_pool* pool)
+    : previous_(current_pool)
+{
+    current_pool = pool;
+}
+
+string_pool::scope::~scope() {
+    current_pool = previous_;
+}
+
+const std::string* string_pool::intern(const std::string& s) {
+    stats_.references += 1;
+    auto it = strings_.find(s);
+    if (it != strings_.end()) {
+        stats_.bytes_saved += storage_size(s);
+    } else {
+        it = strings_.insert(s).first;
+        stats_.strings += 1;
+        stats_.bytes += storage_size(s);
+    }
+    return &*it;
+}
+
+void string_pool::splice(string_pool& other) {
+    // Nodes are transferred, so that the strings do not move
+    strings_.merge(other.strings_);
+    if (!other.strings_.empty()) {
+        adopted_.push_back(std::move(other.strings_));
+    }
+    for (auto& s : other.adopted_) {
+        adopted_.push_back(std::move(s));
+    }
+
+    stats_.references += other.stats_.references;
+    stats_.strings += other.stats_.strings;
+    stats_.bytes += other.stats_.bytes;
+    stats_.bytes_saved += other.stats_.bytes_saved;
+
+    other.strings_.clear();
+    other.adopted_.clear();
+    other.stats_ = {0, 0, 0, 0};
+}
+
+string_pool* string_pool::current() {
+    return current_pool;
+}
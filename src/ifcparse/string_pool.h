@@ -0,0 +1,95 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include "ifc_parse_api.h"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace IfcParse {
+
+/// Stores a single copy of every distinct string value, so that attributes
+/// with the same value can refer to the same storage. Interned strings remain
+/// at the same address for the lifetime of the pool.
+///
+/// Like arena, the pool is selected for the calling thread by creating a
+/// string_pool::scope, after which the parser interns the string attribute
+/// values it reads.
+class IFC_PARSE_API string_pool {
+  public:
+    struct statistics {
+        /// Number of string values interned
+        size_t references;
+        /// Number of distinct strings stored
+        size_t strings;
+        /// Approximate number of bytes occupied by the distinct strings
+        size_t bytes;
+        /// Approximate number of bytes that would have been occupied by the
+        /// other references when stored as separate copies
+        size_t bytes_saved;
+    };
+
+    /// Makes the pool, which may be nullptr, the one returned by
+    /// string_pool::current() on the calling thread for the lifetime of the scope
+    class IFC_PARSE_API scope {
+      private:
+        string_pool* previous_;
+
+      public:
+        explicit scope(string_pool* pool);
+        ~scope();
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+    };
+
+  private:
+    typedef std::unordered_set<std::string> set_t;
+
+    set_t strings_;
+    // Sets taken over from other pools by splice() with strings that were
+    // already present in this pool
+    std::vector<set_t> adopted_;
+    statistics stats_ = {0, 0, 0, 0};
+
+  public:
+    string_pool() = default;
+
+    string_pool(const string_pool&) = delete;
+    string_pool& operator=(const string_pool&) = delete;
+
+    /// Returns the stored copy of s
+    const std::string* intern(const std::string& s);
+
+    /// Takes over the strings interned in other, e.g. by a different thread
+    void splice(string_pool& other);
+
+    const statistics& stats() const { return stats_; }
+
+    /// Returns the pool in scope on the calling thread, or nullptr
+    static string_pool* current();
+};
+
+} // namespace IfcParse
+
+#endif
@@ -22,6 +22,11 @@ A dynamic sequence of variant types arranged in a way to reduce size impact due
 to alignment by grouping the 1 byte type indices. Using heap allocation - hence
 storing a pointer instead - for larger types so that the overall size of the
 variant - which is the maximum size of its constituents - is reduced.
+
+The type indices and values are stored in a single block. This block and the
+larger types are allocated using IfcParse::arena, so that they are placed in
+the arena of the file being read, if any. Larger types can also refer to a
+value owned elsewhere, which is flagged in the high bit of the type index.
 */
 
 #ifndef VARIANTARRAY_H
@@ -35,6 +40,7 @@ variant - which is the maximum size of its constituents - is reduced.
 #include <tuple>
 
 #include "IfcException.h"
+#include "arena.h"
 
 namespace impl {
     // Trait to detect unique_ptr
@@ -74,6 +80,15 @@ namespace impl {
     template <typename T, typename... Ts>
     constexpr std::size_t TypeIndex_v = TypeIndex<T, Ts...>::value;
 
+    // Deleter for the larger types allocated using IfcParse::arena
+    template <typename T>
+    struct arena_delete {
+        void operator()(T* t) const {
+            t->~T();
+            IfcParse::arena::deallocate(t);
+        }
+    };
+
     // Trait to determine if a type is small enough to be stored directly
     template <typename T>
     struct is_small_object {
@@ -86,7 +101,7 @@ namespace impl {
         using type = typename std::conditional<
             is_small_object<T>::value,
             T,
-            std::unique_ptr<T>
+            std::unique_ptr<T, arena_delete<T>>
         >::type;
     };
 
@@ -131,11 +146,11 @@ public:
     using TypesTuple = ::impl::MapTypes_t<Types...>;
 
     VariantArray(size_t size)
-        : size_and_indices_(new uint8_t[size + 1])
-        , storage_(size ? new StorageType[size] : nullptr)
+        : size_and_indices_(static_cast<uint8_t*>(IfcParse::arena::allocate(storage_offset_(size) + sizeof(StorageType) * size)))
+        , storage_(size ? reinterpret_cast<StorageType*>(size_and_indices_ + storage_offset_(size)) : nullptr)
     {
+        size_and_indices_[0] = (uint8_t)size;
         if (size) {
-            size_and_indices_[0] = (uint8_t)size;
             memset(size_and_indices_ + 1, 0, sizeof(uint8_t) * size);
             for (size_t i = 0; i < size; ++i) {
                 // type 0 needs to be default constructable
@@ -183,18 +198,38 @@ public:
         using V = typename std::tuple_element<::impl::TypeIndex_v<U, Types...>, ::impl::MapTypes_t<Types... >>::type;
         // std::wcout << "setting " << index << " to " << typeid(V).name() << " (" << ::impl::TypeIndex_v<U, Types...> << ")" << std::endl;
         if constexpr (::impl::is_unique_ptr<V>::value) {
-            new(&storage_[index]) V(new U(value));
+            new(&storage_[index]) V(new (IfcParse::arena::allocate(sizeof(U))) U(std::forward<T>(value)));
         } else {
             new(&storage_[index]) U(std::forward<T>(value));
         }
     }
 
+    /// Stores a reference to value, which is not copied and not destroyed
+    /// with the array, so it needs to outlive it. The non-const get() copies
+    /// the value into the array first, so that modifications do not affect
+    /// other arrays referring to it. Only for the larger types that are
+    /// stored by pointer.
+    template<typename T>
+    void set_shared(std::size_t index, const T* value) {
+        static_assert(::impl::TypeIndex_v<T, Types...> < sizeof...(Types), "Type not supported by variant");
+        using V = typename std::tuple_element<::impl::TypeIndex_v<T, Types...>, ::impl::MapTypes_t<Types... >>::type;
+        static_assert(::impl::is_unique_ptr<V>::value, "Only types stored by pointer can be shared");
+        if (index >= size_and_indices_[0]) {
+            throw std::out_of_range("Index out of range");
+        }
+
+        destroy_at_index(index);
+
+        size_and_indices_[index + 1] = ::impl::TypeIndex_v<T, Types...> | shared_flag_;
+        new(&storage_[index]) V(const_cast<T*>(value));
+    }
+
     ~VariantArray() {
         free_();
     }
 
     std::size_t index(std::size_t index) const noexcept {
-        return size_and_indices_[index + 1];
+        return type_index_(index);
     }
 
     template<typename T>
@@ -204,6 +239,11 @@ public:
         }
         using V = typename std::tuple_element<::impl::TypeIndex_v<T, Types...>, ::impl::MapTypes_t<Types... >>::type;
         if constexpr (::impl::is_unique_ptr<V>::value) {
+            if (is_shared(index)) {
+                // Copy on write, the shared value may be referred to by other arrays
+                T copy = **reinterpret_cast<V*>(&storage_[index]);
+                set(index, std::move(copy));
+            }
             return **reinterpret_cast<V*>(&storage_[index]);
         } else {
             return *reinterpret_cast<V*>(&storage_[index]);
@@ -212,18 +252,18 @@ public:
 
     template<typename T>
     bool has(std::size_t index) const {
-        return size_and_indices_[index + 1] == ::impl::TypeIndex<T, Types...>::value;
+        return type_index_(index) == ::impl::TypeIndex<T, Types...>::value;
     }
 
     template<typename T>
     const T& get(std::size_t index) const {
-        if (size_and_indices_[index + 1] != ::impl::TypeIndex<T, Types...>::value) {
+        if (type_index_(index) != ::impl::TypeIndex<T, Types...>::value) {
             // @todo this IfcException is silly. Figure out what
             // to do, but at the moment it is specifically caught
             // in various places.
             throw IfcParse::IfcException(
                 "Type held at index " + std::to_string(index) + " is " +
-                get_type_name(size_and_indices_[index + 1]) + " and not " + typeid(T).name()
+                get_type_name(type_index_(index)) + " and not " + typeid(T).name()
             );
         }
         using V = typename std::tuple_element<::impl::TypeIndex_v<T, Types...>, ::impl::MapTypes_t<Types... >>::type;
@@ -243,12 +283,50 @@ public:
         return size_and_indices_ ? size_and_indices_[0] : 0;
     }
 
+    /// Whether the value at index was stored by set_shared()
+    bool is_shared(std::size_t index) const noexcept {
+        return (size_and_indices_[index + 1] & shared_flag_) != 0;
+    }
+
+    /// Returns the number of bytes occupied by the array: the block with the
+    /// type indices and values, and the larger types stored by pointer that
+    /// are not shared. Memory held by the values themselves, e.g. the elements
+    /// of a vector, is not included.
+    std::size_t memory_usage() const {
+        if (!size_and_indices_) {
+            return 0;
+        }
+        std::size_t n = storage_offset_(size());
+        for (std::size_t i = 0, count = (std::size_t) size(); i < count; ++i) {
+            n += memory_usage(i);
+        }
+        return n;
+    }
+
+    /// Returns the number of bytes occupied by the value at index in the
+    /// array, see memory_usage()
+    std::size_t memory_usage(std::size_t index) const {
+        return sizeof(StorageType) + (is_shared(index) ? 0 : pointee_size_(index, std::integral_constant<std::size_t, sizeof...(Types)>{}));
+    }
+
 private:
     using StorageType = typename ::impl::make_union_from_tuple<::impl::MapTypes_t<Types...>>::type;
 
     uint8_t* size_and_indices_;
     StorageType* storage_;
 
+    static constexpr uint8_t shared_flag_ = 0x80;
+    static_assert(sizeof...(Types) < shared_flag_, "Too many types for variant");
+
+    std::size_t type_index_(std::size_t index) const noexcept {
+        return size_and_indices_[index + 1] & ~shared_flag_;
+    }
+
+    // The values follow the type indices, aligned for StorageType
+    static std::size_t storage_offset_(std::size_t size) {
+        return (size + 1 + alignof(StorageType) - 1) / alignof(StorageType) * alignof(StorageType);
+    }
+
     void destroy_at_index(std::size_t index) {
         destroy_type_at_index(index, std::integral_constant<std::size_t, sizeof...(Types)>{});
     }
@@ -258,15 +336,19 @@ private:
             for (std::size_t i = 0; i < size_and_indices_[0]; ++i) {
                 destroy_at_index(i);
             }
-            delete[] size_and_indices_;
-            delete[] storage_;
+            IfcParse::arena::deallocate(size_and_indices_);
         }
     }
 
     template<std::size_t Index>
     void destroy_type_at_index(std::size_t index, std::integral_constant<std::size_t, Index>) {
-        if (size_and_indices_[index + 1] == Index - 1) {
+        if (type_index_(index) == Index - 1) {
             using T = typename std::tuple_element_t<Index - 1, ::impl::MapTypes_t<Types...>>;
+            if constexpr (::impl::is_unique_ptr<T>::value) {
+                if (size_and_indices_[index + 1] & shared_flag_) {
+                    reinterpret_cast<T*>(&storage_[index])->release();
+                }
+            }
             if constexpr (!std::is_trivially_destructible<T>::value) {
                 reinterpret_cast<T*>(&storage_[index])->~T();
             }
@@ -278,9 +360,25 @@ private:
 
     void destroy_type_at_index(std::size_t, std::integral_constant<std::size_t, 0>) {}
 
+    template<std::size_t Index>
+    std::size_t pointee_size_(std::size_t index, std::integral_constant<std::size_t, Index>) const {
+        if (type_index_(index) == Index - 1) {
+            if constexpr (::impl::is_unique_ptr<typename std::tuple_element_t<Index - 1, ::impl::MapTypes_t<Types...>>>::value) {
+                return sizeof(std::tuple_element_t<Index - 1, std::tuple<Types...>>);
+            } else {
+                return 0;
+            }
+        }
+        return pointee_size_(index, std::integral_constant<std::size_t, Index - 1>{});
+    }
+
+    std::size_t pointee_size_(std::size_t, std::integral_constant<std::size_t, 0>) const {
+        return 0;
+    }
+
     template<typename Visitor, std::size_t Index>
     auto apply_visitor_impl(Visitor&& visitor, std::size_t idx, std::integral_constant<std::size_t, Index>) const {
-        if (size_and_indices_[idx + 1] == Index - 1) {
+        if (type_index_(idx) == Index - 1) {
             using T = typename std::tuple_element_t<Index - 1, ::impl::MapTypes_t<Types...>>;
             if constexpr (::impl::is_unique_ptr<T>::value) {
                 return visitor(**reinterpret_cast<T*>(&storage_[idx]));
@@ -101,6 +101,12 @@ std::pair<char const*, size_t> vector_to_buffer(const T& t) {
 
 %ignore ifcopenshell::geometry::taxonomy::item::print;
 
+%ignore IfcGeom::task_cost_estimator;
+%ignore IfcGeom::Iterator::set_recorded_timings(const std::map<std::string, double>&);
+%ignore ifcopenshell::geometry::Converter::brep_cache;
+%ignore ifcopenshell::geometry::Converter::share_caches;
+%ignore ifcopenshell::geometry::Converter::take_timed_out_elements;
+
 %typemap(out) boost::variant<boost::blank, ifcopenshell::geometry::taxonomy::point3::ptr, double> {
 	if ($1.which() == 0) {
 		Py_INCREF(Py_None);
@@ -238,11 +244,14 @@ namespace {
 
 %include "../ifcgeom/ifc_geom_api.h"
 %include "../ifcgeom/Converter.h"
+%template(timed_out_elements) std::vector<ifcopenshell::geometry::timed_out_element>;
 %include "../ifcgeom/ConversionResult.h"
 %include "../ifcgeom/IteratorSettings.h"
 %include "../ifcgeom/ConversionSettings.h"
 %include "../ifcgeom/IfcGeomElement.h"
 %include "../ifcgeom/IfcGeomRepresentation.h"
+%include "../ifcgeom/task_cost_estimator.h"
+%template(task_costs) std::vector<IfcGeom::task_cost>;
 %include "../ifcgeom/Iterator.h"
 %include "../ifcgeom/GeometrySerializer.h"
 %include "../ifcgeom/taxonomy.h"
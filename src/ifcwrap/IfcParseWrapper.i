@@ -46,7 +46,35 @@ private:
 
 %ignore IfcParse::IfcFile::type_iterator;
 
+// The IfcFile* returned by read_snapshot() is to be freed by SWIG/Python
+%newobject IfcParse::IfcFile::read_snapshot;
+
 %ignore IfcUtil::IfcBaseClass::is;
+%ignore IfcUtil::IfcBaseClass::operator new;
+%ignore IfcUtil::IfcBaseClass::operator delete;
+
+// The arena in which instances are allocated and the string pool are not exposed to Python
+// Committed versions of a file are only available in C++, IfcFileView is not wrapped
+%ignore IfcParse::IfcFile::commit;
+%ignore IfcParse::IfcFile::view;
+
+// Exposed as write_incremental() and journal_diff() below
+%ignore IfcParse::IfcFile::journal;
+
+%ignore IfcParse::IfcFile::allocation_statistics;
+%ignore IfcParse::IfcFile::string_statistics;
+
+// Exposed as memory_usage() below
+%ignore IfcParse::IfcFile::memory_statistics;
+%ignore IfcParse::file_memory_statistics;
+
+// Exposed as by_guids() below, as an aggregate_of_instance cannot hold the
+// nullptr entries for GlobalIds that are not found
+%ignore IfcParse::IfcFile::instances_by_guid;
+%ignore IfcParse::IfcFile::internal_guid_map;
+
+// Attributes are accessed by name or index from Python
+%ignore IfcUtil::IfcBaseEntity::get(const IfcParse::attribute_handle&) const;
 
 %rename("by_id") instance_by_id;
 %rename("by_type") instances_by_type;
@@ -90,6 +118,7 @@ PyObject* get_feature(const std::string& x) {
 %}
 
 %{
+#include "../ifcparse/IfcSpfWriter.h"
 
 static const std::string& helper_fn_declaration_get_name(const IfcParse::declaration* decl) {
 	return decl->name();
@@ -127,6 +156,16 @@ static IfcUtil::ArgumentType helper_fn_attribute_type(const IfcUtil::IfcBaseClas
 	IfcUtil::IfcBaseClass* by_guid(const std::string& guid) {
 		return $self->instance_by_guid(guid);
 	}
+
+	PyObject* by_guids(const std::vector<std::string>& guids) {
+		const std::vector<IfcUtil::IfcBaseClass*> instances = $self->instances_by_guid(guids);
+		PyObject* result = PyTuple_New(instances.size());
+		for (size_t i = 0; i < instances.size(); ++i) {
+			// A nullptr is converted to None
+			PyTuple_SetItem(result, i, pythonize(instances[i]));
+		}
+		return result;
+	}
 	
 	aggregate_of_instance::ptr get_inverse(IfcUtil::IfcBaseClass* e) {
 		return $self->getInverse(e->as<IfcUtil::IfcBaseEntity>()->id(), 0, -1);
@@ -151,6 +190,65 @@ static IfcUtil::ArgumentType helper_fn_attribute_type(const IfcUtil::IfcBaseClas
 		return s.str();
 	}
 
+	// Writes the file to fn by copying the file at original_fn, which it was
+	// read from, and only rewriting the instances recorded in the journal
+	void write_incremental(const std::string& fn, const std::string& original_fn) {
+		IfcParse::IfcSpfStream original(original_fn);
+		if (!original.valid) {
+			throw IfcParse::IfcException("Unable to open " + original_fn);
+		}
+		std::ofstream f(IfcUtil::path::from_utf8(fn).c_str(), std::ios::binary);
+		IfcParse::IfcSpfWriter(*$self).write_incremental(f, original);
+	}
+
+	std::string journal_diff() const {
+		std::stringstream s;
+		IfcParse::IfcSpfWriter(*$self).write_diff(s);
+		return s.str();
+	}
+
+	// Returns the estimated number of bytes held by the file as a dict by
+	// category, with the instances by entity name and the attribute values
+	// by value type, e.g. {"instances": {"IfcWall": 1234}, "attributes":
+	// {"STRING": 5678}, "inverse_index": 910, ..., "total": 12345}
+	PyObject* memory_usage() const {
+		IfcParse::file_memory_statistics stats = $self->memory_statistics();
+		PyObject* instances = PyDict_New();
+		for (const auto& p : stats.instances) {
+			PyObject* v = PyLong_FromSize_t(p.second);
+			PyDict_SetItemString(instances, p.first->name().c_str(), v);
+			Py_DECREF(v);
+		}
+		PyObject* attributes = PyDict_New();
+		for (const auto& p : stats.attributes) {
+			PyObject* v = PyLong_FromSize_t(p.second);
+			PyDict_SetItemString(attributes, IfcUtil::ArgumentTypeToString(p.first), v);
+			Py_DECREF(v);
+		}
+		PyObject* result = PyDict_New();
+		PyDict_SetItemString(result, "instances", instances);
+		Py_DECREF(instances);
+		PyDict_SetItemString(result, "attributes", attributes);
+		Py_DECREF(attributes);
+		const std::pair<const char*, size_t> totals[] = {
+			{"inverse_index", stats.inverse_index},
+			{"guid_map", stats.guid_map},
+			{"instance_maps", stats.instance_maps},
+			{"header", stats.header},
+			{"stream", stats.stream},
+			{"strings", stats.strings},
+			{"arena_unused", stats.arena_unused},
+			{"journal", stats.journal},
+			{"total", stats.total()}
+		};
+		for (const auto& p : totals) {
+			PyObject* v = PyLong_FromSize_t(p.second);
+			PyDict_SetItemString(result, p.first, v);
+			Py_DECREF(v);
+		}
+		return result;
+	}
+
 	std::vector<unsigned> entity_names() const {
 		std::vector<unsigned> keys;
 		keys.reserve(std::distance($self->begin(), $self->end()));
@@ -197,24 +295,12 @@ static IfcUtil::ArgumentType helper_fn_attribute_type(const IfcUtil::IfcBaseClas
 			return name == "wrappedValue";
 		}
 		
-		{
-		const std::vector<const IfcParse::attribute*> attrs = $self->declaration().as_entity()->all_attributes();
-		std::vector<const IfcParse::attribute*>::const_iterator it = attrs.begin();
-		for (; it != attrs.end(); ++it) {
-			if ((*it)->name() == name) {
-				return 1;
-			}
-		}
+		if ($self->declaration().as_entity()->attribute_index(name) != -1) {
+			return 1;
 		}
 
-		{
-		const std::vector<const IfcParse::inverse_attribute*> attrs = $self->declaration().as_entity()->all_inverse_attributes();
-		std::vector<const IfcParse::inverse_attribute*>::const_iterator it = attrs.begin();
-		for (; it != attrs.end(); ++it) {
-			if ((*it)->name() == name) {
-				return 2;
-			}
-		}
+		if ($self->declaration().as_entity()->inverse_attribute_by_name(name) != nullptr) {
+			return 2;
 		}
 
 		return 0;
@@ -242,7 +328,7 @@ static IfcUtil::ArgumentType helper_fn_attribute_type(const IfcUtil::IfcBaseClas
 			return std::vector<std::string>(1, "wrappedValue");
 		}
 		
-		const std::vector<const IfcParse::attribute*> attrs = $self->declaration().as_entity()->all_attributes();
+		const std::vector<const IfcParse::attribute*>& attrs = $self->declaration().as_entity()->all_attributes();
 		
 		std::vector<std::string> attr_names;
 		attr_names.reserve(attrs.size());		
@@ -260,7 +346,7 @@ static IfcUtil::ArgumentType helper_fn_attribute_type(const IfcUtil::IfcBaseClas
 			return std::vector<std::string>(0);
 		}
 
-		const std::vector<const IfcParse::inverse_attribute*> attrs = $self->declaration().as_entity()->all_inverse_attributes();
+		const std::vector<const IfcParse::inverse_attribute*>& attrs = $self->declaration().as_entity()->all_inverse_attributes();
 		
 		std::vector<std::string> attr_names;
 		attr_names.reserve(attrs.size());		
@@ -810,7 +896,7 @@ static IfcUtil::ArgumentType helper_fn_attribute_type(const IfcUtil::IfcBaseClas
 		PyObject *d = PyDict_New();
 
 		if (v->declaration().as_entity()) {
-			const std::vector<const IfcParse::attribute*> attrs = v->declaration().as_entity()->all_attributes();
+			const std::vector<const IfcParse::attribute*>& attrs = v->declaration().as_entity()->all_attributes();
 			std::vector<const IfcParse::attribute*>::const_iterator it = attrs.begin();
 			auto dit = v->declaration().as_entity()->derived().begin();
 			for (; it != attrs.end(); ++it, ++dit) {
@@ -202,6 +202,21 @@
 		return pyobj;
 	}
 
+	template <typename T>
+	PyObject* pythonize(const flat_aggregate_of_aggregate<T>& t) {
+		const size_t size = t.size();
+		PyObject* pyobj = PyTuple_New(size);
+		for (size_t i = 0; i < size; ++i) {
+			auto inner = t[i];
+			PyObject* pyinner = PyTuple_New(inner.size());
+			for (size_t j = 0; j < inner.size(); ++j) {
+				PyTuple_SetItem(pyinner, j, pythonize(inner[j]));
+			}
+			PyTuple_SetItem(pyobj, i, pyinner);
+		}
+		return pyobj;
+	}
+
 	PyObject* pythonize(const aggregate_of_aggregate_of_instance::ptr& t) {
 		unsigned int i = 0;
 		PyObject* pyobj = PyTuple_New(t->size());
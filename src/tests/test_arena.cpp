@@ -0,0 +1,70 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#define BOOST_TEST_MODULE arena
+#include <boost/test/included/unit_test.hpp>
+
+#include "test_utils.h"
+
+#include "../ifcparse/arena.h"
+
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(shared_allocation_outlives_arena) {
+	boost::shared_ptr<std::vector<int>> v;
+	{
+		IfcParse::arena a;
+		IfcParse::arena::scope scope(a);
+		v = IfcParse::make_shared_in_arena<std::vector<int>>(3, 7);
+	}
+	BOOST_CHECK_EQUAL(v->size(), 3);
+	BOOST_CHECK_EQUAL(v->at(2), 7);
+}
+
+BOOST_AUTO_TEST_CASE(shared_allocation_outlives_spliced_arena) {
+	boost::shared_ptr<std::vector<int>> v;
+	{
+		IfcParse::arena a;
+		{
+			IfcParse::arena b;
+			{
+				IfcParse::arena::scope scope(b);
+				v = IfcParse::make_shared_in_arena<std::vector<int>>(2, 5);
+			}
+			a.splice(b);
+		}
+		BOOST_CHECK_EQUAL(v->at(1), 5);
+	}
+	BOOST_CHECK_EQUAL(v->at(1), 5);
+}
+
+BOOST_AUTO_TEST_CASE(aggregate_outlives_file) {
+	aggregate_of_instance::ptr points;
+	{
+		auto file = test_utils::parse(
+			"#1=IFCCARTESIANPOINT((0.,0.,0.));\n"
+			"#2=IFCCARTESIANPOINT((1.,0.,0.));\n"
+			"#3=IFCPOLYLINE((#1,#2));\n");
+		points = file->instance_by_id(3)->as<IfcUtil::IfcBaseEntity>()->get("Points");
+		BOOST_REQUIRE_EQUAL(points->size(), 2);
+	}
+	// The instances are gone with the file, but the aggregate itself is intact
+	BOOST_CHECK_EQUAL(points->size(), 2);
+	points.reset();
+}
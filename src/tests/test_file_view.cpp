@@ -0,0 +1,96 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+
+#define BOOST_TEST_MODULE file_view
+#include <boost/test/included/unit_test.hpp>
+
+#include "test_utils.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+	const std::string data =
+		"#1=IFCCARTESIANPOINT((0.,0.));\n"
+		"#2=IFCCARTESIANPOINT((1.,0.));\n"
+		"#3=IFCPOLYLINE((#1,#2));\n"
+		"#4=IFCORGANIZATION($,'Acme',$,$,$);\n";
+
+	std::string name_of(const IfcParse::IfcFileView& view, unsigned id) {
+		return view.instance_by_id(id)->get_attribute_value(1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(views_are_not_affected_by_modifications) {
+	auto file = test_utils::parse(data);
+	auto first = file->commit();
+	BOOST_CHECK_EQUAL(first->version(), 1U);
+	BOOST_CHECK_EQUAL(first->size(), 4U);
+
+	file->instance_by_id(4)->set_attribute_value(1, std::string("Changed"));
+	file->removeEntity(file->instance_by_id(3));
+	BOOST_CHECK_EQUAL(name_of(*first, 4), "Acme");
+	BOOST_CHECK(first->instance_by_id(3) != nullptr);
+
+	auto second = file->commit();
+	BOOST_CHECK(file->view() == second);
+	BOOST_CHECK_EQUAL(second->version(), 2U);
+	BOOST_CHECK_EQUAL(second->size(), 3U);
+	BOOST_CHECK_EQUAL(name_of(*second, 4), "Changed");
+	BOOST_CHECK_THROW(second->instance_by_id(3), IfcParse::IfcException);
+	BOOST_CHECK(second->instances_by_reference(1).empty());
+
+	BOOST_CHECK_EQUAL(name_of(*first, 4), "Acme");
+	BOOST_CHECK_EQUAL(first->instances_by_reference(1).size(), 1U);
+	BOOST_CHECK_EQUAL(first->instances_by_type("IfcPolyline").size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(unmodified_instances_are_shared_between_versions) {
+	auto file = test_utils::parse(data);
+	auto first = file->commit();
+	file->instance_by_id(4)->set_attribute_value(1, std::string("Changed"));
+	auto second = file->commit();
+	BOOST_CHECK(first->instance_by_id(1) == second->instance_by_id(1));
+	BOOST_CHECK(first->instance_by_id(4) != second->instance_by_id(4));
+}
+
+BOOST_AUTO_TEST_CASE(references_are_resolved_within_the_view) {
+	auto file = test_utils::parse(data);
+	auto view = file->commit();
+	aggregate_of_instance::ptr points = view->instance_by_id(3)->get_attribute_value(0);
+	BOOST_REQUIRE_EQUAL(points->size(), 2U);
+	const auto* point = view->resolve(*points->begin());
+	BOOST_REQUIRE(point != nullptr);
+	BOOST_CHECK_EQUAL(point->id(), 1U);
+	BOOST_CHECK_EQUAL(point->declaration().name(), "IfcCartesianPoint");
+}
+
+BOOST_AUTO_TEST_CASE(views_outlive_the_file) {
+	auto file = test_utils::parse(data);
+	auto view = file->commit();
+	file.reset();
+	BOOST_CHECK_EQUAL(name_of(*view, 4), "Acme");
+	aggregate_of_instance::ptr points = view->instance_by_id(3)->get_attribute_value(0);
+	BOOST_REQUIRE_EQUAL(points->size(), 2U);
+	const auto* point = view->resolve(*points->begin());
+	BOOST_REQUIRE(point != nullptr);
+	std::vector<double> coordinates = point->get_attribute_value(0);
+	BOOST_CHECK((coordinates == std::vector<double>{0., 0.}));
+}
@@ -0,0 +1,89 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+
+#define BOOST_TEST_MODULE inverse_index
+#include <boost/test/included/unit_test.hpp>
+
+#include "test_utils.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+	// Sets the number of parse threads for the lifetime of the scope
+	struct parse_threads {
+		unsigned previous;
+		explicit parse_threads(unsigned n) : previous(IfcParse::IfcFile::parse_threads()) { IfcParse::IfcFile::parse_threads(n); }
+		~parse_threads() { IfcParse::IfcFile::parse_threads(previous); }
+	};
+
+	// Enough polylines for the data section to be read in several chunks and
+	// for the references to be sorted on several threads. Every polyline
+	// refers to a point before it, a point elsewhere in the file and a point
+	// after it.
+	const size_t num_polylines = 60000;
+
+	std::string polylines() {
+		std::string data;
+		for (size_t i = 0; i < num_polylines; ++i) {
+			const size_t other = i * 7919 % num_polylines;
+			const size_t next = (i + 1) % num_polylines;
+			data += "#" + std::to_string(2 * i + 1) + "=IFCCARTESIANPOINT((" + std::to_string(i) + ".,0.,0.));\n";
+			data += "#" + std::to_string(2 * i + 2) + "=IFCPOLYLINE((#" + std::to_string(2 * i + 1) + ",#" + std::to_string(2 * other + 1) + ",#" + std::to_string(2 * next + 1) + "));\n";
+		}
+		return data;
+	}
+
+	std::vector<int> referring_ids(IfcParse::IfcFile& file, int id) {
+		std::vector<int> ids;
+		auto refs = file.instances_by_reference(id);
+		for (auto* inst : *refs) {
+			ids.push_back((int) inst->id());
+		}
+		return ids;
+	}
+}
+
+BOOST_AUTO_TEST_CASE(parallel_build_equals_serial_build) {
+	const std::string data = polylines();
+
+	std::unique_ptr<IfcParse::IfcFile> serial, parallel;
+	{
+		parse_threads scope(1);
+		serial = test_utils::parse(data);
+	}
+	{
+		parse_threads scope(4);
+		parallel = test_utils::parse(data);
+	}
+
+	for (size_t i = 0; i < num_polylines; ++i) {
+		const int point = (int) (2 * i + 1);
+		const auto expected = referring_ids(*serial, point);
+		const auto actual = referring_ids(*parallel, point);
+		BOOST_REQUIRE_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+	}
+
+	for (int point : { 1, 2 * 1234 + 1, (int) (2 * num_polylines - 1) }) {
+		const auto expected = serial->get_inverse_indices(point);
+		const auto actual = parallel->get_inverse_indices(point);
+		BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+	}
+}
@@ -0,0 +1,139 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+
+#define BOOST_TEST_MODULE spf_reader
+#include <boost/test/included/unit_test.hpp>
+
+#include "test_utils.h"
+#include "../ifcparse/IfcSpfReader.h"
+
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+	const std::string polyline =
+		"#1=IFCCARTESIANPOINT((0.,0.));\n"
+		"#2=IFCCARTESIANPOINT((1.,0.));\n"
+		"#3=IFCPOLYLINE((#1,#2,#5));\n"
+		"#4=IFCORGANIZATION($,'Acme',$,$,$);\n"
+		"#5=IFCCARTESIANPOINT((1.,1.));\n";
+
+	// Reads the data section and returns the names and types of the visited instances
+	std::vector<std::pair<unsigned, std::string>> visit(const std::string& data_section) {
+		std::istringstream stream(test_utils::spf(data_section));
+		IfcParse::IfcSpfReader reader(stream);
+		std::vector<std::pair<unsigned, std::string>> visited;
+		reader.read([&visited](IfcParse::IfcSpfReader::instance& inst) {
+			visited.emplace_back(inst.id(), inst.declaration().name());
+		});
+		return visited;
+	}
+}
+
+BOOST_AUTO_TEST_CASE(instances_are_visited_in_file_order) {
+	std::istringstream stream(test_utils::spf(polyline));
+	IfcParse::IfcSpfReader reader(stream);
+	BOOST_REQUIRE(reader.good());
+	BOOST_CHECK_EQUAL(reader.schema()->name(), "IFC4");
+
+	std::vector<unsigned> ids;
+	const size_t n = reader.read([&ids](IfcParse::IfcSpfReader::instance& inst) {
+		ids.push_back(inst.id());
+	});
+	BOOST_CHECK_EQUAL(n, 5U);
+	BOOST_CHECK((ids == std::vector<unsigned>{1, 2, 3, 4, 5}));
+}
+
+BOOST_AUTO_TEST_CASE(attribute_values_are_decoded) {
+	std::istringstream stream(test_utils::spf(polyline));
+	IfcParse::IfcSpfReader reader(stream);
+	std::string name;
+	std::vector<double> coordinates;
+	reader.read([&](IfcParse::IfcSpfReader::instance& inst) {
+		if (inst.id() == 2) {
+			coordinates = inst.get_attribute_value(0);
+		} else if (inst.id() == 4) {
+			BOOST_CHECK(inst.get_attribute_value(0).isNull());
+			name = (std::string) inst.get_attribute_value(1);
+		}
+	});
+	BOOST_CHECK_EQUAL(name, "Acme");
+	BOOST_CHECK((coordinates == std::vector<double>{1., 0.}));
+}
+
+BOOST_AUTO_TEST_CASE(backward_references_are_resolved_from_the_cache) {
+	std::istringstream stream(test_utils::spf(
+		"#1=IFCCARTESIANPOINT((0.,0.));\n"
+		"#2=IFCCARTESIANPOINT((1.,0.));\n"
+		"#3=IFCPOLYLINE((#1,#2));\n"));
+	IfcParse::IfcSpfReader reader(stream);
+	reader.cache_size(2);
+	aggregate_of_instance::ptr points;
+	reader.read([&](IfcParse::IfcSpfReader::instance& inst) {
+		if (inst.id() == 3) {
+			BOOST_CHECK(reader.instance_by_id(1) != nullptr);
+			points = inst.get_attribute_value(0);
+		}
+	});
+	BOOST_REQUIRE(points);
+	BOOST_REQUIRE_EQUAL(points->size(), 2U);
+	BOOST_CHECK_EQUAL((*points->begin())->id(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(unresolved_references_are_reported) {
+	std::istringstream stream(test_utils::spf(polyline));
+	IfcParse::IfcSpfReader reader(stream);
+	std::vector<std::pair<size_t, unsigned>> references;
+	bool assigned = true;
+	reader.read([&](IfcParse::IfcSpfReader::instance& inst) {
+		if (inst.id() == 3) {
+			references = inst.references();
+			assigned = !inst.get_attribute_value(0).isNull();
+		}
+	});
+	// Without a cache #1 and #2 are gone and #5 is not read yet
+	BOOST_CHECK(!assigned);
+	BOOST_CHECK((references == std::vector<std::pair<size_t, unsigned>>{{0, 1}, {0, 2}, {0, 5}}));
+}
+
+BOOST_AUTO_TEST_CASE(reading_stops_after_the_current_callback) {
+	std::istringstream stream(test_utils::spf(polyline));
+	IfcParse::IfcSpfReader reader(stream);
+	const size_t n = reader.read([&reader](IfcParse::IfcSpfReader::instance& inst) {
+		if (inst.id() == 2) {
+			reader.stop();
+		}
+	});
+	BOOST_CHECK_EQUAL(n, 2U);
+}
+
+BOOST_AUTO_TEST_CASE(malformed_statements_are_skipped) {
+	const auto visited = visit(
+		"#1=IFCCARTESIANPOINT((0.,0.));\n"
+		"#12 ;\n"
+		"#;\n"
+		"#2=IFCCARTESIANPOINT((1.,0.));\n");
+	BOOST_REQUIRE_EQUAL(visited.size(), 2U);
+	BOOST_CHECK_EQUAL(visited[0].first, 1U);
+	BOOST_CHECK_EQUAL(visited[1].first, 2U);
+	BOOST_CHECK_EQUAL(visited[1].second, "IfcCartesianPoint");
+}
@@ -0,0 +1,62 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+
+#define BOOST_TEST_MODULE spf_writer
+#include <boost/test/included/unit_test.hpp>
+
+#include "test_utils.h"
+#include "../ifcparse/IfcSpfWriter.h"
+
+#include <sstream>
+#include <string>
+
+namespace {
+	// Instances of various types, more than are formatted in a single chunk
+	std::string instances(size_t n) {
+		std::string data;
+		for (size_t i = 0; i < n; ++i) {
+			const std::string id = std::to_string(4 * i + 1);
+			data += "#" + std::to_string(4 * i + 1) + "=IFCCARTESIANPOINT((" + std::to_string(i) + ".5,-1.E-05,0.));\n";
+			data += "#" + std::to_string(4 * i + 2) + "=IFCORGANIZATION($,'Organization \\X2\\00E9\\X0\\ " + std::to_string(i) + "',$,$,$);\n";
+			data += "#" + std::to_string(4 * i + 3) + "=IFCPOLYLINE((#" + id + ",#" + id + "));\n";
+			data += "#" + std::to_string(4 * i + 4) + "=IFCCARTESIANPOINTLIST2D(((0.,1.),(2.,3.)),$);\n";
+		}
+		return data;
+	}
+
+	std::string write(const IfcParse::IfcFile& file, unsigned threads) {
+		IfcParse::IfcSpfWriter writer(file);
+		writer.threads(threads);
+		std::ostringstream out;
+		writer.write(out);
+		return out.str();
+	}
+}
+
+BOOST_AUTO_TEST_CASE(output_does_not_depend_on_the_number_of_threads) {
+	for (size_t n : { 1, 100, 20000 }) {
+		auto file = test_utils::parse(instances(n));
+		const std::string expected = write(*file, 1);
+		BOOST_CHECK(expected.find("#" + std::to_string(4 * n) + "=IFCCARTESIANPOINTLIST2D") != std::string::npos);
+		for (unsigned threads : { 2, 3, 8 }) {
+			BOOST_CHECK(write(*file, threads) == expected);
+		}
+	}
+}
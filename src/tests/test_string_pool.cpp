@@ -0,0 +1,72 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+
+#define BOOST_TEST_MODULE string_pool
+#include <boost/test/included/unit_test.hpp>
+
+#include "test_utils.h"
+
+#include <string>
+
+namespace {
+	// Enables string interning for the lifetime of the scope
+	struct interning {
+		interning() { IfcParse::IfcFile::intern_strings(true); }
+		~interning() { IfcParse::IfcFile::intern_strings(false); }
+	};
+
+	const std::string organizations =
+		"#1=IFCORGANIZATION($,'Acme',$,$,$);\n"
+		"#2=IFCORGANIZATION($,'Acme',$,$,$);\n"
+		"#3=IFCORGANIZATION($,'Other',$,$,$);\n";
+
+	storage_t& storage_of(IfcParse::IfcFile& file, int id) {
+		return file.instance_by_id(id)->data().storage_;
+	}
+}
+
+BOOST_AUTO_TEST_CASE(equal_strings_are_stored_once) {
+	interning scope;
+	auto file = test_utils::parse(organizations);
+	const auto& a = storage_of(*file, 1);
+	const auto& b = storage_of(*file, 2);
+	BOOST_CHECK(a.is_shared(1));
+	BOOST_CHECK(b.is_shared(1));
+	BOOST_CHECK_EQUAL(&a.get<std::string>(1), &b.get<std::string>(1));
+	BOOST_CHECK_NE(&a.get<std::string>(1), &storage_of(*file, 3).get<std::string>(1));
+	BOOST_CHECK_EQUAL((std::string) file->instance_by_id(2)->as<IfcUtil::IfcBaseEntity>()->get("Name"), "Acme");
+}
+
+BOOST_AUTO_TEST_CASE(strings_are_not_interned_by_default) {
+	auto file = test_utils::parse(organizations);
+	BOOST_CHECK(!storage_of(*file, 1).is_shared(1));
+	BOOST_CHECK_EQUAL(storage_of(*file, 1).get<std::string>(1), "Acme");
+}
+
+BOOST_AUTO_TEST_CASE(writing_to_an_interned_string_copies_it) {
+	interning scope;
+	auto file = test_utils::parse(organizations);
+	auto& a = storage_of(*file, 1);
+	a.get<std::string>(1) = "Changed";
+	BOOST_CHECK(!a.is_shared(1));
+	BOOST_CHECK_EQUAL(a.get<std::string>(1), "Changed");
+	BOOST_CHECK(storage_of(*file, 2).is_shared(1));
+	BOOST_CHECK_EQUAL(static_cast<const storage_t&>(storage_of(*file, 2)).get<std::string>(1), "Acme");
+}
@@ -0,0 +1,59 @@
+/********************************************************************************
+ *                                                                              *
+ * This file is part of IfcOpenShell.                                           *
+ *                                                                              *
+ * IfcOpenShell is free software: you can redistribute it and/or modify         *
+ * it under the terms of the Lesser GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3.0 of the License, or          *
+ * (at your option) any later version.                                          *
+ *                                                                              *
+ * IfcOpenShell is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 *
+ * Lesser GNU General Public License for more details.                          *
+ *                                                                              *
+ * You should have received a copy of the Lesser GNU General Public License     *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                              *
+ ********************************************************************************/
+
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include "../ifcparse/IfcFile.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace test_utils {
+
+	// Returns an IFC4 file with the instances in its data section
+	inline std::string spf(const std::string& data_section) {
+		return
+			"ISO-10303-21;\n"
+			"HEADER;\n"
+			"FILE_DESCRIPTION(('ViewDefinition [CoordinationView]'),'2;1');\n"
+			"FILE_NAME('test.ifc','2024-01-01T00:00:00',(''),(''),'','','');\n"
+			"FILE_SCHEMA(('IFC4'));\n"
+			"ENDSEC;\n"
+			"DATA;\n" +
+			data_section +
+			"ENDSEC;\n"
+			"END-ISO-10303-21;\n";
+	}
+
+	// Parses an IFC4 file from the instances in its data section
+	inline std::unique_ptr<IfcParse::IfcFile> parse(const std::string& data_section) {
+		std::istringstream stream(spf(data_section));
+		const size_t length = stream.str().size();
+		std::unique_ptr<IfcParse::IfcFile> file(new IfcParse::IfcFile(stream, length));
+		if (!file->good()) {
+			throw IfcParse::IfcException("Unable to parse test file");
+		}
+		return file;
+	}
+
+}
+
+#endif